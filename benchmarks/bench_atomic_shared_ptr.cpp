@@ -0,0 +1,105 @@
+#include "memory/atomic_shared_ptr.h"
+#include "memory/shared_ptr.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A routing table that every request reads and that is replaced once in a while
+struct Table {
+    long entries[16];
+    explicit Table(long seed) {
+        for (int i = 0; i < 16; ++i) entries[i] = seed + i;
+    }
+};
+
+// numReaders threads do numReads reads each while one writer replaces the table every
+// writeEveryUs microseconds. Reports reads per microsecond over all readers
+template <typename Read, typename Write>
+void run(const std::string& name, int numReaders, int numReads, int writeEveryUs, Read read, Write write) {
+    std::atomic<int> ready = 0;
+    std::atomic<bool> done = false;
+    std::thread writer([&]() {
+        long seed = 1;
+        while (!done.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(writeEveryUs));
+            write(++seed);
+        }
+    });
+    std::vector<std::thread> readers;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numReaders; ++i) {
+        readers.emplace_back([&, i]() {
+            ++ready;
+            while (ready < numReaders) std::this_thread::yield();
+            long sum = 0;
+            for (int j = 0; j < numReads; ++j) sum += read(j & 15);
+            volatile long sink = sum;
+            (void)sink;
+        });
+    }
+    for (auto& t : readers) t.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    done = true;
+    writer.join();
+    double us = std::chrono::duration<double, std::micro>(end - start).count();
+    std::cout << name << ": readers=" << numReaders << ", reads/us=" << (static_cast<double>(numReaders) * numReads / us) << std::endl;
+}
+
+void benchmark(int numReaders, int numReads, int writeEveryUs) {
+    {
+        svr::atomic_shared_ptr<Table> table(svr::make_shared<Table>(0));
+        run("atomic_shared_ptr::snapshot", numReaders, numReads, writeEveryUs,
+            [&](int i) { return table.snapshot()->entries[i]; },
+            [&](long seed) { table.store(svr::make_shared<Table>(seed)); });
+        run("atomic_shared_ptr::load", numReaders, numReads, writeEveryUs,
+            [&](int i) { return table.load()->entries[i]; },
+            [&](long seed) { table.store(svr::make_shared<Table>(seed)); });
+    }
+    {
+        std::mutex mx;
+        svr::shared_ptr<Table> table = svr::make_shared<Table>(0);
+        run("mutex + svr::shared_ptr copy", numReaders, numReads, writeEveryUs,
+            [&](int i) {
+                svr::shared_ptr<Table> copy;
+                {
+                    std::lock_guard<std::mutex> lk(mx);
+                    copy = table;
+                }
+                return copy->entries[i];
+            },
+            [&](long seed) {
+                svr::shared_ptr<Table> next = svr::make_shared<Table>(seed);
+                std::lock_guard<std::mutex> lk(mx);
+                table = next;
+            });
+    }
+    {
+        std::atomic<std::shared_ptr<Table>> table(std::make_shared<Table>(0));
+        run("std::atomic<std::shared_ptr>", numReaders, numReads, writeEveryUs,
+            [&](int i) { return table.load()->entries[i]; },
+            [&](long seed) { table.store(std::make_shared<Table>(seed)); });
+    }
+}
+
+// Usage: bench_atomic_shared_ptr [reads_per_thread] [max_readers] [write_every_us]
+int main(int argc, char** argv) {
+    unsigned int max_readers = std::thread::hardware_concurrency();
+    if (max_readers == 0) max_readers = 8;
+    int numReads = 2000000;
+    int writeEveryUs = 1000;
+    if (argc > 1) numReads = std::atoi(argv[1]);
+    if (argc > 2) max_readers = std::atoi(argv[2]);
+    if (argc > 3) writeEveryUs = std::atoi(argv[3]);
+    std::cout << "Benchmarking reader scalability of published shared pointers\n";
+    for (unsigned int numReaders = 1; numReaders <= max_readers; numReaders *= 2) {
+        std::cout << "-----------------------------------------------------\n";
+        benchmark(numReaders, numReads, writeEveryUs);
+    }
+    return 0;
+}
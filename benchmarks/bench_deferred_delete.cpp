@@ -0,0 +1,50 @@
+#include "memory/deferred_delete.h"
+#include "memory/unique_ptr.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Stand-in for a parsed request: a few thousand heap nodes, torn down one by one
+struct Document {
+    std::map<int, std::string> fields;
+    explicit Document(int size) {
+        for (int i = 0; i < size; ++i) fields.emplace(i, std::string(40, 'a' + i % 26));
+    }
+};
+
+// Time only the release of each request's document, and report the tail. The reclaimer needs a
+// core of its own; on a machine with fewer cores than busy threads it preempts the caller and
+// the tail shows that instead
+template <typename Ptr>
+void benchmark(const std::string& name, int numRequests, int documentSize) {
+    std::vector<double> releaseNs;
+    releaseNs.reserve(numRequests);
+    for (int r = 0; r < numRequests; ++r) {
+        Ptr doc(new Document(documentSize));
+        auto start = std::chrono::high_resolution_clock::now();
+        doc.reset();
+        auto end = std::chrono::high_resolution_clock::now();
+        releaseNs.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    std::sort(releaseNs.begin(), releaseNs.end());
+    auto at = [&](double q) { return releaseNs[static_cast<size_t>(q * (releaseNs.size() - 1))]; };
+    std::cout << name << ": release p50 " << at(0.5) << " ns, p99 " << at(0.99) << " ns, p999 " << at(0.999)
+              << " ns, max " << releaseNs.back() << " ns" << std::endl;
+}
+
+// Usage: bench_deferred_delete [requests] [document size]
+int main(int argc, char** argv) {
+    int numRequests = 20000;
+    int documentSize = 2000;
+    if (argc > 1) numRequests = std::atoi(argv[1]);
+    if (argc > 2) documentSize = std::atoi(argv[2]);
+    std::cout << "Benchmarking release latency of a " << documentSize << " node document\n";
+    benchmark<svr::unique_ptr<Document>>("inline delete", numRequests, documentSize);
+    benchmark<svr::unique_ptr<Document, svr::deferred_delete<Document>>>("svr::deferred_delete", numRequests, documentSize);
+    svr::DeferredReclaimer::instance().drain();
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "multithreading/flat_combiner.h"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/adaptive_mutex.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+// Shared counter map: short critical sections on data that every thread touches, where
+// moving the data to each new lock holder costs more than the increment itself
+using CounterMap = std::array<uint64_t, 256>;
+
+inline void update(CounterMap& counters, uint32_t key) {
+    counters[key % counters.size()] += 1;
+    counters[(key * 7 + 3) % counters.size()] += 2;
+}
+
+// xorshift32, so the key stream does not touch shared state
+inline uint32_t next_key(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+template <typename Body>
+void run_threads(const std::string& name, int numThreads, int numIterations, Body body) {
+    std::atomic<int> ready = 0;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&, i]() {
+            ++ready;
+            while (ready < numThreads) std::this_thread::yield();
+            uint32_t state = 2463534242u + i;
+            for (int j = 0; j < numIterations; ++j) {
+                body(next_key(state));
+                // CPU work between operations
+                volatile int dummy = 0;
+                for (int k = 0; k < 50; ++k) dummy = dummy + k;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    std::cout << name << ": threads=" << numThreads << ", time=" << elapsed.count() << " ms" << std::endl;
+}
+
+template <typename LockType>
+void benchmark_locked(const std::string& name, int numThreads, int numIterations) {
+    LockType lock;
+    CounterMap counters{};
+    run_threads(name, numThreads, numIterations, [&](uint32_t key) {
+        lock.lock();
+        update(counters, key);
+        lock.unlock();
+    });
+}
+
+void benchmark_flat_combiner(int numThreads, int numIterations) {
+    FlatCombiner<CounterMap> combiner(CounterMap{});
+    run_threads("FlatCombiner", numThreads, numIterations, [&](uint32_t key) {
+        combiner.apply([key](CounterMap& counters) { update(counters, key); });
+    });
+}
+
+// Usage: bench_flat_combiner [iterations_per_thread] [max_threads]
+int main(int argc, char** argv) {
+    unsigned int max_threads = 2 * std::thread::hardware_concurrency();
+    if (max_threads == 0) max_threads = 32;
+    int numIterations = 1000000;
+    if (argc > 1) numIterations = std::atoi(argv[1]);
+    if (argc > 2) max_threads = std::atoi(argv[2]);
+    std::cout << "Benchmarking FlatCombiner against spin lock variants: shared counter map\n";
+    for (unsigned int numThreads = 1; numThreads <= max_threads; ++numThreads) {
+        std::cout << "-----------------------------------------------------\n";
+        benchmark_flat_combiner(numThreads, numIterations);
+        benchmark_locked<SpinLockWithOptimizedLoadsAndThreadYielding>("SpinLockWithOptimizedLoadsAndThreadYielding", numThreads, numIterations);
+        benchmark_locked<SpinLock<SpinThenYieldBackoff<>>>("SpinLock<SpinThenYieldBackoff>", numThreads, numIterations);
+        benchmark_locked<TicketSpinLock>("TicketSpinLock", numThreads, numIterations);
+        benchmark_locked<MCSSpinLock>("MCSSpinLock", numThreads, numIterations);
+        benchmark_locked<AdaptiveMutex>("AdaptiveMutex", numThreads, numIterations);
+        benchmark_locked<std::mutex>("std::mutex", numThreads, numIterations);
+        std::cout << "-----------------------------------------------------\n";
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include "memory/epoch.h"
+#include "memory/hazard_pointer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A read-mostly hash map of immutable chains. A lookup walks one bucket's chain; an update
+// copies the chain with one value changed, swaps it in and retires the old one. Readers never
+// block and never write shared memory apart from what the reclamation scheme needs
+struct Node {
+    long key;
+    long value;
+    Node* next;
+};
+
+struct Chain {
+    Node* head;
+    ~Chain() {
+        while (head) {
+            Node* next = head->next;
+            delete head;
+            head = next;
+        }
+    }
+};
+
+constexpr long NUM_BUCKETS = 1024;
+constexpr long CHAIN_LENGTH = 8;
+
+struct Table {
+    std::vector<std::atomic<Chain*>> buckets;
+
+    Table() : buckets(NUM_BUCKETS) {
+        for (long b = 0; b < NUM_BUCKETS; ++b) {
+            Node* head = nullptr;
+            for (long i = CHAIN_LENGTH - 1; i >= 0; --i) head = new Node{b + i * NUM_BUCKETS, 0, head};
+            buckets[b].store(new Chain{head});
+        }
+    }
+
+    ~Table() {
+        for (auto& bucket : buckets) delete bucket.load();
+    }
+
+    static long find(const Chain* chain, long key) {
+        for (const Node* n = chain->head; n; n = n->next) {
+            if (n->key == key) return n->value;
+        }
+        return -1;
+    }
+
+    // Copy of chain with key's value replaced
+    static Chain* updated(const Chain* chain, long key, long value) {
+        Node* head = nullptr;
+        Node** tail = &head;
+        for (const Node* n = chain->head; n; n = n->next) {
+            *tail = new Node{n->key, n->key == key ? value : n->value, nullptr};
+            tail = &(*tail)->next;
+        }
+        return new Chain{head};
+    }
+};
+
+struct HazardPointers {
+    svr::hazard_pointer_domain domain;
+
+    struct Reader {
+        svr::hazard_pointer hp;
+        explicit Reader(HazardPointers& scheme) : hp(scheme.domain.make_hazard_pointer()) {}
+        long lookup(Table& table, long key) {
+            const Chain* chain = hp.protect(table.buckets[key % NUM_BUCKETS]);
+            long value = Table::find(chain, key);
+            hp.reset_protection();
+            return value;
+        }
+    };
+
+    void update(Table& table, long key, long value) {
+        std::atomic<Chain*>& bucket = table.buckets[key % NUM_BUCKETS];
+        svr::hazard_pointer hp = domain.make_hazard_pointer();
+        Chain* old = hp.protect(bucket);
+        Chain* fresh = Table::updated(old, key, value);
+        while (!bucket.compare_exchange_strong(old, fresh)) {
+            delete fresh;
+            old = hp.protect(bucket);
+            fresh = Table::updated(old, key, value);
+        }
+        hp.reset_protection();
+        domain.retire(old);
+    }
+};
+
+struct Epochs {
+    svr::epoch_domain domain;
+
+    struct Reader {
+        svr::epoch_domain& domain;
+        explicit Reader(Epochs& scheme) : domain(scheme.domain) {}
+        long lookup(Table& table, long key) {
+            svr::epoch_guard guard = domain.pin();
+            return Table::find(table.buckets[key % NUM_BUCKETS].load(std::memory_order_acquire), key);
+        }
+    };
+
+    void update(Table& table, long key, long value) {
+        std::atomic<Chain*>& bucket = table.buckets[key % NUM_BUCKETS];
+        svr::epoch_guard guard = domain.pin();
+        Chain* old = bucket.load(std::memory_order_acquire);
+        Chain* fresh = Table::updated(old, key, value);
+        while (!bucket.compare_exchange_strong(old, fresh)) {
+            delete fresh;
+            fresh = Table::updated(old, key, value);
+        }
+        domain.retire(old);
+    }
+};
+
+template <typename Body>
+double time_ms(Body body) {
+    auto start = std::chrono::high_resolution_clock::now();
+    body();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// numReaders threads look up random keys while one writer updates; reports the readers' rate
+template <typename Scheme>
+void benchmark(const std::string& name, int numReaders, long lookupsPerReader) {
+    Table table;
+    Scheme scheme;
+    std::atomic<bool> done{false};
+    std::atomic<long> updates{0};
+    double ms = time_ms([&]() {
+        std::thread writer([&]() {
+            unsigned long seed = 12345;
+            while (!done.load(std::memory_order_relaxed)) {
+                seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+                long key = static_cast<long>((seed >> 33) % (NUM_BUCKETS * CHAIN_LENGTH));
+                scheme.update(table, key, key);
+                updates.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+            }
+        });
+        std::vector<std::thread> readers;
+        for (int r = 0; r < numReaders; ++r) {
+            readers.emplace_back([&, r]() {
+                typename Scheme::Reader reader(scheme);
+                unsigned long seed = r + 1;
+                long sum = 0;
+                for (long i = 0; i < lookupsPerReader; ++i) {
+                    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+                    sum += reader.lookup(table, static_cast<long>((seed >> 33) % (NUM_BUCKETS * CHAIN_LENGTH)));
+                }
+                if (sum < 0) std::cout << "missing key\n";
+            });
+        }
+        for (auto& t : readers) t.join();
+        done = true;
+        writer.join();
+    });
+    std::cout << name << ": " << numReaders << " readers " << (ms * 1e6 / lookupsPerReader) << " ns/lookup per reader, "
+              << updates.load() << " updates" << std::endl;
+}
+
+// Usage: bench_reclamation [lookups per reader]
+int main(int argc, char** argv) {
+    long lookups = 2000000;
+    if (argc > 1) lookups = std::atol(argv[1]);
+    std::cout << "Benchmarking hazard pointers against epochs on a read-mostly map\n";
+    unsigned int max_readers = std::thread::hardware_concurrency();
+    for (unsigned int readers : {1u, 2u, max_readers}) {
+        benchmark<HazardPointers>("svr::hazard_pointer", readers, lookups);
+        benchmark<Epochs>("svr::epoch", readers, lookups);
+    }
+    return 0;
+}
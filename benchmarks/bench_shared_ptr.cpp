@@ -0,0 +1,137 @@
+#include "memory/biased_shared_ptr.h"
+#include "memory/local_shared_ptr.h"
+#include "memory/pool_allocator.h"
+#include "memory/shared_ptr.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A small object, so the control block is a large share of each allocation
+struct Payload {
+    long value;
+    long pad[3];
+    explicit Payload(long v) : value(v), pad{} {}
+};
+
+template <typename Body>
+double time_ms(Body body) {
+    auto start = std::chrono::high_resolution_clock::now();
+    body();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Create and destroy numObjects shared objects, live numLive at a time
+template <typename Make>
+void benchmark_alloc(const std::string& name, int numObjects, int numLive, Make make) {
+    using Ptr = decltype(make(0));
+    std::vector<Ptr> live(numLive);
+    double ms = time_ms([&]() {
+        for (int i = 0; i < numObjects; ++i) {
+            live[i % numLive] = make(i);
+        }
+    });
+    std::cout << name << ": alloc+free " << (ms * 1e6 / numObjects) << " ns/object" << std::endl;
+}
+
+// Sum through numObjects pointers several times. Other allocations are interleaved so the
+// objects are spread over the heap like they are in a real program
+template <typename Make>
+void benchmark_deref(const std::string& name, int numObjects, int rounds, Make make) {
+    using Ptr = decltype(make(0));
+    std::vector<Ptr> ptrs;
+    std::vector<std::unique_ptr<char[]>> noise;
+    for (int i = 0; i < numObjects; ++i) {
+        ptrs.push_back(make(i));
+        noise.emplace_back(new char[48 + (i % 7) * 16]);
+    }
+    volatile long sink = 0;
+    double ms = time_ms([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            long sum = 0;
+            for (const Ptr& p : ptrs) sum += p->value;
+            sink = sink + sum;
+        }
+    });
+    std::cout << name << ": deref " << (ms * 1e6 / (static_cast<double>(numObjects) * rounds)) << " ns/object" << std::endl;
+}
+
+// Copy and destroy one pointer over and over, like graph code passing nodes around
+template <typename Make>
+void benchmark_copy(const std::string& name, int numCopies, Make make) {
+    using Ptr = decltype(make(0));
+    // Three sources, so a slot never gets the pointer it already holds (16 % 3 != 0) and
+    // every assignment really is an increment plus a decrement
+    Ptr sources[3] = {make(1), make(2), make(3)};
+    std::vector<Ptr> window(16);
+    double ms = time_ms([&]() {
+        for (int i = 0; i < numCopies; ++i) {
+            window[i & 15] = sources[i % 3];
+        }
+    });
+    std::cout << name << ": copy+destroy " << (ms * 1e6 / numCopies) << " ns/copy" << std::endl;
+}
+
+// The creating thread copies and destroys numCopies times, and numOthers more threads do the
+// same on copies of its pointers. Biased counting makes the creator's copies cheap; the
+// others pay the atomic price as usual
+template <typename Make>
+void benchmark_copy_threads(const std::string& name, int numOthers, int numCopies, Make make) {
+    using Ptr = decltype(make(0));
+    Ptr sources[3] = {make(1), make(2), make(3)};
+    auto body = [numCopies](const Ptr (&from)[3]) {
+        std::vector<Ptr> window(16);
+        for (int i = 0; i < numCopies; ++i) {
+            window[i & 15] = from[i % 3];
+        }
+    };
+    std::vector<std::thread> others;
+    double ms = time_ms([&]() {
+        for (int t = 0; t < numOthers; ++t) {
+            others.emplace_back([&, mine = std::vector<Ptr>(sources, sources + 3)]() {
+                const Ptr from[3] = {mine[0], mine[1], mine[2]};
+                body(from);
+            });
+        }
+        body(sources);
+        for (auto& t : others) t.join();
+    });
+    std::cout << name << ": copy+destroy with " << numOthers << " other threads " << (ms * 1e6 / numCopies) << " ns/copy on the creator" << std::endl;
+}
+
+template <typename Make>
+void benchmark(const std::string& name, int numObjects, Make make) {
+    benchmark_alloc(name, numObjects, 1024, make);
+    benchmark_deref(name, numObjects / 10, 10, make);
+    benchmark_copy(name, numObjects, make);
+}
+
+// Usage: bench_shared_ptr [objects]
+int main(int argc, char** argv) {
+    int numObjects = 2000000;
+    if (argc > 1) numObjects = std::atoi(argv[1]);
+    // libstdc++ skips the atomic count updates while the process has never had a second
+    // thread. Real programs have, so start one to compare like with like
+    std::thread([]() {}).join();
+    std::cout << "Benchmarking shared_ptr allocation, dereference and copy\n";
+    benchmark("svr::shared_ptr(new T)", numObjects, [](long v) { return svr::shared_ptr<Payload>(new Payload(v)); });
+    benchmark("svr::make_shared", numObjects, [](long v) { return svr::make_shared<Payload>(v); });
+    benchmark("svr::allocate_shared(PoolAllocator)", numObjects, [](long v) { return svr::allocate_shared<Payload>(svr::PoolAllocator<Payload>(), v); });
+    benchmark("svr::make_biased_shared", numObjects, [](long v) { return svr::make_biased_shared<Payload>(v); });
+    benchmark("svr::make_local_shared", numObjects, [](long v) { return svr::make_local_shared<Payload>(v); });
+    benchmark("std::shared_ptr(new T)", numObjects, [](long v) { return std::shared_ptr<Payload>(new Payload(v)); });
+    benchmark("std::make_shared", numObjects, [](long v) { return std::make_shared<Payload>(v); });
+    benchmark("std::allocate_shared(PoolAllocator)", numObjects, [](long v) { return std::allocate_shared<Payload>(svr::PoolAllocator<Payload>(), v); });
+    std::cout << "Copy and destroy on the creating thread and on other threads\n";
+    unsigned int max_others = std::thread::hardware_concurrency();
+    for (unsigned int numOthers : {0u, 1u, max_others}) {
+        benchmark_copy_threads("svr::make_shared", numOthers, numObjects, [](long v) { return svr::make_shared<Payload>(v); });
+        benchmark_copy_threads("svr::make_biased_shared", numOthers, numObjects, [](long v) { return svr::make_biased_shared<Payload>(v); });
+        benchmark_copy_threads("std::make_shared", numOthers, numObjects, [](long v) { return std::make_shared<Payload>(v); });
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "memory/slab_allocator.h"
+#include "multithreading/spsc/spscbounded.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+template <typename Body>
+double time_ms(Body body) {
+    auto start = std::chrono::high_resolution_clock::now();
+    body();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+struct Malloc {
+    static void* allocate(size_t bytes) { return std::malloc(bytes); }
+    static void deallocate(void* ptr, size_t) { std::free(ptr); }
+};
+
+struct Slab {
+    static void* allocate(size_t bytes) { return svr::SlabHeap::allocate(bytes); }
+    static void deallocate(void* ptr, size_t bytes) { svr::SlabHeap::deallocate(ptr, bytes); }
+};
+
+// Allocate and free on one thread, numLive blocks alive at a time
+template <typename Heap>
+void benchmark_local(const std::string& name, int numOps, size_t bytes, int numLive) {
+    std::vector<void*> live(numLive, nullptr);
+    double ms = time_ms([&]() {
+        for (int i = 0; i < numOps; ++i) {
+            void*& slot = live[i % numLive];
+            if (slot) Heap::deallocate(slot, bytes);
+            slot = Heap::allocate(bytes);
+            static_cast<char*>(slot)[0] = 1;
+        }
+    });
+    for (void* p : live) Heap::deallocate(p, bytes);
+    std::cout << name << ": " << bytes << " bytes, same thread " << (ms * 1e6 / numOps) << " ns/alloc+free" << std::endl;
+}
+
+// The producer allocates a message, the consumer frees it after an SpscBounded hop. Every
+// block crosses threads, which is the worst case for thread caches that only take frees back
+// on the thread that allocated. Waiting threads yield, so the numbers mean something on a
+// machine with fewer cores than threads
+template <typename Heap>
+void benchmark_producer_consumer(const std::string& name, int numOps, size_t bytes) {
+    svr::SpscBounded<void*, 1024> queue;
+    double ms = time_ms([&]() {
+        std::thread consumer([&]() {
+            void* ptr = nullptr;
+            for (int i = 0; i < numOps; ++i) {
+                while (!queue.try_pop(ptr)) std::this_thread::yield();
+                Heap::deallocate(ptr, bytes);
+            }
+        });
+        for (int i = 0; i < numOps; ++i) {
+            void* ptr = Heap::allocate(bytes);
+            static_cast<char*>(ptr)[0] = 1;
+            while (!queue.try_push(ptr)) std::this_thread::yield();
+        }
+        consumer.join();
+    });
+    std::cout << name << ": " << bytes << " bytes, producer->consumer " << (ms * 1e6 / numOps) << " ns/message" << std::endl;
+}
+
+// Usage: bench_slab_allocator [operations]
+int main(int argc, char** argv) {
+    int numOps = 5000000;
+    if (argc > 1) numOps = std::atoi(argv[1]);
+    // glibc's thread caches behave differently in a process that has never had a second thread
+    std::thread([]() {}).join();
+    std::cout << "Benchmarking slab allocator against malloc\n";
+    for (size_t bytes : {32, 200, 1500}) {
+        benchmark_local<Malloc>("malloc", numOps, bytes, 1024);
+        benchmark_local<Slab>("svr::SlabHeap", numOps, bytes, 1024);
+        benchmark_producer_consumer<Malloc>("malloc", numOps, bytes);
+        benchmark_producer_consumer<Slab>("svr::SlabHeap", numOps, bytes);
+    }
+    return 0;
+}
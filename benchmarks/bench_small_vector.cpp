@@ -0,0 +1,61 @@
+#define SVR_DEFINE_ALLOCATION_HOOKS
+#include "containers/inplace_vector.h"
+#include "containers/small_vector.h"
+#include "helpers/allocation_tracker.h"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace svr;
+
+template <typename Body>
+double time_ms(Body body) {
+    auto start = std::chrono::high_resolution_clock::now();
+    body();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+struct Item { uint64_t id; uint64_t qty; };
+
+// Per-task scratch list sizes: mostly a handful, occasionally large
+std::vector<int> make_sizes(int numTasks) {
+    std::mt19937 rng(42);
+    std::vector<int> sizes(numTasks);
+    for (int& size : sizes) size = (rng() % 100 == 0) ? 64 + static_cast<int>(rng() % 64) : 1 + static_cast<int>(rng() % 8);
+    return sizes;
+}
+
+// One fresh list per task, as a worker loop builds it
+template <typename List>
+void benchmark(const std::string& name, const std::vector<int>& sizes) {
+    uint64_t sum = 0;
+    AllocationStats before = allocation_stats();
+    double ms = time_ms([&]() {
+        for (int size : sizes) {
+            List items;
+            for (int i = 0; i < size; ++i) items.push_back(Item{static_cast<uint64_t>(i), 1});
+            for (const Item& item : items) sum += item.id + item.qty;
+        }
+    });
+    uint64_t allocations = (allocation_stats() - before).allocations;
+    std::cout << name << ": " << sizeof(List) << " bytes, " << (ms * 1e6 / sizes.size()) << " ns/task, "
+              << (static_cast<double>(allocations) / sizes.size()) << " allocations/task (checksum " << sum << ")"
+              << std::endl;
+}
+
+// Usage: bench_small_vector [tasks]
+int main(int argc, char** argv) {
+    int numTasks = 1 << 20;
+    if (argc > 1) numTasks = std::atoi(argv[1]);
+    std::vector<int> sizes = make_sizes(numTasks);
+    std::cout << "Building " << numTasks << " scratch lists, 1% of them 64+ items\n";
+    benchmark<std::vector<Item>>("std::vector", sizes);
+    benchmark<small_vector<Item, 8>>("svr::small_vector<8>", sizes);
+    benchmark<small_vector<Item, 16>>("svr::small_vector<16>", sizes);
+    benchmark<inplace_vector<Item, 128>>("svr::inplace_vector<128>", sizes);
+    return 0;
+}
@@ -1,25 +1,47 @@
+#define SVR_DEFINE_ALLOCATION_HOOKS
+#include "helpers/allocation_tracker.h"
 #include "multithreading/spinlock/spinlock.h"
+#include "multithreading/adaptive_mutex.h"
+#include "multithreading/spinlock/rw_spinlock.h"
+#include "multithreading/profiled_lock.h"
+#include "multithreading/spinlock/cohort_lock.h"
+#include "multithreading/numa.h"
 #include <thread>
 #include <vector>
 #include <iostream>
 #include <chrono>
 #include <string>
 #include <mutex>
+#include <shared_mutex>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 
 using namespace svr;
 
+// Thread i goes to node i % nodes, so consecutive threads alternate between sockets and a
+// lock that hands off at random crosses the interconnect as often as it can
+void pin_thread(int index) {
+    const NumaTopology& topology = NumaTopology::instance();
+    const auto& cpus = topology.cpusOfNode(index % topology.numNodes());
+    NumaTopology::pinCurrentThread(cpus[(index / topology.numNodes()) % cpus.size()]);
+}
+
 template <typename SpinLockType>
-void benchmark_spinlock(const std::string& name, int numThreads, int numIterations) {
+void benchmark_spinlock(const std::string& name, int numThreads, int numIterations, bool pinned = false) {
     SpinLockType lock;
     std::atomic<int> ready = 0;
     std::atomic<int> finished{0};
+    std::atomic<uint64_t> allocations{0};
     std::vector<std::thread> threads;
     auto start = std::chrono::high_resolution_clock::now();
     for (int i = 0; i < numThreads; ++i) {
-        threads.emplace_back([&]() {
+        threads.emplace_back([&, i]() {
+            if (pinned) pin_thread(i);
             // Wait for all threads to be ready
             ++ready;
             while (ready < numThreads) std::this_thread::yield();
+            AllocationStats before = allocation_stats();
             for (int j = 0; j < numIterations; ++j) {
                 // CPU work before lock
                 volatile int dummy1 = 0;
@@ -37,33 +59,185 @@ void benchmark_spinlock(const std::string& name, int numThreads, int numIteratio
                 volatile int dummy3 = 0;
                 for (int k = 0; k < 50; ++k) dummy3 += k - j;
             }
+            allocations += (allocation_stats() - before).allocations;
             ++finished;
         });
     }
     for (auto& t : threads) t.join();
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> elapsed = end - start;
-    std::cout << name << ": threads=" << numThreads << ", time=" << elapsed.count() << " ms" << std::endl;
+    std::cout << name << ": threads=" << numThreads << (pinned ? ", pinned" : "") << ", time=" << elapsed.count() << " ms"
+              << ", allocs/op=" << static_cast<double>(allocations) / (static_cast<double>(numThreads) * numIterations) << std::endl;
+}
+
+// Fixed-duration run where every thread grabs the lock as often as it can. Total time hides
+// starvation, so report how the acquisitions were spread over threads as well.
+// jain = (sum x)^2 / (n * sum x^2): 1.0 means perfectly even, 1/n means one thread got everything
+template <typename SpinLockType>
+void benchmark_fairness(const std::string& name, int numThreads, std::chrono::milliseconds duration) {
+    SpinLockType lock;
+    std::atomic<int> ready = 0;
+    std::atomic<bool> stop{false};
+    std::vector<long long> counts(numThreads, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&, i]() {
+            ++ready;
+            while (ready < numThreads) std::this_thread::yield();
+            long long acquired = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                lock.lock();
+                volatile int dummy = 0;
+                for (int k = 0; k < 10; ++k) dummy = dummy + k;
+                lock.unlock();
+                ++acquired;
+            }
+            counts[i] = acquired;
+        });
+    }
+    while (ready < numThreads) std::this_thread::yield();
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& t : threads) t.join();
+    long long total = 0;
+    double sumSquares = 0;
+    for (long long c : counts) {
+        total += c;
+        sumSquares += static_cast<double>(c) * c;
+    }
+    double jain = sumSquares == 0 ? 1.0 : static_cast<double>(total) * total / (numThreads * sumSquares);
+    std::cout << name << ": threads=" << numThreads << ", acquisitions=" << total
+              << ", min=" << *std::min_element(counts.begin(), counts.end())
+              << ", max=" << *std::max_element(counts.begin(), counts.end())
+              << ", jain=" << jain << std::endl;
 }
 
-int main() {
+// Read/write mix: every writeEvery-th operation takes the lock exclusively and the rest only
+// read. Locks without lock_shared() take every operation exclusively, which is what read-mostly
+// data guarded by a plain spin lock pays today
+template <typename LockType>
+void benchmark_read_write(const std::string& name, int numThreads, int numIterations, int writeEvery) {
+    LockType lock;
+    std::atomic<int> ready = 0;
+    long long shared[8] = {};
+    std::atomic<uint64_t> allocations{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&, i]() {
+            ++ready;
+            while (ready < numThreads) std::this_thread::yield();
+            AllocationStats before = allocation_stats();
+            volatile long long sink = 0;
+            for (int j = 0; j < numIterations; ++j) {
+                if ((j + i) % writeEvery == 0) {
+                    lock.lock();
+                    for (auto& v : shared) ++v;
+                    lock.unlock();
+                } else {
+                    if constexpr (requires { lock.lock_shared(); }) {
+                        lock.lock_shared();
+                        for (auto v : shared) sink = sink + v;
+                        lock.unlock_shared();
+                    } else {
+                        lock.lock();
+                        for (auto v : shared) sink = sink + v;
+                        lock.unlock();
+                    }
+                }
+            }
+            allocations += (allocation_stats() - before).allocations;
+        });
+    }
+    for (auto& t : threads) t.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    std::cout << name << ": threads=" << numThreads << ", write_every=" << writeEvery << ", time=" << elapsed.count() << " ms"
+              << ", allocs/op=" << static_cast<double>(allocations) / (static_cast<double>(numThreads) * numIterations) << std::endl;
+}
+
+void run_latency(int numThreads, int numIterations) {
+    benchmark_spinlock<BasicSpinLockWithAtomicFlag>("BasicSpinLockWithAtomicFlag", numThreads, numIterations);
+    benchmark_spinlock<BasicSpinLockWithAtomicBool>("BasicSpinLockWithAtomicBool", numThreads, numIterations);
+    benchmark_spinlock<SpinLockWithAtomicFlagWithoutFalseSharing>("SpinLockWithAtomicFlagWithoutFalseSharing", numThreads, numIterations);
+    benchmark_spinlock<SpinLockWithAtomicBoolWithoutFalseSharing>("SpinLockWithAtomicBoolWithoutFalseSharing", numThreads, numIterations);
+    benchmark_spinlock<SpinLockWithOptimizedLoadsAndThreadYielding>("SpinLockWithOptimizedLoadsAndThreadYielding", numThreads, numIterations);
+    benchmark_spinlock<SpinLockWithOptimizedWritesAndThreadYielding>("SpinLockWithOptimizedWritesAndThreadYielding", numThreads, numIterations);
+    benchmark_spinlock<SpinLock<PauseBackoff>>("SpinLock<PauseBackoff>", numThreads, numIterations);
+    benchmark_spinlock<SpinLock<ExponentialBackoff<>>>("SpinLock<ExponentialBackoff>", numThreads, numIterations);
+    benchmark_spinlock<SpinLock<SpinThenYieldBackoff<>>>("SpinLock<SpinThenYieldBackoff>", numThreads, numIterations);
+    benchmark_spinlock<TicketSpinLock>("TicketSpinLock", numThreads, numIterations);
+    benchmark_spinlock<MCSSpinLock>("MCSSpinLock", numThreads, numIterations);
+    benchmark_spinlock<CLHSpinLock>("CLHSpinLock", numThreads, numIterations);
+    benchmark_spinlock<CohortLock<>>("CohortLock", numThreads, numIterations);
+    benchmark_spinlock<AdaptiveMutex>("AdaptiveMutex", numThreads, numIterations);
+    benchmark_spinlock<std::mutex>("std::mutex", numThreads, numIterations);
+    // Profiling overhead, compare with the unwrapped rows above
+    benchmark_spinlock<ProfiledLock<SpinLock<SpinThenYieldBackoff<>>>>("ProfiledLock<SpinLock<SpinThenYieldBackoff>>", numThreads, numIterations);
+    benchmark_spinlock<ProfiledLock<std::mutex>>("ProfiledLock<std::mutex>", numThreads, numIterations);
+}
+
+void run_fairness(int numThreads, std::chrono::milliseconds duration) {
+    benchmark_fairness<SpinLockWithOptimizedLoadsAndThreadYielding>("SpinLockWithOptimizedLoadsAndThreadYielding", numThreads, duration);
+    benchmark_fairness<SpinLockWithOptimizedWritesAndThreadYielding>("SpinLockWithOptimizedWritesAndThreadYielding", numThreads, duration);
+    benchmark_fairness<TicketSpinLock>("TicketSpinLock", numThreads, duration);
+    benchmark_fairness<MCSSpinLock>("MCSSpinLock", numThreads, duration);
+    benchmark_fairness<CLHSpinLock>("CLHSpinLock", numThreads, duration);
+    benchmark_fairness<AdaptiveMutex>("AdaptiveMutex", numThreads, duration);
+    benchmark_fairness<std::mutex>("std::mutex", numThreads, duration);
+}
+
+void run_pinned(int numThreads, int numIterations) {
+    benchmark_spinlock<SpinLock<SpinThenYieldBackoff<>>>("SpinLock<SpinThenYieldBackoff>", numThreads, numIterations, true);
+    benchmark_spinlock<TicketSpinLock>("TicketSpinLock", numThreads, numIterations, true);
+    benchmark_spinlock<MCSSpinLock>("MCSSpinLock", numThreads, numIterations, true);
+    benchmark_spinlock<CohortLock<>>("CohortLock", numThreads, numIterations, true);
+    benchmark_spinlock<std::mutex>("std::mutex", numThreads, numIterations, true);
+}
+
+void run_read_write(int numThreads, int numIterations, int writeEvery) {
+    benchmark_read_write<SpinLockWithOptimizedLoadsAndThreadYielding>("SpinLockWithOptimizedLoadsAndThreadYielding", numThreads, numIterations, writeEvery);
+    benchmark_read_write<RWSpinLock>("RWSpinLock", numThreads, numIterations, writeEvery);
+    benchmark_read_write<DistributedRWSpinLock<>>("DistributedRWSpinLock", numThreads, numIterations, writeEvery);
+    benchmark_read_write<std::shared_mutex>("std::shared_mutex", numThreads, numIterations, writeEvery);
+}
+
+// Usage: bench_spin_lock_variants [iterations_per_thread] [max_threads]
+int main(int argc, char** argv) {
     unsigned int max_threads = 2 * std::thread::hardware_concurrency();
     if (max_threads == 0) max_threads = 32; // fallback if detection fails
+    int numIterations = 1000000;
+    if (argc > 1) numIterations = std::atoi(argv[1]);
+    if (argc > 2) max_threads = std::atoi(argv[2]);
     std::vector<int> thread_counts;
     for (unsigned int i = 1; i <= max_threads; ++i) thread_counts.push_back(i);
-    int numIterations = 1000000;
     std::cout << "Benchmarking SpinLock variants: lock/unlock latency\n";
     std::cout << "Detected hardware threads: " << max_threads << "\n";
     std::cout << "threads,time_ms,variant\n"; // CSV header for plotting
     for (int numThreads : thread_counts) {
         std::cout << "-----------------------------------------------------\n";
-        benchmark_spinlock<BasicSpinLockWithAtomicFlag>("BasicSpinLockWithAtomicFlag", numThreads, numIterations);
-        benchmark_spinlock<BasicSpinLockWithAtomicBool>("BasicSpinLockWithAtomicBool", numThreads, numIterations);
-        benchmark_spinlock<SpinLockWithAtomicFlagWithoutFalseSharing>("SpinLockWithAtomicFlagWithoutFalseSharing", numThreads, numIterations);
-        benchmark_spinlock<SpinLockWithAtomicBoolWithoutFalseSharing>("SpinLockWithAtomicBoolWithoutFalseSharing", numThreads, numIterations);
-        benchmark_spinlock<SpinLockWithOptimizedLoadsAndThreadYielding>("SpinLockWithOptimizedLoadsAndThreadYielding", numThreads, numIterations);
-        benchmark_spinlock<SpinLockWithOptimizedWritesAndThreadYielding>("SpinLockWithOptimizedWritesAndThreadYielding", numThreads, numIterations);
-        benchmark_spinlock<std::mutex>("std::mutex", numThreads, numIterations);
+        run_latency(numThreads, numIterations);
+        std::cout << "-----------------------------------------------------\n";
+    }
+    std::cout << "Benchmarking SpinLock variants: threads pinned round-robin over " << NumaTopology::instance().numNodes() << " NUMA node(s)\n";
+    for (int numThreads : thread_counts) {
+        if (numThreads > static_cast<int>(std::thread::hardware_concurrency())) break;
+        std::cout << "-----------------------------------------------------\n";
+        run_pinned(numThreads, numIterations);
+        std::cout << "-----------------------------------------------------\n";
+    }
+    std::cout << "Benchmarking SpinLock variants: read/write ratio\n";
+    for (int numThreads : thread_counts) {
+        std::cout << "-----------------------------------------------------\n";
+        for (int writeEvery : {1000, 100, 10, 2}) {
+            run_read_write(numThreads, numIterations, writeEvery);
+        }
+        std::cout << "-----------------------------------------------------\n";
+    }
+    std::cout << "Benchmarking SpinLock variants: fairness over a fixed duration\n";
+    for (int numThreads : thread_counts) {
+        std::cout << "-----------------------------------------------------\n";
+        run_fairness(numThreads, std::chrono::milliseconds(200));
         std::cout << "-----------------------------------------------------\n";
     }
     return 0;
@@ -1,3 +1,5 @@
+#define SVR_DEFINE_ALLOCATION_HOOKS
+#include "helpers/allocation_tracker.h"
 #include "multithreading/spsc/spscbounded.h"
 #include <thread>
 #include <vector>
@@ -9,18 +11,27 @@
 
 using namespace svr;
 
+// Allocations made by both threads while pushing and popping, per item
+void report_allocations(uint64_t allocations, int num_items) {
+    std::cout << "Allocations: " << allocations << " (" << static_cast<double>(allocations) / num_items << " per op)" << std::endl;
+}
+
 template <typename QueueType>
 void benchmark_spsc(const std::string& name, int num_items) {
     QueueType q;
     std::vector<int> results;
     results.reserve(num_items);
+    std::atomic<uint64_t> allocations{0};
     auto start = std::chrono::high_resolution_clock::now();
     std::thread producer([&]() {
+        AllocationStats before = allocation_stats();
         for (int i = 0; i < num_items; ++i) {
             while (!q.try_push(i)) {}
         }
+        allocations += (allocation_stats() - before).allocations;
     });
     std::thread consumer([&]() {
+        AllocationStats before = allocation_stats();
         int val;
         int count = 0;
         while (count < num_items) {
@@ -29,6 +40,7 @@ void benchmark_spsc(const std::string& name, int num_items) {
                 ++count;
             }
         }
+        allocations += (allocation_stats() - before).allocations;
     });
     producer.join();
     consumer.join();
@@ -44,6 +56,7 @@ void benchmark_spsc(const std::string& name, int num_items) {
         std::cout << ops_per_ms;
     }
     std::cout << std::endl;
+    report_allocations(allocations, num_items);
     // Optionally check correctness
     bool ok = true;
     for (int i = 0; i < num_items; ++i) {
@@ -58,13 +71,17 @@ void benchmark_spsc_rigtorp(const std::string& name, int num_items) {
     rigtorp::SPSCQueue<T> q(N);
     std::vector<int> results;
     results.reserve(num_items);
+    std::atomic<uint64_t> allocations{0};
     auto start = std::chrono::high_resolution_clock::now();
     std::thread producer([&]() {
+        AllocationStats before = allocation_stats();
         for (int i = 0; i < num_items; ++i) {
             while (!q.try_push(i)) {}
         }
+        allocations += (allocation_stats() - before).allocations;
     });
     std::thread consumer([&]() {
+        AllocationStats before = allocation_stats();
         int count = 0;
         while (count < num_items) {
             auto* front = q.front();
@@ -74,6 +91,7 @@ void benchmark_spsc_rigtorp(const std::string& name, int num_items) {
                 ++count;
             }
         }
+        allocations += (allocation_stats() - before).allocations;
     });
     producer.join();
     consumer.join();
@@ -89,6 +107,7 @@ void benchmark_spsc_rigtorp(const std::string& name, int num_items) {
         std::cout << ops_per_ms;
     }
     std::cout << std::endl;
+    report_allocations(allocations, num_items);
     // Optionally check correctness
     bool ok = true;
     for (int i = 0; i < num_items; ++i) {
@@ -0,0 +1,123 @@
+#include "templates/overloads.h"
+#include "templates/variant.h"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+
+template <typename Body>
+double time_ms(Body body) {
+    auto start = std::chrono::high_resolution_clock::now();
+    body();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+struct Ping { uint64_t seq; };
+struct Order { uint64_t qty; uint64_t price; };
+struct Cancel { uint64_t id; };
+struct Fill { uint64_t id; uint64_t qty; };
+
+// The same four messages as a class hierarchy, one heap object each
+struct Message {
+    virtual ~Message() = default;
+    virtual uint64_t handle() const = 0;
+};
+struct PingMessage : Message {
+    Ping d;
+    explicit PingMessage(Ping p) : d(p) {}
+    uint64_t handle() const override { return d.seq; }
+};
+struct OrderMessage : Message {
+    Order d;
+    explicit OrderMessage(Order o) : d(o) {}
+    uint64_t handle() const override { return d.qty * d.price; }
+};
+struct CancelMessage : Message {
+    Cancel d;
+    explicit CancelMessage(Cancel c) : d(c) {}
+    uint64_t handle() const override { return d.id + 1; }
+};
+struct FillMessage : Message {
+    Fill d;
+    explicit FillMessage(Fill f) : d(f) {}
+    uint64_t handle() const override { return d.id ^ d.qty; }
+};
+
+const auto handler = svr::overloads{
+    [](const Ping& p) -> uint64_t { return p.seq; },
+    [](const Order& o) -> uint64_t { return o.qty * o.price; },
+    [](const Cancel& c) -> uint64_t { return c.id + 1; },
+    [](const Fill& f) -> uint64_t { return f.id ^ f.qty; },
+};
+
+// Message kinds in random order, so the branch predictor cannot learn the dispatch target
+std::vector<int> make_kinds(int numMessages) {
+    std::mt19937 rng(42);
+    std::vector<int> kinds(numMessages);
+    for (int& kind : kinds) kind = static_cast<int>(rng() % 4);
+    return kinds;
+}
+
+template <typename Variant, typename Visit>
+void benchmark_variant(const std::string& name, const std::vector<int>& kinds, int rounds, Visit visit) {
+    std::vector<Variant> messages;
+    messages.reserve(kinds.size());
+    for (size_t i = 0; i < kinds.size(); ++i) {
+        switch (kinds[i]) {
+            case 0: messages.emplace_back(Ping{i}); break;
+            case 1: messages.emplace_back(Order{i, 3}); break;
+            case 2: messages.emplace_back(Cancel{i}); break;
+            default: messages.emplace_back(Fill{i, 7}); break;
+        }
+    }
+    uint64_t sum = 0;
+    double ms = time_ms([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (const Variant& message : messages) sum += visit(message);
+        }
+    });
+    std::cout << name << ": " << sizeof(Variant) << " bytes/message, " << (ms * 1e6 / (rounds * messages.size()))
+              << " ns/dispatch (checksum " << sum << ")" << std::endl;
+}
+
+void benchmark_virtual(const std::vector<int>& kinds, int rounds) {
+    std::vector<std::unique_ptr<Message>> messages;
+    messages.reserve(kinds.size());
+    for (size_t i = 0; i < kinds.size(); ++i) {
+        switch (kinds[i]) {
+            case 0: messages.push_back(std::make_unique<PingMessage>(Ping{i})); break;
+            case 1: messages.push_back(std::make_unique<OrderMessage>(Order{i, 3})); break;
+            case 2: messages.push_back(std::make_unique<CancelMessage>(Cancel{i})); break;
+            default: messages.push_back(std::make_unique<FillMessage>(Fill{i, 7})); break;
+        }
+    }
+    uint64_t sum = 0;
+    double ms = time_ms([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& message : messages) sum += message->handle();
+        }
+    });
+    std::cout << "unique_ptr<Message> virtual: " << sizeof(void*) << " bytes/message + heap object, "
+              << (ms * 1e6 / (rounds * messages.size())) << " ns/dispatch (checksum " << sum << ")" << std::endl;
+}
+
+// Usage: bench_variant [messages] [rounds]
+int main(int argc, char** argv) {
+    int numMessages = 1 << 16;
+    int rounds = 100;
+    if (argc > 1) numMessages = std::atoi(argv[1]);
+    if (argc > 2) rounds = std::atoi(argv[2]);
+    std::vector<int> kinds = make_kinds(numMessages);
+    std::cout << "Dispatching " << numMessages << " messages of 4 kinds, " << rounds << " rounds\n";
+    benchmark_variant<svr::variant<Ping, Order, Cancel, Fill>>("svr::variant + svr::visit", kinds, rounds,
+        [](const auto& m) { return svr::visit(handler, m); });
+    benchmark_variant<std::variant<Ping, Order, Cancel, Fill>>("std::variant + std::visit", kinds, rounds,
+        [](const auto& m) { return std::visit(handler, m); });
+    benchmark_virtual(kinds, rounds);
+    return 0;
+}
@@ -0,0 +1,442 @@
+#ifndef SVR_INPLACE_VECTOR
+#define SVR_INPLACE_VECTOR
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include "templates/forward.h"
+#include "templates/is_trivially_relocatable.h"
+#include "templates/move.h"
+
+/**
+ Vector with a fixed capacity of N elements stored inside the object, like C++26's
+ std::inplace_vector. It never allocates, so it fits on the stack, in a message or in a queue
+ slot, and its size is known at compile time.
+
+ a) push_back/emplace_back throw std::bad_alloc when full, as the standard one does; the
+ try_ variants return nullptr instead and leave the argument untouched, which is what a hot
+ path that cannot afford exceptions wants
+ b) The size counter is the smallest unsigned type that holds N, next to the storage
+ c) Special members are conditionally trivial: an inplace_vector of trivially copyable T is
+ itself trivially copyable (the whole buffer is copied) and trivially destructible
+ d) insert and erase shift elements with memmove when T is trivially relocatable, otherwise
+ with moves
+ */
+namespace svr
+{
+    template<typename T, size_t N>
+    class inplace_vector
+    {
+        using size_type_t = std::conditional_t<(N <= UINT8_MAX), uint8_t,
+                            std::conditional_t<(N <= UINT16_MAX), uint16_t,
+                            std::conditional_t<(N <= UINT32_MAX), uint32_t, size_t>>>;
+
+        static constexpr bool TRIVIAL = std::is_trivially_copyable_v<T>;
+
+        public:
+            using value_type = T;
+            using size_type = size_t;
+            using difference_type = std::ptrdiff_t;
+            using reference = T&;
+            using const_reference = const T&;
+            using pointer = T*;
+            using const_pointer = const T*;
+            using iterator = T*;
+            using const_iterator = const T*;
+
+        private:
+            alignas(T) unsigned char d_storage[N ? N * sizeof(T) : 1];
+            size_type_t d_size{0};
+
+            T* slot(size_t index)
+            {
+                return std::launder(reinterpret_cast<T*>(d_storage)) + index;
+            }
+
+            const T* slot(size_t index) const
+            {
+                return std::launder(reinterpret_cast<const T*>(d_storage)) + index;
+            }
+
+            // Open a gap of count elements at index by shifting the tail up. The gap is raw
+            // memory afterwards
+            void openGap(size_t index, size_t count)
+            {
+                T* base = slot(0);
+                if constexpr(is_trivially_relocatable_v<T>)
+                {
+                    std::memmove(static_cast<void*>(base + index + count), static_cast<void*>(base + index), (d_size - index) * sizeof(T));
+                }
+                else
+                {
+                    for(size_t i = d_size; i > index; --i)
+                    {
+                        ::new(static_cast<void*>(base + i - 1 + count)) T(svr::move(base[i - 1]));
+                        base[i - 1].~T();
+                    }
+                }
+            }
+
+        public:
+            inplace_vector() = default;
+
+            explicit inplace_vector(size_t count) requires std::is_default_constructible_v<T>
+            {
+                resize(count);
+            }
+
+            inplace_vector(size_t count, const T& value)
+            {
+                resize(count, value);
+            }
+
+            inplace_vector(std::initializer_list<T> values)
+            {
+                if(values.size() > N)
+                {
+                    throw std::bad_alloc();
+                }
+                for(const T& value : values)
+                {
+                    unchecked_emplace_back(value);
+                }
+            }
+
+            template<typename It>
+                requires (!std::is_integral_v<It>)
+            inplace_vector(It first, It last)
+            {
+                for(; first != last; ++first)
+                {
+                    emplace_back(*first);
+                }
+            }
+
+            inplace_vector(const inplace_vector&) requires TRIVIAL = default;
+
+            inplace_vector(const inplace_vector& other) requires (!TRIVIAL)
+            {
+                std::uninitialized_copy(other.begin(), other.end(), slot(0));
+                d_size = other.d_size;
+            }
+
+            inplace_vector(inplace_vector&&) requires TRIVIAL = default;
+
+            inplace_vector(inplace_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) requires (!TRIVIAL)
+            {
+                std::uninitialized_move(other.begin(), other.end(), slot(0));
+                d_size = other.d_size;
+            }
+
+            ~inplace_vector() requires std::is_trivially_destructible_v<T> = default;
+
+            ~inplace_vector() requires (!std::is_trivially_destructible_v<T>)
+            {
+                clear();
+            }
+
+            inplace_vector& operator=(const inplace_vector&) requires TRIVIAL = default;
+
+            inplace_vector& operator=(const inplace_vector& other) requires (!TRIVIAL)
+            {
+                if(this != &other)
+                {
+                    clear();
+                    std::uninitialized_copy(other.begin(), other.end(), slot(0));
+                    d_size = other.d_size;
+                }
+                return *this;
+            }
+
+            inplace_vector& operator=(inplace_vector&&) requires TRIVIAL = default;
+
+            inplace_vector& operator=(inplace_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) requires (!TRIVIAL)
+            {
+                if(this != &other)
+                {
+                    clear();
+                    std::uninitialized_move(other.begin(), other.end(), slot(0));
+                    d_size = other.d_size;
+                }
+                return *this;
+            }
+
+            static constexpr size_t capacity() noexcept
+            {
+                return N;
+            }
+
+            static constexpr size_t max_size() noexcept
+            {
+                return N;
+            }
+
+            size_t size() const noexcept
+            {
+                return d_size;
+            }
+
+            bool empty() const noexcept
+            {
+                return d_size == 0;
+            }
+
+            bool full() const noexcept
+            {
+                return d_size == N;
+            }
+
+            T* data() noexcept
+            {
+                return slot(0);
+            }
+
+            const T* data() const noexcept
+            {
+                return slot(0);
+            }
+
+            iterator begin() noexcept
+            {
+                return slot(0);
+            }
+
+            iterator end() noexcept
+            {
+                return slot(d_size);
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return slot(0);
+            }
+
+            const_iterator end() const noexcept
+            {
+                return slot(d_size);
+            }
+
+            T& operator[](size_t index)
+            {
+                return *slot(index);
+            }
+
+            const T& operator[](size_t index) const
+            {
+                return *slot(index);
+            }
+
+            T& at(size_t index)
+            {
+                if(index >= d_size)
+                {
+                    throw std::out_of_range("svr::inplace_vector::at");
+                }
+                return *slot(index);
+            }
+
+            const T& at(size_t index) const
+            {
+                if(index >= d_size)
+                {
+                    throw std::out_of_range("svr::inplace_vector::at");
+                }
+                return *slot(index);
+            }
+
+            T& front()
+            {
+                return *slot(0);
+            }
+
+            const T& front() const
+            {
+                return *slot(0);
+            }
+
+            T& back()
+            {
+                return *slot(d_size - 1);
+            }
+
+            const T& back() const
+            {
+                return *slot(d_size - 1);
+            }
+
+            // Caller guarantees !full()
+            template<typename... Args>
+            T& unchecked_emplace_back(Args&&... args)
+            {
+                T* ptr = ::new(static_cast<void*>(slot(d_size))) T(svr::forward<Args>(args)...);
+                ++d_size;
+                return *ptr;
+            }
+
+            // nullptr when full, and args are not touched
+            template<typename... Args>
+            T* try_emplace_back(Args&&... args)
+            {
+                if(d_size == N) [[unlikely]]
+                {
+                    return nullptr;
+                }
+                return &unchecked_emplace_back(svr::forward<Args>(args)...);
+            }
+
+            T* try_push_back(const T& value)
+            {
+                return try_emplace_back(value);
+            }
+
+            T* try_push_back(T&& value)
+            {
+                return try_emplace_back(svr::move(value));
+            }
+
+            template<typename... Args>
+            T& emplace_back(Args&&... args)
+            {
+                if(d_size == N) [[unlikely]]
+                {
+                    throw std::bad_alloc();
+                }
+                return unchecked_emplace_back(svr::forward<Args>(args)...);
+            }
+
+            void push_back(const T& value)
+            {
+                emplace_back(value);
+            }
+
+            void push_back(T&& value)
+            {
+                emplace_back(svr::move(value));
+            }
+
+            void pop_back()
+            {
+                --d_size;
+                slot(d_size)->~T();
+            }
+
+            void clear() noexcept
+            {
+                std::destroy(begin(), end());
+                d_size = 0;
+            }
+
+            void resize(size_t count) requires std::is_default_constructible_v<T>
+            {
+                if(count > N)
+                {
+                    throw std::bad_alloc();
+                }
+                while(d_size > count)
+                {
+                    pop_back();
+                }
+                while(d_size < count)
+                {
+                    unchecked_emplace_back();
+                }
+            }
+
+            void resize(size_t count, const T& value)
+            {
+                if(count > N)
+                {
+                    throw std::bad_alloc();
+                }
+                while(d_size > count)
+                {
+                    pop_back();
+                }
+                while(d_size < count)
+                {
+                    unchecked_emplace_back(value);
+                }
+            }
+
+            template<typename... Args>
+            iterator emplace(const_iterator pos, Args&&... args)
+            {
+                const size_t index = static_cast<size_t>(pos - begin());
+                if(d_size == N)
+                {
+                    throw std::bad_alloc();
+                }
+                // Build first: args may refer to an element that is about to move
+                T value(svr::forward<Args>(args)...);
+                openGap(index, 1);
+                ::new(static_cast<void*>(slot(index))) T(svr::move(value));
+                ++d_size;
+                return slot(index);
+            }
+
+            iterator insert(const_iterator pos, const T& value)
+            {
+                return emplace(pos, value);
+            }
+
+            iterator insert(const_iterator pos, T&& value)
+            {
+                return emplace(pos, svr::move(value));
+            }
+
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                const size_t index = static_cast<size_t>(first - begin());
+                const size_t count = static_cast<size_t>(last - first);
+                if(count == 0)
+                {
+                    return slot(index);
+                }
+                T* base = slot(0);
+                if constexpr(is_trivially_relocatable_v<T>)
+                {
+                    std::destroy(base + index, base + index + count);
+                    std::memmove(static_cast<void*>(base + index), static_cast<void*>(base + index + count), (d_size - index - count) * sizeof(T));
+                }
+                else
+                {
+                    std::move(base + index + count, base + d_size, base + index);
+                    std::destroy(base + d_size - count, base + d_size);
+                }
+                d_size = static_cast<size_type_t>(d_size - count);
+                return slot(index);
+            }
+
+            iterator erase(const_iterator pos)
+            {
+                return erase(pos, pos + 1);
+            }
+
+            void swap(inplace_vector& other)
+            {
+                inplace_vector tmp(svr::move(other));
+                other = svr::move(*this);
+                *this = svr::move(tmp);
+            }
+    };
+
+    template<typename T, size_t N>
+    bool operator==(const inplace_vector<T, N>& lhs, const inplace_vector<T, N>& rhs)
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+    template<typename T, size_t N>
+    bool operator!=(const inplace_vector<T, N>& lhs, const inplace_vector<T, N>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+}
+
+#endif
@@ -0,0 +1,546 @@
+#ifndef SVR_SMALL_VECTOR
+#define SVR_SMALL_VECTOR
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include "templates/forward.h"
+#include "templates/is_trivially_relocatable.h"
+#include "templates/move.h"
+
+/**
+ Vector that keeps up to N elements inside the object and only goes to Alloc past that.
+ Scratch lists and message payloads that are usually short then cost no allocation at all,
+ and the rare long one still works.
+
+ a) Layout is {begin, size, capacity, inline buffer}. begin points either at the inline buffer
+ or at heap memory, so element access has no branch on where the data lives
+ b) Growth doubles the capacity. Elements move to the new buffer with one memcpy when T is
+ trivially relocatable (svr::is_trivially_relocatable, which types can opt into), otherwise
+ with move_if_noexcept and a destructor each. insert and erase shift the same way. The new
+ element of a growing emplace_back is built before the old ones move, so emplace_back(v[0])
+ is safe
+ c) Once on the heap the vector stays there (clear() keeps the capacity) until
+ shrink_to_fit() brings the elements back inline when they fit
+ d) Moving a heap-backed vector steals the buffer; moving an inline one has to move the
+ elements, and leaves the source empty in both cases
+ e) The allocator is stored with [[no_unique_address]], and follows the source on copy
+ construction (select_on_container_copy_construction) and on moves. Assignment keeps this
+ vector's allocator; a move assignment with unequal allocators moves element by element
+ */
+namespace svr
+{
+    template<typename T, size_t N, typename Alloc = std::allocator<T>>
+    class small_vector
+    {
+        using Traits = std::allocator_traits<Alloc>;
+
+        static constexpr bool RELOCATABLE = is_trivially_relocatable_v<T>;
+
+        public:
+            using value_type = T;
+            using allocator_type = Alloc;
+            using size_type = size_t;
+            using difference_type = std::ptrdiff_t;
+            using reference = T&;
+            using const_reference = const T&;
+            using pointer = T*;
+            using const_pointer = const T*;
+            using iterator = T*;
+            using const_iterator = const T*;
+
+            static constexpr size_t INLINE_CAPACITY = N;
+
+        private:
+            T* d_begin;
+            size_t d_size{0};
+            size_t d_capacity{N};
+            [[no_unique_address]] Alloc d_alloc;
+            alignas(T) unsigned char d_inline[N ? N * sizeof(T) : 1];
+
+            T* inlineData()
+            {
+                return std::launder(reinterpret_cast<T*>(d_inline));
+            }
+
+            bool onHeap() const
+            {
+                return d_begin != reinterpret_cast<const T*>(d_inline);
+            }
+
+            // Move count elements from src to raw memory at dst and end their lifetime in src
+            static void relocate(T* src, size_t count, T* dst)
+            {
+                if constexpr(RELOCATABLE)
+                {
+                    if(count)
+                    {
+                        std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+                    }
+                }
+                else
+                {
+                    for(size_t i = 0; i < count; ++i)
+                    {
+                        ::new(static_cast<void*>(dst + i)) T(std::move_if_noexcept(src[i]));
+                        src[i].~T();
+                    }
+                }
+            }
+
+            void freeHeap()
+            {
+                if(onHeap())
+                {
+                    Traits::deallocate(d_alloc, d_begin, d_capacity);
+                }
+                d_begin = inlineData();
+                d_capacity = N;
+            }
+
+            // Move all elements into a buffer of capacity; the buffer must fit them
+            void reallocate(size_t capacity)
+            {
+                T* buffer = Traits::allocate(d_alloc, capacity);
+                relocate(d_begin, d_size, buffer);
+                if(onHeap())
+                {
+                    Traits::deallocate(d_alloc, d_begin, d_capacity);
+                }
+                d_begin = buffer;
+                d_capacity = capacity;
+            }
+
+            size_t grownCapacity(size_t needed) const
+            {
+                return std::max(needed, d_capacity ? 2 * d_capacity : size_t(1));
+            }
+
+            // Slow path of emplace_back: the new element goes into the new buffer first
+            template<typename... Args>
+            T& growAndEmplaceBack(Args&&... args)
+            {
+                const size_t capacity = grownCapacity(d_size + 1);
+                T* buffer = Traits::allocate(d_alloc, capacity);
+                try
+                {
+                    ::new(static_cast<void*>(buffer + d_size)) T(svr::forward<Args>(args)...);
+                }
+                catch(...)
+                {
+                    Traits::deallocate(d_alloc, buffer, capacity);
+                    throw;
+                }
+                relocate(d_begin, d_size, buffer);
+                if(onHeap())
+                {
+                    Traits::deallocate(d_alloc, d_begin, d_capacity);
+                }
+                d_begin = buffer;
+                d_capacity = capacity;
+                return d_begin[d_size++];
+            }
+
+            // Take other's elements, leaving it empty. Allocators must be interchangeable
+            void steal(small_vector& other)
+            {
+                if(other.onHeap())
+                {
+                    d_begin = other.d_begin;
+                    d_capacity = other.d_capacity;
+                    other.d_begin = other.inlineData();
+                    other.d_capacity = N;
+                }
+                else
+                {
+                    relocate(other.d_begin, other.d_size, d_begin);
+                }
+                d_size = other.d_size;
+                other.d_size = 0;
+            }
+
+            template<typename It>
+            void appendRange(It first, It last)
+            {
+                if constexpr(std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>)
+                {
+                    reserve(d_size + static_cast<size_t>(std::distance(first, last)));
+                }
+                for(; first != last; ++first)
+                {
+                    emplace_back(*first);
+                }
+            }
+
+        public:
+            small_vector() noexcept(std::is_nothrow_default_constructible_v<Alloc>) : d_begin(inlineData()) {}
+
+            explicit small_vector(const Alloc& alloc) noexcept : d_begin(inlineData()), d_alloc(alloc) {}
+
+            explicit small_vector(size_t count, const Alloc& alloc = Alloc()) : d_begin(inlineData()), d_alloc(alloc)
+            {
+                resize(count);
+            }
+
+            small_vector(size_t count, const T& value, const Alloc& alloc = Alloc()) : d_begin(inlineData()), d_alloc(alloc)
+            {
+                resize(count, value);
+            }
+
+            small_vector(std::initializer_list<T> values, const Alloc& alloc = Alloc()) : d_begin(inlineData()), d_alloc(alloc)
+            {
+                appendRange(values.begin(), values.end());
+            }
+
+            template<typename It>
+                requires (!std::is_integral_v<It>)
+            small_vector(It first, It last, const Alloc& alloc = Alloc()) : d_begin(inlineData()), d_alloc(alloc)
+            {
+                appendRange(first, last);
+            }
+
+            small_vector(const small_vector& other)
+                : d_begin(inlineData()), d_alloc(Traits::select_on_container_copy_construction(other.d_alloc))
+            {
+                appendRange(other.begin(), other.end());
+            }
+
+            small_vector(small_vector&& other) noexcept(RELOCATABLE || std::is_nothrow_move_constructible_v<T>)
+                : d_begin(inlineData()), d_alloc(svr::move(other.d_alloc))
+            {
+                steal(other);
+            }
+
+            ~small_vector()
+            {
+                clear();
+                freeHeap();
+            }
+
+            small_vector& operator=(const small_vector& other)
+            {
+                if(this != &other)
+                {
+                    clear();
+                    appendRange(other.begin(), other.end());
+                }
+                return *this;
+            }
+
+            small_vector& operator=(small_vector&& other) noexcept(Traits::is_always_equal::value && (RELOCATABLE || std::is_nothrow_move_constructible_v<T>))
+            {
+                if(this == &other)
+                {
+                    return *this;
+                }
+                clear();
+                if(Traits::is_always_equal::value || d_alloc == other.d_alloc)
+                {
+                    freeHeap();
+                    steal(other);
+                }
+                else
+                {
+                    reserve(other.d_size);
+                    relocate(other.d_begin, other.d_size, d_begin);
+                    d_size = other.d_size;
+                    other.d_size = 0;
+                }
+                return *this;
+            }
+
+            small_vector& operator=(std::initializer_list<T> values)
+            {
+                clear();
+                appendRange(values.begin(), values.end());
+                return *this;
+            }
+
+            allocator_type get_allocator() const
+            {
+                return d_alloc;
+            }
+
+            size_t size() const noexcept
+            {
+                return d_size;
+            }
+
+            size_t capacity() const noexcept
+            {
+                return d_capacity;
+            }
+
+            bool empty() const noexcept
+            {
+                return d_size == 0;
+            }
+
+            // True while the elements live in the inline buffer
+            bool is_inline() const noexcept
+            {
+                return !onHeap();
+            }
+
+            T* data() noexcept
+            {
+                return d_begin;
+            }
+
+            const T* data() const noexcept
+            {
+                return d_begin;
+            }
+
+            iterator begin() noexcept
+            {
+                return d_begin;
+            }
+
+            iterator end() noexcept
+            {
+                return d_begin + d_size;
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return d_begin;
+            }
+
+            const_iterator end() const noexcept
+            {
+                return d_begin + d_size;
+            }
+
+            T& operator[](size_t index)
+            {
+                return d_begin[index];
+            }
+
+            const T& operator[](size_t index) const
+            {
+                return d_begin[index];
+            }
+
+            T& at(size_t index)
+            {
+                if(index >= d_size)
+                {
+                    throw std::out_of_range("svr::small_vector::at");
+                }
+                return d_begin[index];
+            }
+
+            const T& at(size_t index) const
+            {
+                if(index >= d_size)
+                {
+                    throw std::out_of_range("svr::small_vector::at");
+                }
+                return d_begin[index];
+            }
+
+            T& front()
+            {
+                return d_begin[0];
+            }
+
+            const T& front() const
+            {
+                return d_begin[0];
+            }
+
+            T& back()
+            {
+                return d_begin[d_size - 1];
+            }
+
+            const T& back() const
+            {
+                return d_begin[d_size - 1];
+            }
+
+            void reserve(size_t capacity)
+            {
+                if(capacity > d_capacity)
+                {
+                    reallocate(capacity);
+                }
+            }
+
+            // Back into the inline buffer if the elements fit, else down to size()
+            void shrink_to_fit()
+            {
+                if(!onHeap() || d_size == d_capacity)
+                {
+                    return;
+                }
+                if(d_size <= N)
+                {
+                    T* heap = d_begin;
+                    const size_t capacity = d_capacity;
+                    relocate(heap, d_size, inlineData());
+                    Traits::deallocate(d_alloc, heap, capacity);
+                    d_begin = inlineData();
+                    d_capacity = N;
+                    return;
+                }
+                reallocate(d_size);
+            }
+
+            template<typename... Args>
+            T& emplace_back(Args&&... args)
+            {
+                if(d_size == d_capacity) [[unlikely]]
+                {
+                    return growAndEmplaceBack(svr::forward<Args>(args)...);
+                }
+                T* ptr = ::new(static_cast<void*>(d_begin + d_size)) T(svr::forward<Args>(args)...);
+                ++d_size;
+                return *ptr;
+            }
+
+            void push_back(const T& value)
+            {
+                emplace_back(value);
+            }
+
+            void push_back(T&& value)
+            {
+                emplace_back(svr::move(value));
+            }
+
+            void pop_back()
+            {
+                d_begin[--d_size].~T();
+            }
+
+            // Keeps the capacity
+            void clear() noexcept
+            {
+                std::destroy(d_begin, d_begin + d_size);
+                d_size = 0;
+            }
+
+            void resize(size_t count)
+            {
+                reserve(count);
+                while(d_size > count)
+                {
+                    pop_back();
+                }
+                while(d_size < count)
+                {
+                    ::new(static_cast<void*>(d_begin + d_size)) T();
+                    ++d_size;
+                }
+            }
+
+            void resize(size_t count, const T& value)
+            {
+                while(d_size > count)
+                {
+                    pop_back();
+                }
+                while(d_size < count)
+                {
+                    emplace_back(value);
+                }
+            }
+
+            template<typename... Args>
+            iterator emplace(const_iterator pos, Args&&... args)
+            {
+                const size_t index = static_cast<size_t>(pos - d_begin);
+                if(index == d_size)
+                {
+                    emplace_back(svr::forward<Args>(args)...);
+                    return d_begin + index;
+                }
+                // Build first: args may refer to an element that is about to move
+                T value(svr::forward<Args>(args)...);
+                if(d_size == d_capacity)
+                {
+                    reallocate(grownCapacity(d_size + 1));
+                }
+                T* base = d_begin;
+                if constexpr(RELOCATABLE)
+                {
+                    std::memmove(static_cast<void*>(base + index + 1), static_cast<void*>(base + index), (d_size - index) * sizeof(T));
+                    ::new(static_cast<void*>(base + index)) T(svr::move(value));
+                }
+                else
+                {
+                    ::new(static_cast<void*>(base + d_size)) T(svr::move(base[d_size - 1]));
+                    std::move_backward(base + index, base + d_size - 1, base + d_size);
+                    base[index] = svr::move(value);
+                }
+                ++d_size;
+                return base + index;
+            }
+
+            iterator insert(const_iterator pos, const T& value)
+            {
+                return emplace(pos, value);
+            }
+
+            iterator insert(const_iterator pos, T&& value)
+            {
+                return emplace(pos, svr::move(value));
+            }
+
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                const size_t index = static_cast<size_t>(first - d_begin);
+                const size_t count = static_cast<size_t>(last - first);
+                if(count == 0)
+                {
+                    return d_begin + index;
+                }
+                T* base = d_begin;
+                if constexpr(RELOCATABLE)
+                {
+                    std::destroy(base + index, base + index + count);
+                    std::memmove(static_cast<void*>(base + index), static_cast<void*>(base + index + count), (d_size - index - count) * sizeof(T));
+                }
+                else
+                {
+                    std::move(base + index + count, base + d_size, base + index);
+                    std::destroy(base + d_size - count, base + d_size);
+                }
+                d_size -= count;
+                return base + index;
+            }
+
+            iterator erase(const_iterator pos)
+            {
+                return erase(pos, pos + 1);
+            }
+
+            void swap(small_vector& other)
+            {
+                small_vector tmp(svr::move(other));
+                other = svr::move(*this);
+                *this = svr::move(tmp);
+            }
+    };
+
+    template<typename T, size_t N, typename Alloc>
+    bool operator==(const small_vector<T, N, Alloc>& lhs, const small_vector<T, N, Alloc>& rhs)
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+    template<typename T, size_t N, typename Alloc>
+    bool operator!=(const small_vector<T, N, Alloc>& lhs, const small_vector<T, N, Alloc>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+}
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef SVR_ALLOCATION_TRACKER
+#define SVR_ALLOCATION_TRACKER
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+/**
+ Counts heap allocations per thread, so a test can assert that a hot path (a queue push, a
+ shared_ptr copy) does not allocate, and a benchmark can report allocations per operation.
+
+ a) Opt-in and per executable: exactly one translation unit defines SVR_DEFINE_ALLOCATION_HOOKS
+ before including this header. That unit then replaces every global operator new and delete
+ (array, nothrow, sized and aligned forms) with versions that count and forward to malloc/free.
+ Every other unit only includes the header to read the counters. Without the hooks the counters
+ stay zero and allocation_tracking_enabled() is false
+ b) Optionally the same unit also defines SVR_DEFINE_MALLOC_HOOKS to interpose malloc, calloc,
+ realloc, free, aligned_alloc and posix_memalign themselves (glibc only), which catches C code
+ and libraries that bypass operator new. Sanitizers interpose malloc on their own, so this is
+ rejected under ThreadSanitizer and AddressSanitizer; the operator new hooks work under both
+ c) Counters are thread_local plain integers, no atomics and no locks: a hook costs a TLS
+ increment on top of malloc. allocation_stats() returns the calling thread's totals, so measure
+ a section by subtracting two snapshots taken on the thread that runs it
+ d) bytes_allocated is what was requested. Frees only count, because an unsized delete or
+ free() does not know the size
+ e) AllocationGuard reports every allocation made by its thread during its lifetime through
+ the allocation failure handler: by default a message on stderr and std::abort(). Tests install
+ a handler that fails the current test instead (set_allocation_failure_handler)
+ */
+namespace svr
+{
+    struct AllocationStats
+    {
+        uint64_t allocations{0};
+        uint64_t deallocations{0};
+        uint64_t bytes_allocated{0};
+
+        AllocationStats operator-(const AllocationStats& other) const
+        {
+            return {allocations - other.allocations, deallocations - other.deallocations, bytes_allocated - other.bytes_allocated};
+        }
+    };
+
+    using AllocationFailureHandler = void (*)(const char* what, const AllocationStats& stats);
+
+    namespace detail
+    {
+        inline thread_local AllocationStats t_allocationStats;
+        inline std::atomic<bool> s_allocationHooksInstalled{false};
+
+        inline void abortOnAllocation(const char* what, const AllocationStats& stats)
+        {
+            std::fprintf(stderr, "svr::AllocationGuard: %s: %llu allocation(s), %llu byte(s)\n", what ? what : "(unnamed)",
+                         static_cast<unsigned long long>(stats.allocations), static_cast<unsigned long long>(stats.bytes_allocated));
+            std::abort();
+        }
+
+        inline std::atomic<AllocationFailureHandler> s_allocationFailureHandler{&abortOnAllocation};
+
+        inline void countAllocation(size_t bytes)
+        {
+            AllocationStats& stats = t_allocationStats;
+            ++stats.allocations;
+            stats.bytes_allocated += bytes;
+        }
+
+        inline void countDeallocation()
+        {
+            ++t_allocationStats.deallocations;
+        }
+    }
+
+    // Totals of the calling thread since it started
+    inline AllocationStats allocation_stats()
+    {
+        return detail::t_allocationStats;
+    }
+
+    // True if some translation unit of the executable defines the hooks
+    inline bool allocation_tracking_enabled()
+    {
+        return detail::s_allocationHooksInstalled.load(std::memory_order_relaxed);
+    }
+
+    // Returns the previous handler. nullptr restores the default (print and abort)
+    inline AllocationFailureHandler set_allocation_failure_handler(AllocationFailureHandler handler)
+    {
+        return detail::s_allocationFailureHandler.exchange(handler ? handler : &detail::abortOnAllocation);
+    }
+
+    // No allocation on this thread while the guard lives. Stays on the thread that made it
+    class AllocationGuard
+    {
+        private:
+            const char* d_what;
+            AllocationStats d_start;
+
+        public:
+            explicit AllocationGuard(const char* what = nullptr) : d_what(what), d_start(allocation_stats()) {}
+            AllocationGuard(const AllocationGuard&) = delete;
+            AllocationGuard& operator=(const AllocationGuard&) = delete;
+            ~AllocationGuard()
+            {
+                const AllocationStats stats = allocations();
+                if(stats.allocations != 0)
+                {
+                    detail::s_allocationFailureHandler.load()(d_what, stats);
+                }
+            }
+
+            // Made by this thread since the guard was created
+            AllocationStats allocations() const
+            {
+                return allocation_stats() - d_start;
+            }
+    };
+}
+
+#if defined(SVR_DEFINE_ALLOCATION_HOOKS)
+
+#if defined(SVR_DEFINE_MALLOC_HOOKS)
+#if defined(__SANITIZE_THREAD__) || defined(__SANITIZE_ADDRESS__)
+#error "SVR_DEFINE_MALLOC_HOOKS cannot be combined with a sanitizer that interposes malloc"
+#endif
+#if !defined(__GLIBC__)
+#error "SVR_DEFINE_MALLOC_HOOKS needs glibc's __libc_malloc family"
+#endif
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+
+    void* malloc(size_t bytes)
+    {
+        svr::detail::countAllocation(bytes);
+        return __libc_malloc(bytes);
+    }
+
+    void* calloc(size_t count, size_t bytes)
+    {
+        svr::detail::countAllocation(count * bytes);
+        return __libc_calloc(count, bytes);
+    }
+
+    // Counted as a free and an allocation, which is what it may turn into
+    void* realloc(void* ptr, size_t bytes)
+    {
+        if(ptr)
+        {
+            svr::detail::countDeallocation();
+        }
+        if(bytes)
+        {
+            svr::detail::countAllocation(bytes);
+        }
+        return __libc_realloc(ptr, bytes);
+    }
+
+    void free(void* ptr)
+    {
+        if(ptr)
+        {
+            svr::detail::countDeallocation();
+        }
+        __libc_free(ptr);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t bytes)
+    {
+        svr::detail::countAllocation(bytes);
+        return __libc_memalign(alignment, bytes);
+    }
+
+    int posix_memalign(void** out, size_t alignment, size_t bytes)
+    {
+        if(alignment < sizeof(void*) || (alignment & (alignment - 1)))
+        {
+            return EINVAL;
+        }
+        void* ptr = __libc_memalign(alignment, bytes);
+        if(!ptr)
+        {
+            return ENOMEM;
+        }
+        svr::detail::countAllocation(bytes);
+        *out = ptr;
+        return 0;
+    }
+}
+#endif
+
+namespace svr::detail
+{
+    // The operator new hooks count here and not again in the malloc hooks
+    inline void* rawAllocate(size_t bytes, size_t alignment)
+    {
+        if(bytes == 0)
+        {
+            bytes = 1;
+        }
+#if defined(SVR_DEFINE_MALLOC_HOOKS)
+        return alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? __libc_malloc(bytes) : __libc_memalign(alignment, bytes);
+#else
+        if(alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            return std::malloc(bytes);
+        }
+        void* ptr = nullptr;
+        return ::posix_memalign(&ptr, alignment, bytes) == 0 ? ptr : nullptr;
+#endif
+    }
+
+    inline void rawFree(void* ptr)
+    {
+#if defined(SVR_DEFINE_MALLOC_HOOKS)
+        __libc_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+
+    inline void* trackedNew(size_t bytes, size_t alignment)
+    {
+        while(true)
+        {
+            if(void* ptr = rawAllocate(bytes, alignment))
+            {
+                countAllocation(bytes);
+                return ptr;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if(!handler)
+            {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    inline void* trackedNewNothrow(size_t bytes, size_t alignment) noexcept
+    {
+        try
+        {
+            return trackedNew(bytes, alignment);
+        }
+        catch(...)
+        {
+            return nullptr;
+        }
+    }
+
+    inline void trackedDelete(void* ptr) noexcept
+    {
+        if(ptr)
+        {
+            countDeallocation();
+            rawFree(ptr);
+        }
+    }
+
+    [[maybe_unused]] static const bool s_allocationHooksRegistered = (s_allocationHooksInstalled.store(true, std::memory_order_relaxed), true);
+}
+
+void* operator new(size_t bytes)
+{
+    return svr::detail::trackedNew(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](size_t bytes)
+{
+    return svr::detail::trackedNew(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept
+{
+    return svr::detail::trackedNewNothrow(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept
+{
+    return svr::detail::trackedNewNothrow(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment)
+{
+    return svr::detail::trackedNew(bytes, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment)
+{
+    return svr::detail::trackedNew(bytes, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return svr::detail::trackedNewNothrow(bytes, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return svr::detail::trackedNewNothrow(bytes, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    svr::detail::trackedDelete(ptr);
+}
+
+#endif
+
+#endif
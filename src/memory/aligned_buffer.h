@@ -0,0 +1,211 @@
+#ifndef SVR_ALIGNED_BUFFER
+#define SVR_ALIGNED_BUFFER
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "memory/unique_ptr.h"
+#include "multithreading/spinlock/spinlock.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/**
+ Large array buffers for unique_ptr<T[], Deleter>, default-initialized like
+ make_unique_for_overwrite: trivial elements are left as they are, so nothing touches the
+ memory before the caller's first write.
+
+ a) make_unique_aligned_for_overwrite<T[]>(n, alignment) aligns the first element to a cache
+ line (default) or anything larger. At HUGE_PAGE_SIZE alignment the buffer is also marked
+ MADV_HUGEPAGE, so transparent huge pages can back it where the kernel allows
+ b) make_unique_huge_pages_for_overwrite<T[]>(n) maps the buffer directly, rounded up to whole
+ 2 MiB pages: explicit huge pages (MAP_HUGETLB) if the system has some reserved, otherwise a
+ 2 MiB aligned anonymous mapping marked MADV_HUGEPAGE. One TLB entry then covers 2 MiB instead
+ of 4 KiB, which matters for random access over gigabytes. Fresh mappings read as zero
+ c) A count whose size in bytes does not fit in size_t (after rounding up to whole pages, for
+ the huge-page variant) throws std::bad_array_new_length, as new T[n] does
+ d) Both deleters carry the element count, and the huge-page one the mapping length, so they
+ are one or two words and need the (pointer, deleter) constructor. Elements are destroyed in
+ place before the memory goes back
+ e) Outside Linux the huge-page variant falls back to 2 MiB aligned ::operator new
+ */
+namespace svr
+{
+    inline constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+    template<typename T>
+    class AlignedArrayDeleter
+    {
+        private:
+            size_t d_count{0};
+            size_t d_alignment{alignof(T)};
+
+        public:
+            AlignedArrayDeleter() = default;
+            AlignedArrayDeleter(size_t count, size_t alignment) : d_count(count), d_alignment(alignment) {}
+
+            void operator()(T* ptr) const
+            {
+                std::destroy_n(ptr, d_count);
+                ::operator delete(static_cast<void*>(ptr), std::align_val_t(d_alignment));
+            }
+
+            size_t size() const
+            {
+                return d_count;
+            }
+
+            size_t alignment() const
+            {
+                return d_alignment;
+            }
+    };
+
+    template<typename T>
+    class HugePageDeleter
+    {
+        private:
+            size_t d_count{0};
+            size_t d_bytes{0};
+
+        public:
+            HugePageDeleter() = default;
+            HugePageDeleter(size_t count, size_t bytes) : d_count(count), d_bytes(bytes) {}
+
+            void operator()(T* ptr) const
+            {
+                std::destroy_n(ptr, d_count);
+#if defined(__linux__)
+                ::munmap(static_cast<void*>(ptr), d_bytes);
+#else
+                ::operator delete(static_cast<void*>(ptr), std::align_val_t(HUGE_PAGE_SIZE));
+#endif
+            }
+
+            size_t size() const
+            {
+                return d_count;
+            }
+
+            // Bytes mapped, a multiple of HUGE_PAGE_SIZE
+            size_t mapped_bytes() const
+            {
+                return d_bytes;
+            }
+    };
+
+    namespace detail
+    {
+        // n * sizeof(T), or std::bad_array_new_length if that does not fit in max bytes
+        template<typename T>
+        size_t array_bytes(size_t n, size_t max = std::numeric_limits<size_t>::max())
+        {
+            if(n > max / sizeof(T))
+            {
+                throw std::bad_array_new_length();
+            }
+            return n * sizeof(T);
+        }
+
+        // Default-initialize n elements in raw memory. If a constructor throws, the elements
+        // already built are destroyed and the memory goes back through release(raw)
+        template<typename T, typename Release>
+        T* construct_for_overwrite(void* raw, size_t n, Release release)
+        {
+            T* ptr = static_cast<T*>(raw);
+            try
+            {
+                std::uninitialized_default_construct_n(ptr, n);
+            }
+            catch(...)
+            {
+                release(raw);
+                throw;
+            }
+            return ptr;
+        }
+
+#if defined(__linux__)
+        // 2 MiB aligned anonymous mapping of bytes (a multiple of HUGE_PAGE_SIZE)
+        inline void* map_huge_pages(size_t bytes)
+        {
+            void* ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(ptr != MAP_FAILED)
+            {
+                return ptr;
+            }
+            // No reserved huge pages: over-map by one page, trim to alignment, ask for THP
+            const size_t padded = bytes + HUGE_PAGE_SIZE;
+            void* raw = ::mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(raw == MAP_FAILED)
+            {
+                throw std::bad_alloc();
+            }
+            const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+            const uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(uintptr_t(HUGE_PAGE_SIZE) - 1);
+            if(aligned > start)
+            {
+                ::munmap(raw, aligned - start);
+            }
+            if(const size_t tail = start + padded - (aligned + bytes))
+            {
+                ::munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+            }
+            ::madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);
+            return reinterpret_cast<void*>(aligned);
+        }
+#endif
+    }
+
+    // alignment must be a power of two; it is raised to alignof(element) if smaller
+    template<typename T,
+             typename = std::enable_if_t<std::is_unbounded_array<T>::value>>
+    unique_ptr<T, AlignedArrayDeleter<std::remove_extent_t<T>>> make_unique_aligned_for_overwrite(size_t n, size_t alignment = SVR_CACHELINE_SIZE)
+    {
+        using ElementType = std::remove_extent_t<T>;
+        if(alignment < alignof(ElementType))
+        {
+            alignment = alignof(ElementType);
+        }
+        const size_t bytes = detail::array_bytes<ElementType>(n);
+        void* raw = ::operator new(bytes, std::align_val_t(alignment));
+#if defined(__linux__)
+        if(alignment >= HUGE_PAGE_SIZE && bytes >= HUGE_PAGE_SIZE)
+        {
+            ::madvise(raw, bytes / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE, MADV_HUGEPAGE);
+        }
+#endif
+        ElementType* ptr = detail::construct_for_overwrite<ElementType>(raw, n, [alignment](void* p) { ::operator delete(p, std::align_val_t(alignment)); });
+        return unique_ptr<T, AlignedArrayDeleter<ElementType>>(ptr, AlignedArrayDeleter<ElementType>(n, alignment));
+    }
+
+    template<typename T,
+             typename = std::enable_if_t<std::is_unbounded_array<T>::value>>
+    unique_ptr<T, HugePageDeleter<std::remove_extent_t<T>>> make_unique_huge_pages_for_overwrite(size_t n)
+    {
+        using ElementType = std::remove_extent_t<T>;
+        static_assert(alignof(ElementType) <= HUGE_PAGE_SIZE);
+        // Leaves room for the round-up here and the one page map_huge_pages over-maps
+        size_t bytes = detail::array_bytes<ElementType>(n, std::numeric_limits<size_t>::max() - 2 * HUGE_PAGE_SIZE);
+        bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        if(bytes == 0)
+        {
+            bytes = HUGE_PAGE_SIZE;
+        }
+#if defined(__linux__)
+        void* raw = detail::map_huge_pages(bytes);
+        auto release = [bytes](void* p) { ::munmap(p, bytes); };
+#else
+        void* raw = ::operator new(bytes, std::align_val_t(HUGE_PAGE_SIZE));
+        auto release = [](void* p) { ::operator delete(p, std::align_val_t(HUGE_PAGE_SIZE)); };
+#endif
+        ElementType* ptr = detail::construct_for_overwrite<ElementType>(raw, n, release);
+        return unique_ptr<T, HugePageDeleter<ElementType>>(ptr, HugePageDeleter<ElementType>(n, bytes));
+    }
+}
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef SVR_ATOMIC_SHARED_PTR
+#define SVR_ATOMIC_SHARED_PTR
+
+#include <atomic>
+#include <cstddef>
+#include "memory/shared_ptr.h"
+#include "memory/unique_ptr.h"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+#include "templates/move.h"
+
+/**
+ A shared_ptr slot that many threads read and a few threads replace (configuration, routing
+ tables). The value lives in a heap Holder; d_current points at the live Holder and every
+ store swaps in a new one. Holders are protected with hazard pointers, one per ThreadSlot:
+ a) A reader announces the Holder it is about to use in its own cache-line-sized slot, then
+ re-reads d_current to make sure it was not replaced in between. That is a store then a load
+ on different words, so both are seq_cst, and so are the writer's exchange of d_current and
+ its read of the slots. After that the Holder cannot be freed until the slot is cleared
+ b) snapshot() stops there: the reader only ever writes its own slot and reads d_current, so
+ readers share d_current's line in every cache and never bounce it. load() additionally
+ copies the shared_ptr, which increments the object's count like any shared_ptr copy
+ c) Replaced Holders go on a lock-free retired stack. Each store (and the destructor) takes
+ the whole stack, frees every Holder no slot points at and pushes the rest back, so at most
+ one Holder per reading thread waits for reclamation
+ d) One hazard per thread per atomic_shared_ptr. While a thread holds a snapshot(), its other
+ reads of the same object, and all reads of threads without a ThreadSlot, go through one
+ shared extra slot under a spin lock; a nested snapshot() is a load(). A Snapshot is tied to
+ the thread that took it and cannot be moved
+ e) Memory: MAX_SLOTS + 1 cache lines per atomic_shared_ptr, fine for a few long-lived
+ published values, wasteful for a field in every object
+ */
+namespace svr
+{
+    template <typename T>
+    class atomic_shared_ptr
+    {
+        struct Holder
+        {
+            svr::shared_ptr<T> d_value;
+            Holder *d_nextRetired{nullptr};
+        };
+
+        struct alignas(SVR_CACHELINE_SIZE) HazardSlot
+        {
+            std::atomic<Holder *> d_hazard{nullptr};
+        };
+
+        static constexpr size_t SHARED_SLOT = ThreadSlot::MAX_SLOTS;
+
+    private:
+        alignas(SVR_CACHELINE_SIZE) std::atomic<Holder *> d_current;
+        alignas(SVR_CACHELINE_SIZE) std::atomic<Holder *> d_retired{nullptr};
+        mutable SpinLock<> d_sharedSlotLock;
+        mutable svr::unique_ptr<HazardSlot[]> d_slots;
+
+        // Announce the current Holder in slot and return it once it is safe to dereference
+        Holder *protect(HazardSlot &slot) const
+        {
+            Holder *holder = d_current.load(std::memory_order_relaxed);
+            while (true)
+            {
+                slot.d_hazard.store(holder, std::memory_order_seq_cst);
+                Holder *again = d_current.load(std::memory_order_seq_cst);
+                if (again == holder)
+                {
+                    return holder;
+                }
+                holder = again;
+            }
+        }
+
+        void retire(Holder *holder)
+        {
+            holder->d_nextRetired = d_retired.load(std::memory_order_relaxed);
+            while (!d_retired.compare_exchange_weak(holder->d_nextRetired, holder, std::memory_order_release, std::memory_order_relaxed));
+            reclaim();
+        }
+
+        void reclaim()
+        {
+            Holder *retired = d_retired.exchange(nullptr, std::memory_order_acquire);
+            if (!retired)
+            {
+                return;
+            }
+            // On the stack: stores must not allocate beyond their new Holder
+            Holder *hazards[ThreadSlot::MAX_SLOTS + 1];
+            size_t count = 0;
+            for (size_t i = 0, used = ThreadSlot::high_water(); i < used; ++i)
+            {
+                if (Holder *h = d_slots[i].d_hazard.load(std::memory_order_seq_cst))
+                {
+                    hazards[count++] = h;
+                }
+            }
+            if (Holder *h = d_slots[SHARED_SLOT].d_hazard.load(std::memory_order_seq_cst))
+            {
+                hazards[count++] = h;
+            }
+            while (retired)
+            {
+                Holder *next = retired->d_nextRetired;
+                bool inUse = false;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    inUse = inUse || hazards[i] == retired;
+                }
+                if (inUse)
+                {
+                    // Somebody still reads it, try again on a later store
+                    retired->d_nextRetired = d_retired.load(std::memory_order_relaxed);
+                    while (!d_retired.compare_exchange_weak(retired->d_nextRetired, retired, std::memory_order_release, std::memory_order_relaxed));
+                }
+                else
+                {
+                    delete retired;
+                }
+                retired = next;
+            }
+        }
+
+        static bool same(const svr::shared_ptr<T> &a, const svr::shared_ptr<T> &b)
+        {
+            return a.get() == b.get() && a.owner_equal(b);
+        }
+
+        template <typename F>
+        auto withProtected(F &&f) const
+        {
+            const size_t id = ThreadSlot::id();
+            // No slot of our own, or it is pinned by an outer snapshot of this thread
+            if (id == ThreadSlot::INVALID || d_slots[id].d_hazard.load(std::memory_order_relaxed)) [[unlikely]]
+            {
+                HazardSlot &shared = d_slots[SHARED_SLOT];
+                d_sharedSlotLock.lock();
+                auto result = f(protect(shared));
+                shared.d_hazard.store(nullptr, std::memory_order_release);
+                d_sharedSlotLock.unlock();
+                return result;
+            }
+            HazardSlot &slot = d_slots[id];
+            auto result = f(protect(slot));
+            slot.d_hazard.store(nullptr, std::memory_order_release);
+            return result;
+        }
+
+    public:
+        // Read-side guard from snapshot(). Keeps the value alive without touching its count.
+        // Not movable: its destructor clears the hazard slot of the thread that took it
+        class Snapshot
+        {
+            friend class atomic_shared_ptr;
+
+        private:
+            T *d_ptr;
+            HazardSlot *d_slot;
+            svr::shared_ptr<T> d_owned;
+
+            Snapshot(T *ptr, HazardSlot *slot) : d_ptr(ptr), d_slot(slot) {}
+            explicit Snapshot(svr::shared_ptr<T> owned) : d_ptr(owned.get()), d_slot(nullptr), d_owned(svr::move(owned)) {}
+
+        public:
+            Snapshot(const Snapshot &) = delete;
+            Snapshot &operator=(const Snapshot &) = delete;
+            ~Snapshot()
+            {
+                if (d_slot)
+                {
+                    d_slot->d_hazard.store(nullptr, std::memory_order_release);
+                }
+            }
+            T *get() const
+            {
+                return d_ptr;
+            }
+            T *operator->() const
+            {
+                return d_ptr;
+            }
+            T &operator*() const
+            {
+                return *d_ptr;
+            }
+            explicit operator bool() const
+            {
+                return d_ptr;
+            }
+        };
+
+        atomic_shared_ptr() : atomic_shared_ptr(svr::shared_ptr<T>()) {}
+        explicit atomic_shared_ptr(svr::shared_ptr<T> value)
+            : d_current(new Holder{svr::move(value)}), d_slots(new HazardSlot[ThreadSlot::MAX_SLOTS + 1])
+        {
+        }
+        atomic_shared_ptr(const atomic_shared_ptr &) = delete;
+        atomic_shared_ptr &operator=(const atomic_shared_ptr &) = delete;
+        // No reader may be active any more
+        ~atomic_shared_ptr()
+        {
+            reclaim();
+            delete d_current.load(std::memory_order_relaxed);
+        }
+
+        svr::shared_ptr<T> load() const
+        {
+            return withProtected([](Holder *holder) { return holder->d_value; });
+        }
+
+        // Cheapest read: no write to any shared cache line. Drop it quickly, the value it
+        // pins cannot be reclaimed while it lives
+        Snapshot snapshot() const
+        {
+            const size_t id = ThreadSlot::id();
+            if (id == ThreadSlot::INVALID || d_slots[id].d_hazard.load(std::memory_order_relaxed)) [[unlikely]]
+            {
+                return Snapshot(load());
+            }
+            HazardSlot &slot = d_slots[id];
+            return Snapshot(protect(slot)->d_value.get(), &slot);
+        }
+
+        void store(svr::shared_ptr<T> value)
+        {
+            Holder *old = d_current.exchange(new Holder{svr::move(value)}, std::memory_order_seq_cst);
+            retire(old);
+        }
+
+        svr::shared_ptr<T> exchange(svr::shared_ptr<T> value)
+        {
+            Holder *old = d_current.exchange(new Holder{svr::move(value)}, std::memory_order_seq_cst);
+            // Readers may still be copying old->d_value, so copy rather than move
+            svr::shared_ptr<T> previous = old->d_value;
+            retire(old);
+            return previous;
+        }
+
+        // Replaces the value with desired if it still is expected (same pointer, same owner).
+        // Otherwise loads the current value into expected
+        bool compare_exchange_strong(svr::shared_ptr<T> &expected, svr::shared_ptr<T> desired)
+        {
+            Holder *replacement = new Holder{svr::move(desired)};
+            while (true)
+            {
+                // The hazard keeps current from being freed and reused, so the CAS has no ABA
+                Holder *current = nullptr;
+                bool matches = withProtected([&](Holder *holder) {
+                    if (!same(holder->d_value, expected))
+                    {
+                        expected = holder->d_value;
+                        return false;
+                    }
+                    current = holder;
+                    return d_current.compare_exchange_strong(current, replacement, std::memory_order_seq_cst, std::memory_order_relaxed);
+                });
+                if (matches)
+                {
+                    retire(current);
+                    return true;
+                }
+                if (!current)
+                {
+                    delete replacement;
+                    return false;
+                }
+                // Replaced between the comparison and the CAS, look again
+            }
+        }
+
+        bool compare_exchange_weak(svr::shared_ptr<T> &expected, svr::shared_ptr<T> desired)
+        {
+            return compare_exchange_strong(expected, svr::move(desired));
+        }
+
+        // Readers with a ThreadSlot of their own and writers never wait on each other, but
+        // reads without one and nested reads take d_sharedSlotLock
+        bool is_lock_free() const
+        {
+            return false;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,370 @@
+#ifndef SVR_BIASED_SHARED_PTR
+#define SVR_BIASED_SHARED_PTR
+
+#include "atomic"
+#include "cstddef"
+#include "new"
+#include "utility"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+#include "templates/forward.h"
+#include "templates/move.h"
+
+/**
+ Biased reference counting (Choi, Shull, Torrellas). Most objects are copied and dropped by
+ the thread that created them and only occasionally by others. The owner updates a plain
+ counter; everybody else uses an atomic one, so the owner never pays for a locked RMW.
+ a) Ownership goes to a BiasRecord, one per ThreadSlot, not to a thread id. A thread claims its
+ slot's record on first use and gives it up at exit. Only whoever holds the record touches the
+ biased count, and claim/release are acquire/release, so a later thread on the same slot can
+ carry on with the biased counts a dead owner left behind
+ b) d_shared holds the non-owner count times 4 plus two flags: MERGED (biased count folded in,
+ everybody uses d_shared from now on) and QUEUED (waiting in the owner's merge queue). The
+ object is destroyed by whichever RMW leaves d_shared at exactly MERGED: count zero, merged,
+ not queued. Exactly one RMW can do that, whoever it belongs to
+ c) Merge protocol: when the owner's count drops to zero it adds it into d_shared and sets
+ MERGED. A non-owner that drives the shared count negative cannot tell whether the total is
+ zero (it must not read the biased count), so it sets QUEUED and pushes the block on the
+ record's lock-free queue. The record holder merges queued blocks on its next release, at
+ exit, or, if nobody holds the record, the pushing thread claims it and merges them itself
+ d) A block whose owner thread is alive but never releases another biased pointer waits in
+ the queue until that thread exits or calls BiasRecord::merge_queued(). Threads without a ThreadSlot create blocks that start out
+ merged
+ */
+namespace svr
+{
+    class biased_control_block;
+
+    class alignas(SVR_CACHELINE_SIZE) BiasRecord
+    {
+    private:
+        std::atomic<bool> d_claimed{false};
+        std::atomic<biased_control_block *> d_queue{nullptr};
+
+        friend class biased_control_block;
+
+        static inline thread_local BiasRecord *t_record = nullptr;
+
+        static BiasRecord &ofSlot(size_t slot)
+        {
+            static BiasRecord s_records[ThreadSlot::MAX_SLOTS];
+            return s_records[slot];
+        }
+
+        bool tryClaim()
+        {
+            return !d_claimed.load(std::memory_order_relaxed) && !d_claimed.exchange(true, std::memory_order_acquire);
+        }
+
+        void unclaim()
+        {
+            d_claimed.store(false, std::memory_order_release);
+        }
+
+        void push(biased_control_block *block);
+        // Caller holds the record
+        void drain();
+
+        // Caller holds the record
+        void drainIfQueued()
+        {
+            if (d_queue.load(std::memory_order_relaxed)) [[unlikely]]
+            {
+                drain();
+            }
+        }
+
+        // Merge whatever was queued while nobody held the record
+        void drainIfUnclaimed()
+        {
+            while (d_queue.load(std::memory_order_acquire) && tryClaim())
+            {
+                drain();
+                unclaim();
+            }
+        }
+
+        struct ThreadExit
+        {
+            BiasRecord *d_record;
+            ~ThreadExit()
+            {
+                t_record = nullptr;
+                d_record->drain();
+                d_record->unclaim();
+                d_record->drainIfUnclaimed();
+            }
+        };
+
+    public:
+        // Merge blocks other threads queued for the calling thread. Happens anyway on the
+        // thread's next biased release; call it at quiet points of threads that hand objects
+        // off and then stop using biased pointers
+        static void merge_queued()
+        {
+            if (BiasRecord *record = current())
+            {
+                record->drainIfQueued();
+            }
+        }
+
+        // Record held by the calling thread, claimed on first use. nullptr without a ThreadSlot
+        // and during thread exit
+        static BiasRecord *current()
+        {
+            if (!t_record) [[unlikely]]
+            {
+                // Set for good once claimed, so nothing is re-claimed during thread exit
+                static thread_local bool s_claimed = false;
+                const size_t slot = ThreadSlot::id();
+                if (s_claimed || slot == ThreadSlot::INVALID)
+                {
+                    return nullptr;
+                }
+                BiasRecord &record = ofSlot(slot);
+                // Only busy while some thread merges for a dead previous owner
+                spin_until([&record]() { return record.tryClaim(); });
+                s_claimed = true;
+                t_record = &record;
+                static thread_local ThreadExit s_exit{&record};
+            }
+            return t_record;
+        }
+    };
+
+    class biased_control_block
+    {
+        static constexpr long MERGED = 1;
+        static constexpr long QUEUED = 2;
+        static constexpr long ONE = 4;
+
+    private:
+        BiasRecord *const d_owner;
+        // Written only by whoever holds d_owner
+        long d_biased;
+        bool d_merged;
+        std::atomic<long> d_shared;
+        biased_control_block *d_nextQueued{nullptr};
+
+        friend class BiasRecord;
+
+        void applyShared(long delta)
+        {
+            if (d_shared.fetch_add(delta, std::memory_order_acq_rel) + delta == MERGED)
+            {
+                destroy();
+            }
+        }
+
+        // Fold the biased count into d_shared. Caller holds d_owner
+        void merge(long extra)
+        {
+            const long biased = d_biased;
+            d_biased = 0;
+            d_merged = true;
+            applyShared(biased * ONE + MERGED + extra);
+        }
+
+    protected:
+        biased_control_block()
+            : d_owner(BiasRecord::current()), d_biased(d_owner ? 1 : 0), d_merged(!d_owner), d_shared(d_owner ? 0 : ONE + MERGED)
+        {
+        }
+
+        virtual ~biased_control_block() = default;
+
+        // Destroys the object and frees the block
+        virtual void destroy() = 0;
+
+    public:
+        void retain()
+        {
+            if (d_owner == BiasRecord::current() && d_owner && !d_merged) [[likely]]
+            {
+                ++d_biased;
+                return;
+            }
+            d_shared.fetch_add(ONE, std::memory_order_relaxed);
+        }
+
+        void release()
+        {
+            BiasRecord *record = BiasRecord::current();
+            if (d_owner == record && record && !d_merged) [[likely]]
+            {
+                // A QUEUED block survives this merge and is finished off by drain()
+                if (--d_biased == 0)
+                {
+                    merge(0);
+                }
+                record->drainIfQueued();
+                return;
+            }
+            long previous = d_shared.fetch_sub(ONE, std::memory_order_acq_rel);
+            long now = previous - ONE;
+            if (now == MERGED)
+            {
+                destroy();
+                return;
+            }
+            // Maybe the last reference overall, only the owner side can tell
+            while (!(now & (MERGED | QUEUED)) && now < 0)
+            {
+                if (d_shared.compare_exchange_weak(now, now | QUEUED, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    // Once pushed the block may be merged and freed any time
+                    BiasRecord *owner = d_owner;
+                    owner->push(this);
+                    owner->drainIfUnclaimed();
+                    return;
+                }
+            }
+        }
+
+        bool biased_to_current_thread() const
+        {
+            return d_owner && d_owner == BiasRecord::current() && !d_merged;
+        }
+    };
+
+    inline void BiasRecord::push(biased_control_block *block)
+    {
+        block->d_nextQueued = d_queue.load(std::memory_order_relaxed);
+        while (!d_queue.compare_exchange_weak(block->d_nextQueued, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    inline void BiasRecord::drain()
+    {
+        biased_control_block *block = d_queue.exchange(nullptr, std::memory_order_acquire);
+        while (block)
+        {
+            biased_control_block *next = block->d_nextQueued;
+            if (block->d_merged)
+            {
+                block->applyShared(-biased_control_block::QUEUED);
+            }
+            else
+            {
+                block->merge(-biased_control_block::QUEUED);
+            }
+            block = next;
+        }
+    }
+
+    template <typename TYPE>
+    class biased_inplace_control_block : public biased_control_block
+    {
+    private:
+        alignas(TYPE) unsigned char d_storage[sizeof(TYPE)];
+
+    protected:
+        void destroy() override
+        {
+            get()->~TYPE();
+            delete this;
+        }
+
+    public:
+        template <typename... Args>
+        explicit biased_inplace_control_block(Args &&...args)
+        {
+            ::new (static_cast<void *>(d_storage)) TYPE(svr::forward<Args>(args)...);
+        }
+
+        TYPE *get()
+        {
+            return std::launder(reinterpret_cast<TYPE *>(d_storage));
+        }
+    };
+
+    template <typename TYPE>
+    class biased_shared_ptr
+    {
+    private:
+        TYPE *d_ptr;
+        svr::biased_control_block *d_cntrl;
+
+        template <typename T, typename... Args>
+        friend biased_shared_ptr<T> make_biased_shared(Args &&...args);
+
+        biased_shared_ptr(TYPE *ptr, svr::biased_control_block *cntrl) : d_ptr(ptr), d_cntrl(cntrl) {}
+
+    public:
+        biased_shared_ptr() : d_ptr(nullptr), d_cntrl(nullptr) {}
+        biased_shared_ptr(std::nullptr_t) : biased_shared_ptr() {}
+        biased_shared_ptr(const biased_shared_ptr &other) : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->retain();
+            }
+        }
+        biased_shared_ptr(biased_shared_ptr &&other) noexcept : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            other.d_ptr = nullptr;
+            other.d_cntrl = nullptr;
+        }
+        biased_shared_ptr &operator=(const biased_shared_ptr &other)
+        {
+            if (d_cntrl == other.d_cntrl)
+            {
+                d_ptr = other.d_ptr;
+                return *this;
+            }
+            biased_shared_ptr(other).swap(*this);
+            return *this;
+        }
+        biased_shared_ptr &operator=(biased_shared_ptr &&other) noexcept
+        {
+            biased_shared_ptr(svr::move(other)).swap(*this);
+            return *this;
+        }
+        ~biased_shared_ptr()
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->release();
+            }
+        }
+        void reset()
+        {
+            biased_shared_ptr().swap(*this);
+        }
+        void swap(biased_shared_ptr &other) noexcept
+        {
+            std::swap(d_ptr, other.d_ptr);
+            std::swap(d_cntrl, other.d_cntrl);
+        }
+        TYPE *get() const
+        {
+            return d_ptr;
+        }
+        TYPE *operator->() const
+        {
+            return d_ptr;
+        }
+        TYPE &operator*() const
+        {
+            return *d_ptr;
+        }
+        explicit operator bool() const
+        {
+            return d_ptr;
+        }
+        // True while copies made on this thread take the non-atomic path
+        bool biased_to_current_thread() const
+        {
+            return d_cntrl && d_cntrl->biased_to_current_thread();
+        }
+    };
+
+    // The calling thread becomes the owner of the new object's biased count
+    template <typename T, typename... Args>
+    biased_shared_ptr<T> make_biased_shared(Args &&...args)
+    {
+        auto *cntrl = new biased_inplace_control_block<T>(svr::forward<Args>(args)...);
+        return biased_shared_ptr<T>(cntrl->get(), cntrl);
+    }
+}
+
+#endif
@@ -0,0 +1,375 @@
+#ifndef SVR_DEFERRED_DELETE
+#define SVR_DEFERRED_DELETE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "memory/unique_ptr.h"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+
+/**
+ Moves destruction off the calling thread. Dropping the last owner of a large object graph
+ (a parsed document, a big map) runs every destructor and free inline, which on a request
+ thread shows up as a latency spike. deferred_delete<T> is a deleter that instead hands the
+ pointer to a DeferredReclaimer, whose own thread destroys it a little later.
+
+ a) Handoff is batched per ThreadSlot: a retire appends {pointer, deleter function} to the
+ thread's current batch, plain memory, no atomics. A full batch (BATCH entries) is pushed onto
+ the reclaimer's lock-free stack with one CAS, and the reclaimer takes the whole stack with one
+ exchange, so neither side ever pops a single node and there is no ABA
+ b) Processed batches go back on a free stack the same way (CAS push), and producers take the
+ whole free stack into their slot with an exchange. After warm-up a handoff allocates nothing
+ c) Backpressure: at most maxPendingBatches batches may wait for the reclaimer. Past that the
+ producer destroys its own batch inline, as it would without the reclaimer, so memory stays
+ bounded when destruction cannot keep up, at the price of the latency it was meant to avoid
+ d) A partial batch waits until its thread fills it or calls flush(). drain() flushes the
+ calling thread and waits until everything pushed before has been destroyed, including what
+ those deleters deferred in turn. The destructor stops the thread after destroying everything,
+ partial batches of all slots included, so no thread may retire through it any more
+ e) Deleters run on the reclaimer thread and must be default constructible. Destructors that
+ need the calling thread (thread-confined objects, locks it holds) must not be deferred
+ f) Threads without a ThreadSlot share one extra batch under a spin lock
+ */
+namespace svr
+{
+    class DeferredReclaimer
+    {
+        static constexpr size_t BATCH = 64;
+        static constexpr size_t SHARED_SLOT = ThreadSlot::MAX_SLOTS;
+
+        struct Batch
+        {
+            struct Entry
+            {
+                void* d_ptr;
+                void (*d_deleter)(void*);
+            };
+
+            Entry d_entries[BATCH];
+            size_t d_count{0};
+            Batch* d_next{nullptr};
+
+            void destroyAll()
+            {
+                for(size_t i = 0; i < d_count; ++i)
+                {
+                    d_entries[i].d_deleter(d_entries[i].d_ptr);
+                }
+                d_count = 0;
+            }
+        };
+
+        struct alignas(SVR_CACHELINE_SIZE) Slot
+        {
+            Batch* d_current{nullptr};
+            // Private stack of empty batches taken from d_free
+            Batch* d_spare{nullptr};
+            // Batches pushed to the reclaimer from this slot
+            uint64_t d_handedOver{0};
+        };
+
+        private:
+            const uint64_t d_maxPending;
+            svr::unique_ptr<Slot[]> d_slots;
+            SpinLock<> d_sharedLock;
+            alignas(SVR_CACHELINE_SIZE) std::atomic<Batch*> d_queue{nullptr};
+            alignas(SVR_CACHELINE_SIZE) std::atomic<Batch*> d_free{nullptr};
+            alignas(SVR_CACHELINE_SIZE) std::atomic<uint64_t> d_pushed{0};
+            alignas(SVR_CACHELINE_SIZE) std::atomic<uint64_t> d_done{0};
+            std::atomic<bool> d_stopping{false};
+            std::thread d_thread;
+
+            static void push(std::atomic<Batch*>& stack, Batch* batch)
+            {
+                batch->d_next = stack.load(std::memory_order_relaxed);
+                while(!stack.compare_exchange_weak(batch->d_next, batch, std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            // d_done is read first: every batch it counts was counted in d_pushed before it was
+            // pushed, so the difference cannot wrap
+            uint64_t inFlight() const
+            {
+                const uint64_t done = d_done.load(std::memory_order_acquire);
+                return d_pushed.load(std::memory_order_relaxed) - done;
+            }
+
+            Batch* emptyBatch(Slot& slot)
+            {
+                if(!slot.d_spare)
+                {
+                    slot.d_spare = d_free.exchange(nullptr, std::memory_order_acquire);
+                }
+                if(Batch* batch = slot.d_spare)
+                {
+                    slot.d_spare = batch->d_next;
+                    batch->d_next = nullptr;
+                    return batch;
+                }
+                return new Batch;
+            }
+
+            // Hand slot's current batch to the reclaimer. When too much is already waiting the
+            // batch is detached and returned instead, for the caller to destroy once it no longer
+            // holds the shared slot's lock: its deleters may retire again
+            [[nodiscard]] Batch* handOver(Slot& slot)
+            {
+                Batch* batch = slot.d_current;
+                if(!batch || batch->d_count == 0)
+                {
+                    return nullptr;
+                }
+                slot.d_current = emptyBatch(slot);
+                if(inFlight() >= d_maxPending) [[unlikely]]
+                {
+                    return batch;
+                }
+                ++slot.d_handedOver;
+                d_pushed.fetch_add(1, std::memory_order_relaxed);
+                // Once pushed the batch belongs to the reclaimer, so remember the old head here
+                Batch* head = d_queue.load(std::memory_order_relaxed);
+                do
+                {
+                    batch->d_next = head;
+                }
+                while(!d_queue.compare_exchange_weak(head, batch, std::memory_order_release, std::memory_order_relaxed));
+                if(!head)
+                {
+                    // The reclaimer may be asleep on an empty queue
+                    d_queue.notify_one();
+                }
+                return nullptr;
+            }
+
+            void destroyInline(Batch* batch)
+            {
+                if(batch)
+                {
+                    batch->destroyAll();
+                    push(d_free, batch);
+                }
+            }
+
+            [[nodiscard]] Batch* retire(Slot& slot, void* ptr, void (*deleter)(void*))
+            {
+                if(!slot.d_current) [[unlikely]]
+                {
+                    slot.d_current = emptyBatch(slot);
+                }
+                Batch* batch = slot.d_current;
+                batch->d_entries[batch->d_count++] = {ptr, deleter};
+                if(batch->d_count == BATCH) [[unlikely]]
+                {
+                    return handOver(slot);
+                }
+                return nullptr;
+            }
+
+            void run()
+            {
+                while(true)
+                {
+                    Batch* batches = d_queue.exchange(nullptr, std::memory_order_acquire);
+                    if(!batches)
+                    {
+                        if(d_stopping.load(std::memory_order_acquire))
+                        {
+                            return;
+                        }
+                        d_queue.wait(nullptr, std::memory_order_acquire);
+                        continue;
+                    }
+                    uint64_t count = 0;
+                    while(batches)
+                    {
+                        // Deleters may defer more objects (a graph owning deferred children),
+                        // which land in this thread's slot. Destroy those and take the batches
+                        // they filled in the same round, until none are left, so d_done only
+                        // moves once whole graphs are gone
+                        const uint64_t handedOver = ownHandedOver();
+                        while(batches)
+                        {
+                            Batch* next = batches->d_next;
+                            batches->destroyAll();
+                            push(d_free, batches);
+                            batches = next;
+                            ++count;
+                        }
+                        destroyOwn();
+                        if(ownHandedOver() != handedOver)
+                        {
+                            batches = d_queue.exchange(nullptr, std::memory_order_acquire);
+                        }
+                    }
+                    // Whole grabs finish in push order, so d_done >= n means the first n
+                    // batches pushed are destroyed
+                    d_done.fetch_add(count, std::memory_order_release);
+                    d_done.notify_all();
+                }
+            }
+
+            template<typename F>
+            auto withSlot(F&& f)
+            {
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    std::lock_guard<SpinLock<>> lock(d_sharedLock);
+                    return f(d_slots[SHARED_SLOT]);
+                }
+                return f(d_slots[slot]);
+            }
+
+            // Reclaimer thread only: batches pushed from its own slot so far
+            uint64_t ownHandedOver()
+            {
+                return withSlot([](Slot& slot) { return slot.d_handedOver; });
+            }
+
+            // Reclaimer thread only: destroy its own partial batch until it stays empty
+            void destroyOwn()
+            {
+                auto detach = [](Slot& slot) -> Batch* {
+                    return slot.d_current && slot.d_current->d_count ? std::exchange(slot.d_current, nullptr) : nullptr;
+                };
+                while(Batch* batch = withSlot(detach))
+                {
+                    destroyInline(batch);
+                }
+            }
+
+        public:
+            static constexpr uint64_t DEFAULT_MAX_PENDING_BATCHES = 1024;
+
+            explicit DeferredReclaimer(uint64_t maxPendingBatches = DEFAULT_MAX_PENDING_BATCHES)
+                : d_maxPending(maxPendingBatches), d_slots(new Slot[ThreadSlot::MAX_SLOTS + 1]), d_thread([this]() { run(); })
+            {
+            }
+
+            DeferredReclaimer(const DeferredReclaimer&) = delete;
+            DeferredReclaimer& operator=(const DeferredReclaimer&) = delete;
+
+            ~DeferredReclaimer()
+            {
+                d_stopping.store(true, std::memory_order_release);
+                // Wake the thread even if nothing was pushed. The empty batch is counted like any
+                // other, the thread adds it to d_done
+                d_pushed.fetch_add(1, std::memory_order_relaxed);
+                push(d_queue, new Batch);
+                d_queue.notify_one();
+                d_thread.join();
+                // The thread may have stopped before taking the wake-up batch. Deleters may
+                // still retire, into a slot or, once a batch fills, the queue, so repeat until
+                // a round finds nothing
+                for(bool destroyed = true; destroyed; )
+                {
+                    destroyed = false;
+                    Batch* batch = d_queue.exchange(nullptr, std::memory_order_acquire);
+                    while(batch)
+                    {
+                        Batch* next = batch->d_next;
+                        destroyed |= batch->d_count != 0;
+                        batch->destroyAll();
+                        delete batch;
+                        batch = next;
+                    }
+                    for(size_t i = 0; i <= ThreadSlot::MAX_SLOTS; ++i)
+                    {
+                        // Detached first, so a deleter retiring here starts a new batch
+                        if(Batch* current = std::exchange(d_slots[i].d_current, nullptr))
+                        {
+                            destroyed |= current->d_count != 0;
+                            current->destroyAll();
+                            delete current;
+                        }
+                    }
+                }
+                for(size_t i = 0; i <= ThreadSlot::MAX_SLOTS; ++i)
+                {
+                    Slot& slot = d_slots[i];
+                    while(Batch* batch = slot.d_spare)
+                    {
+                        slot.d_spare = batch->d_next;
+                        delete batch;
+                    }
+                }
+                Batch* batch = d_free.exchange(nullptr, std::memory_order_acquire);
+                while(batch)
+                {
+                    Batch* next = batch->d_next;
+                    delete batch;
+                    batch = next;
+                }
+            }
+
+            // Reclaimer used by deferred_delete. Drained and stopped during static destruction
+            static DeferredReclaimer& instance()
+            {
+                static DeferredReclaimer s_reclaimer;
+                return s_reclaimer;
+            }
+
+            template<typename T, typename Deleter = std::default_delete<T>>
+            void retire(T* ptr)
+            {
+                if(!ptr)
+                {
+                    return;
+                }
+                void (*deleter)(void*) = [](void* p) { Deleter()(static_cast<T*>(p)); };
+                destroyInline(withSlot([this, ptr, deleter](Slot& slot) { return retire(slot, const_cast<void*>(static_cast<const void*>(ptr)), deleter); }));
+            }
+
+            // Hand the calling thread's partial batch to the reclaimer now
+            void flush()
+            {
+                destroyInline(withSlot([this](Slot& slot) { return handOver(slot); }));
+            }
+
+            // Flush, then wait until everything handed over so far is destroyed
+            void drain()
+            {
+                flush();
+                const uint64_t target = d_pushed.load(std::memory_order_relaxed);
+                uint64_t done = d_done.load(std::memory_order_acquire);
+                while(done < target)
+                {
+                    d_done.wait(done, std::memory_order_acquire);
+                    done = d_done.load(std::memory_order_acquire);
+                }
+            }
+
+            // Batches handed over and not yet destroyed
+            uint64_t pending() const
+            {
+                return inFlight();
+            }
+    };
+
+    // Deleter for svr::unique_ptr and svr::shared_ptr: destroys through Deleter on the
+    // reclaimer's thread instead of the caller's
+    template<typename T, typename Deleter = std::default_delete<T>>
+    struct deferred_delete
+    {
+        void operator()(T* ptr) const
+        {
+            DeferredReclaimer::instance().retire<T, Deleter>(ptr);
+        }
+    };
+
+    // Arrays: Deleter defaults to std::default_delete<T[]>
+    template<typename T, typename Deleter>
+    struct deferred_delete<T[], Deleter>
+    {
+        void operator()(T* ptr) const
+        {
+            DeferredReclaimer::instance().retire<T, Deleter>(ptr);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,330 @@
+#ifndef SVR_EPOCH
+#define SVR_EPOCH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "memory/unique_ptr.h"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+
+/**
+ Epoch-based reclamation (Fraser 2004), the cheaper-to-read alternative to hazard pointers.
+ Readers do not announce individual nodes, they announce that they are inside a critical
+ section that started in some epoch; a node retired in epoch e is freed once the global epoch
+ has reached e + 2, because by then every reader that could have seen it has left.
+
+ a) pin() returns an epoch_guard. The outermost pin of a thread stores the global epoch, with
+ an ACTIVE bit, into its ThreadSlot's record with one seq_cst exchange; nested pins only
+ count. Unpinning is a release store. Inside the guard any number of nodes can be read, so a
+ traversal pays once instead of once per node as with hazard pointers
+ b) Retired nodes go into one of three limbo lists of the calling slot, by the epoch they were
+ retired in. Every RETIRE_THRESHOLD retires the thread tries to advance the global epoch (it
+ succeeds when every pinned record has seen the current one) and frees the lists that are two
+ epochs old. A list that is reused for a new epoch is at least three epochs old and freed first
+ c) Garbage per thread stays around 3 * RETIRE_THRESHOLD only while no thread stays pinned for
+ long: one stalled reader stops the epoch and with it all reclamation. That is the price for
+ the cheap reads; use hazard pointers where readers may block
+ d) Threads without a ThreadSlot share one extra record under a spin lock. It counts how many
+ of them are pinned and announces the epoch of the first, which only ever delays reclamation
+ e) Deleters may retire into the same domain. Lists due for freeing are moved out first and
+ their deleters run last, outside the shared record's lock
+ f) Announcing and scanning order a store before loads of other words. Both sides use seq_cst
+ read-modify-writes for it instead of fences, which ThreadSanitizer does not model. The
+ scanners' loads are seq_cst and the epoch moves by acq_rel CAS, so an unpin happens-before
+ any free that depends on it
+ */
+namespace svr
+{
+    class epoch_guard;
+
+    class epoch_domain
+    {
+        friend class epoch_guard;
+
+        public:
+            static constexpr size_t RETIRE_THRESHOLD = 64;
+
+        private:
+            static constexpr uint64_t ACTIVE = 1;
+            static constexpr size_t SHARED_RECORD = ThreadSlot::MAX_SLOTS;
+
+            struct Retired
+            {
+                void* d_ptr;
+                void (*d_deleter)(void*);
+            };
+
+            struct Limbo
+            {
+                uint64_t d_epoch{0};
+                std::vector<Retired> d_objects;
+            };
+
+            struct alignas(SVR_CACHELINE_SIZE) Record
+            {
+                // epoch * 2 | ACTIVE while pinned, 0 otherwise
+                std::atomic<uint64_t> d_local{0};
+                // Below here only touched by the slot's owner (the shared record: under the lock)
+                size_t d_depth{0};
+                size_t d_sinceAdvance{0};
+                Limbo d_limbo[3];
+            };
+
+            alignas(SVR_CACHELINE_SIZE) std::atomic<uint64_t> d_epoch{0};
+            svr::unique_ptr<Record[]> d_records;
+            SpinLock<> d_sharedLock;
+
+            // Move a limbo list's objects into garbage. Deleters never run on a limbo list
+            // itself: they may retire into this domain, even into the same list
+            static void take(Limbo& limbo, std::vector<Retired>& garbage)
+            {
+                if(garbage.empty())
+                {
+                    garbage.swap(limbo.d_objects);
+                    return;
+                }
+                garbage.insert(garbage.end(), limbo.d_objects.begin(), limbo.d_objects.end());
+                limbo.d_objects.clear();
+            }
+
+            static void free(std::vector<Retired>& garbage)
+            {
+                for(Retired& retired : garbage)
+                {
+                    retired.d_deleter(retired.d_ptr);
+                }
+                garbage.clear();
+            }
+
+            void announce(Record& record)
+            {
+                // The announcement must be visible before the first read of the structure
+                record.d_local.exchange(d_epoch.load(std::memory_order_relaxed) << 1 | ACTIVE, std::memory_order_seq_cst);
+            }
+
+            void enter()
+            {
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    std::lock_guard<SpinLock<>> lock(d_sharedLock);
+                    if(d_records[SHARED_RECORD].d_depth++ == 0)
+                    {
+                        announce(d_records[SHARED_RECORD]);
+                    }
+                    return;
+                }
+                Record& record = d_records[slot];
+                if(record.d_depth++ == 0)
+                {
+                    announce(record);
+                }
+            }
+
+            void leave()
+            {
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    std::lock_guard<SpinLock<>> lock(d_sharedLock);
+                    if(--d_records[SHARED_RECORD].d_depth == 0)
+                    {
+                        d_records[SHARED_RECORD].d_local.store(0, std::memory_order_release);
+                    }
+                    return;
+                }
+                Record& record = d_records[slot];
+                if(--record.d_depth == 0)
+                {
+                    record.d_local.store(0, std::memory_order_release);
+                }
+            }
+
+            // Move the global epoch on if every pinned thread has seen the current one
+            void tryAdvance()
+            {
+                // Pairs with the exchange in announce(): a reader this scan misses sees the
+                // current epoch or a later one
+                uint64_t epoch = d_epoch.fetch_add(0, std::memory_order_seq_cst);
+                auto lagging = [epoch](const Record& record) {
+                    const uint64_t local = record.d_local.load(std::memory_order_seq_cst);
+                    return (local & ACTIVE) && (local >> 1) != epoch;
+                };
+                for(size_t i = 0, used = ThreadSlot::high_water(); i < used; ++i)
+                {
+                    if(lagging(d_records[i]))
+                    {
+                        return;
+                    }
+                }
+                if(lagging(d_records[SHARED_RECORD]))
+                {
+                    return;
+                }
+                d_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+            }
+
+            // What may be freed goes into garbage; the caller frees it once it no longer holds
+            // the shared lock
+            void retire(Record& record, Retired retired, std::vector<Retired>& garbage)
+            {
+                uint64_t epoch = d_epoch.load(std::memory_order_acquire);
+                Limbo& limbo = record.d_limbo[epoch % 3];
+                if(limbo.d_epoch != epoch)
+                {
+                    // Retired three or more epochs ago
+                    take(limbo, garbage);
+                    limbo.d_epoch = epoch;
+                }
+                limbo.d_objects.push_back(retired);
+                if(++record.d_sinceAdvance >= RETIRE_THRESHOLD) [[unlikely]]
+                {
+                    record.d_sinceAdvance = 0;
+                    collect(record, garbage);
+                }
+            }
+
+            void collect(Record& record, std::vector<Retired>& garbage)
+            {
+                tryAdvance();
+                const uint64_t epoch = d_epoch.load(std::memory_order_acquire);
+                for(Limbo& limbo : record.d_limbo)
+                {
+                    if(limbo.d_epoch + 2 <= epoch)
+                    {
+                        take(limbo, garbage);
+                    }
+                }
+            }
+
+        public:
+            epoch_domain() : d_records(new Record[ThreadSlot::MAX_SLOTS + 1]) {}
+
+            epoch_domain(const epoch_domain&) = delete;
+            epoch_domain& operator=(const epoch_domain&) = delete;
+
+            // No thread may be pinned any more. Deleters may still retire, so this repeats until
+            // every limbo list stays empty
+            ~epoch_domain()
+            {
+                std::vector<Retired> garbage;
+                do
+                {
+                    free(garbage);
+                    for(size_t i = 0; i <= ThreadSlot::MAX_SLOTS; ++i)
+                    {
+                        for(Limbo& limbo : d_records[i].d_limbo)
+                        {
+                            take(limbo, garbage);
+                        }
+                    }
+                } while(!garbage.empty());
+            }
+
+            // Domain used when none is given. Lives until static destruction
+            static epoch_domain& default_domain()
+            {
+                static epoch_domain s_domain;
+                return s_domain;
+            }
+
+            // Pointers read from the structure while the guard lives stay valid until it dies
+            epoch_guard pin();
+
+            // ptr must already be unreachable for new readers. Deleter is default constructed
+            // when ptr is freed. May be called pinned or not
+            template<typename T, typename Deleter = std::default_delete<T>>
+            void retire(T* ptr)
+            {
+                Retired retired{const_cast<void*>(static_cast<const void*>(ptr)), [](void* p) { Deleter()(static_cast<T*>(p)); }};
+                std::vector<Retired> garbage;
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    {
+                        std::lock_guard<SpinLock<>> lock(d_sharedLock);
+                        retire(d_records[SHARED_RECORD], retired, garbage);
+                    }
+                    free(garbage);
+                    return;
+                }
+                retire(d_records[slot], retired, garbage);
+                free(garbage);
+            }
+
+            // Try to advance and free what the calling thread retired, instead of waiting for
+            // the next threshold. Each call moves the epoch at most one step
+            void reclaim()
+            {
+                std::vector<Retired> garbage;
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID)
+                {
+                    {
+                        std::lock_guard<SpinLock<>> lock(d_sharedLock);
+                        collect(d_records[SHARED_RECORD], garbage);
+                    }
+                    free(garbage);
+                    return;
+                }
+                collect(d_records[slot], garbage);
+                free(garbage);
+            }
+
+            // Retired but not yet freed by the calling thread
+            size_t pending() const
+            {
+                const size_t slot = ThreadSlot::id();
+                const Record& record = d_records[slot == ThreadSlot::INVALID ? SHARED_RECORD : slot];
+                size_t count = 0;
+                for(const Limbo& limbo : record.d_limbo)
+                {
+                    count += limbo.d_objects.size();
+                }
+                return count;
+            }
+
+            uint64_t epoch() const
+            {
+                return d_epoch.load(std::memory_order_relaxed);
+            }
+    };
+
+    // Critical section of an epoch_domain. Stays on the thread that created it
+    class epoch_guard
+    {
+        private:
+            epoch_domain* d_domain;
+
+        public:
+            explicit epoch_guard(epoch_domain& domain = epoch_domain::default_domain()) : d_domain(&domain)
+            {
+                d_domain->enter();
+            }
+            epoch_guard(const epoch_guard&) = delete;
+            epoch_guard& operator=(const epoch_guard&) = delete;
+            epoch_guard(epoch_guard&& other) noexcept : d_domain(other.d_domain)
+            {
+                other.d_domain = nullptr;
+            }
+            epoch_guard& operator=(epoch_guard&&) = delete;
+            ~epoch_guard()
+            {
+                if(d_domain)
+                {
+                    d_domain->leave();
+                }
+            }
+    };
+
+    inline epoch_guard epoch_domain::pin()
+    {
+        return epoch_guard(*this);
+    }
+}
+
+#endif
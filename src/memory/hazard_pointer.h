@@ -0,0 +1,386 @@
+#ifndef SVR_HAZARD_POINTER
+#define SVR_HAZARD_POINTER
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "memory/unique_ptr.h"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+
+/**
+ Hazard pointers (Michael 2004) for lock-free structures that unlink nodes while other threads
+ may still be reading them. A reader announces the node it is about to dereference; a writer
+ that unlinked a node retires it, and it is freed only once no announcement points at it.
+
+ a) Each ThreadSlot owns HAZARDS_PER_THREAD announcements on one cache line of the domain,
+ written only by that thread. A hazard_pointer handle claims one of them with a plain bitmask.
+ Threads without a ThreadSlot, or that hold more handles than that, claim one of
+ SHARED_HAZARDS extra announcements with an atomic exchange
+ b) protect() is the usual store-then-reload: the announcement and the reload of the source are
+ a store and a load on different words, so both are seq_cst. The scan pairs with it through a
+ seq_cst read-modify-write of the domain and seq_cst loads of the announcements, not a fence,
+ which ThreadSanitizer does not model. Once the reload still sees the same pointer the node
+ cannot be freed until the announcement is reset
+ c) retire() appends to a retire list owned by the calling ThreadSlot. When it reaches twice the
+ number of announcements that may be in use, the thread scans: it collects every announcement,
+ sorts them and frees whatever is not in the list. At most one node per announcement survives a
+ scan, so each scan frees at least half the list (amortized O(1) per retire) and no thread
+ ever holds more than about 3 * H retired nodes, whatever other threads do
+ d) A retire list is left to whichever thread gets the slot next, and the domain frees whatever
+ remains when it is destroyed. Deleters are stateless and run on the retiring thread. They may
+ retire into the same domain: a list is swapped out before its deleters run, and the shared
+ list's lock is not held while they do
+ e) Handles belong to the thread that made them
+ */
+namespace svr
+{
+    class hazard_pointer;
+
+    class hazard_pointer_domain
+    {
+        friend class hazard_pointer;
+
+        public:
+            static constexpr size_t HAZARDS_PER_THREAD = 4;
+            static constexpr size_t SHARED_HAZARDS = 64;
+
+        private:
+            struct Retired
+            {
+                void* d_ptr;
+                void (*d_deleter)(void*);
+            };
+
+            struct alignas(SVR_CACHELINE_SIZE) Record
+            {
+                std::atomic<const void*> d_hazards[HAZARDS_PER_THREAD]{};
+                // Below here only touched by the slot's owner
+                unsigned d_used{0};
+                std::vector<Retired> d_retired;
+            };
+
+            struct alignas(SVR_CACHELINE_SIZE) SharedHazard
+            {
+                std::atomic<bool> d_claimed{false};
+                std::atomic<const void*> d_hazard{nullptr};
+            };
+
+            // One per ThreadSlot, plus the retire list of threads without one
+            svr::unique_ptr<Record[]> d_records;
+            svr::unique_ptr<SharedHazard[]> d_shared;
+            SpinLock<> d_sharedLock;
+            // Only bumped to order the start of a scan after the unlinks before it
+            std::atomic<size_t> d_scans{0};
+
+            static size_t threshold()
+            {
+                return 2 * (ThreadSlot::high_water() * HAZARDS_PER_THREAD + SHARED_HAZARDS);
+            }
+
+            // Frees the entries no announcement protects and leaves the rest in retired
+            void scan(std::vector<Retired>& retired)
+            {
+                d_scans.fetch_add(1, std::memory_order_seq_cst);
+                std::vector<const void*> hazards;
+                hazards.reserve(ThreadSlot::high_water() * HAZARDS_PER_THREAD + SHARED_HAZARDS);
+                for(size_t i = 0, used = ThreadSlot::high_water(); i < used; ++i)
+                {
+                    for(const std::atomic<const void*>& hazard : d_records[i].d_hazards)
+                    {
+                        if(const void* ptr = hazard.load(std::memory_order_seq_cst))
+                        {
+                            hazards.push_back(ptr);
+                        }
+                    }
+                }
+                for(size_t i = 0; i < SHARED_HAZARDS; ++i)
+                {
+                    if(const void* ptr = d_shared[i].d_hazard.load(std::memory_order_seq_cst))
+                    {
+                        hazards.push_back(ptr);
+                    }
+                }
+                std::sort(hazards.begin(), hazards.end());
+                size_t kept = 0;
+                for(size_t i = 0; i < retired.size(); ++i)
+                {
+                    if(std::binary_search(hazards.begin(), hazards.end(), retired[i].d_ptr))
+                    {
+                        retired[kept++] = retired[i];
+                    }
+                    else
+                    {
+                        retired[i].d_deleter(retired[i].d_ptr);
+                    }
+                }
+                retired.resize(kept);
+            }
+
+            // Scan a retire list that deleters may append to: the list is swapped out first, so
+            // a deleter that retires into this domain starts a fresh one instead of growing the
+            // vector being scanned
+            void scanList(std::vector<Retired>& list)
+            {
+                std::vector<Retired> retired;
+                retired.swap(list);
+                scan(retired);
+                keep(list, retired);
+            }
+
+            // Put the survivors of a scan back into list, reusing the buffer when nothing was added
+            static void keep(std::vector<Retired>& list, std::vector<Retired>& kept)
+            {
+                if(list.empty())
+                {
+                    list.swap(kept);
+                    return;
+                }
+                list.insert(list.end(), kept.begin(), kept.end());
+            }
+
+            // Threads without a ThreadSlot share one list under d_sharedLock. The scan runs
+            // without the lock, so a deleter can retire again without deadlocking
+            void scanShared(bool onlyAtThreshold)
+            {
+                std::vector<Retired>& list = d_records[ThreadSlot::MAX_SLOTS].d_retired;
+                std::vector<Retired> retired;
+                {
+                    std::lock_guard<SpinLock<>> lock(d_sharedLock);
+                    if(onlyAtThreshold && list.size() < threshold())
+                    {
+                        return;
+                    }
+                    retired.swap(list);
+                }
+                scan(retired);
+                std::lock_guard<SpinLock<>> lock(d_sharedLock);
+                keep(list, retired);
+            }
+
+            void retire(Retired retired)
+            {
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    {
+                        std::lock_guard<SpinLock<>> lock(d_sharedLock);
+                        d_records[ThreadSlot::MAX_SLOTS].d_retired.push_back(retired);
+                    }
+                    scanShared(true);
+                    return;
+                }
+                std::vector<Retired>& list = d_records[slot].d_retired;
+                list.push_back(retired);
+                if(list.size() >= threshold()) [[unlikely]]
+                {
+                    scanList(list);
+                }
+            }
+
+        public:
+            hazard_pointer_domain()
+                : d_records(new Record[ThreadSlot::MAX_SLOTS + 1]), d_shared(new SharedHazard[SHARED_HAZARDS])
+            {
+            }
+
+            hazard_pointer_domain(const hazard_pointer_domain&) = delete;
+            hazard_pointer_domain& operator=(const hazard_pointer_domain&) = delete;
+
+            // No thread may hold a hazard_pointer of this domain any more. Deleters may still
+            // retire, so this repeats until every list stays empty
+            ~hazard_pointer_domain()
+            {
+                for(bool freed = true; freed; )
+                {
+                    freed = false;
+                    for(size_t i = 0; i <= ThreadSlot::MAX_SLOTS; ++i)
+                    {
+                        std::vector<Retired> retired;
+                        retired.swap(d_records[i].d_retired);
+                        for(Retired& r : retired)
+                        {
+                            r.d_deleter(r.d_ptr);
+                        }
+                        freed |= !retired.empty();
+                    }
+                }
+            }
+
+            // Domain used when none is given. Lives until static destruction
+            static hazard_pointer_domain& default_domain()
+            {
+                static hazard_pointer_domain s_domain;
+                return s_domain;
+            }
+
+            hazard_pointer make_hazard_pointer();
+
+            // ptr must already be unreachable for new readers. Deleter is default constructed
+            // when ptr is freed
+            template<typename T, typename Deleter = std::default_delete<T>>
+            void retire(T* ptr)
+            {
+                retire(Retired{const_cast<void*>(static_cast<const void*>(ptr)), [](void* p) { Deleter()(static_cast<T*>(p)); }});
+            }
+
+            // Scan the calling thread's retire list now instead of at the next threshold
+            void reclaim()
+            {
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID)
+                {
+                    scanShared(false);
+                    return;
+                }
+                scanList(d_records[slot].d_retired);
+            }
+
+            // Retired but not yet freed by the calling thread
+            size_t pending() const
+            {
+                const size_t slot = ThreadSlot::id();
+                return d_records[slot == ThreadSlot::INVALID ? ThreadSlot::MAX_SLOTS : slot].d_retired.size();
+            }
+    };
+
+    // One announcement. Cheap to keep around: make one per traversal cursor, not per node
+    class hazard_pointer
+    {
+        friend class hazard_pointer_domain;
+
+        private:
+            std::atomic<const void*>* d_hazard{nullptr};
+            // Owner's bitmask and bit, or the claim flag of a shared announcement
+            unsigned* d_used{nullptr};
+            unsigned d_bit{0};
+            std::atomic<bool>* d_claimed{nullptr};
+
+        public:
+            hazard_pointer() = default;
+            hazard_pointer(const hazard_pointer&) = delete;
+            hazard_pointer& operator=(const hazard_pointer&) = delete;
+            hazard_pointer(hazard_pointer&& other) noexcept
+                : d_hazard(other.d_hazard), d_used(other.d_used), d_bit(other.d_bit), d_claimed(other.d_claimed)
+            {
+                other.d_hazard = nullptr;
+            }
+            hazard_pointer& operator=(hazard_pointer&& other) noexcept
+            {
+                hazard_pointer(static_cast<hazard_pointer&&>(other)).swap(*this);
+                return *this;
+            }
+            ~hazard_pointer()
+            {
+                if(!d_hazard)
+                {
+                    return;
+                }
+                d_hazard->store(nullptr, std::memory_order_release);
+                if(d_claimed)
+                {
+                    d_claimed->store(false, std::memory_order_release);
+                }
+                else
+                {
+                    *d_used &= ~(1u << d_bit);
+                }
+            }
+
+            bool empty() const
+            {
+                return !d_hazard;
+            }
+
+            // Announce ptr and check that src still holds it. On failure ptr is updated to the
+            // current value of src and nothing stays announced
+            template<typename T>
+            bool try_protect(T*& ptr, const std::atomic<T*>& src)
+            {
+                T* expected = ptr;
+                d_hazard->store(expected, std::memory_order_seq_cst);
+                ptr = src.load(std::memory_order_seq_cst);
+                if(ptr != expected)
+                {
+                    d_hazard->store(nullptr, std::memory_order_release);
+                    return false;
+                }
+                return true;
+            }
+
+            // Pointer read from src that stays safe to dereference until the next protect or
+            // reset_protection
+            template<typename T>
+            T* protect(const std::atomic<T*>& src)
+            {
+                T* ptr = src.load(std::memory_order_relaxed);
+                while(!try_protect(ptr, src));
+                return ptr;
+            }
+
+            // Announce a pointer the caller already knows to be live (e.g. protected by another
+            // handle), or stop announcing with nullptr
+            template<typename T>
+            void reset_protection(const T* ptr)
+            {
+                d_hazard->store(ptr, std::memory_order_seq_cst);
+            }
+
+            void reset_protection()
+            {
+                d_hazard->store(nullptr, std::memory_order_release);
+            }
+
+            void swap(hazard_pointer& other) noexcept
+            {
+                std::swap(d_hazard, other.d_hazard);
+                std::swap(d_used, other.d_used);
+                std::swap(d_bit, other.d_bit);
+                std::swap(d_claimed, other.d_claimed);
+            }
+    };
+
+    inline hazard_pointer hazard_pointer_domain::make_hazard_pointer()
+    {
+        hazard_pointer handle;
+        const size_t slot = ThreadSlot::id();
+        if(slot != ThreadSlot::INVALID) [[likely]]
+        {
+            Record& record = d_records[slot];
+            const unsigned free = ~record.d_used & ((1u << HAZARDS_PER_THREAD) - 1);
+            if(free)
+            {
+                handle.d_bit = static_cast<unsigned>(std::countr_zero(free));
+                handle.d_used = &record.d_used;
+                handle.d_hazard = &record.d_hazards[handle.d_bit];
+                record.d_used |= 1u << handle.d_bit;
+                return handle;
+            }
+        }
+        spin_until([this, &handle]() {
+            for(size_t i = 0; i < SHARED_HAZARDS; ++i)
+            {
+                SharedHazard& shared = d_shared[i];
+                if(!shared.d_claimed.load(std::memory_order_relaxed) && !shared.d_claimed.exchange(true, std::memory_order_acquire))
+                {
+                    handle.d_claimed = &shared.d_claimed;
+                    handle.d_hazard = &shared.d_hazard;
+                    return true;
+                }
+            }
+            return false;
+        });
+        return handle;
+    }
+
+    inline hazard_pointer make_hazard_pointer(hazard_pointer_domain& domain = hazard_pointer_domain::default_domain())
+    {
+        return domain.make_hazard_pointer();
+    }
+}
+
+#endif
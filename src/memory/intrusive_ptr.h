@@ -0,0 +1,218 @@
+#ifndef SVR_INTRUSIVE_PTR
+#define SVR_INTRUSIVE_PTR
+
+#include "atomic"
+#include "cstddef"
+#include "type_traits"
+#include "utility"
+#include "templates/forward.h"
+
+/**
+ Reference-counted pointer whose count lives inside the object. No control block: one
+ allocation, the count shares a cache line with the object's own hot fields, and the pointer is
+ 8 bytes, so it fits in a register, a queue slot or a C callback's void*.
+ a) T provides two free functions found by ADL, intrusive_ptr_add_ref(T*) and
+ intrusive_ptr_release(T*). Deriving from intrusive_ref_counter<T, Policy> provides both
+ b) Policy picks the count: ThreadSafeRefCount (atomic, relaxed increment, acq_rel decrement,
+ same as shared_ptr) or ThreadUnsafeRefCount (plain integer, for objects that stay on one
+ thread)
+ c) Raw pointers can leave and re-enter ownership explicitly: detach() hands the reference to
+ the caller without touching the count, adopt(p) takes over such a reference, retain(p) takes a
+ new one. A pointer pushed through an SPSC queue as T* is detach() on one side and adopt() on
+ the other, so the count is not touched on the way
+ */
+namespace svr
+{
+    struct ThreadSafeRefCount
+    {
+        using count_type = std::atomic<unsigned long>;
+
+        static void increment(count_type &count)
+        {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // True when that was the last reference
+        static bool decrement(count_type &count)
+        {
+            return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+
+        static unsigned long load(const count_type &count)
+        {
+            return count.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct ThreadUnsafeRefCount
+    {
+        using count_type = unsigned long;
+
+        static void increment(count_type &count)
+        {
+            ++count;
+        }
+
+        static bool decrement(count_type &count)
+        {
+            return --count == 0;
+        }
+
+        static unsigned long load(const count_type &count)
+        {
+            return count;
+        }
+    };
+
+    // Base class that embeds the count. Copies of the object start with a fresh count, the
+    // references belong to the original
+    template <typename Derived, typename Policy = ThreadSafeRefCount>
+    class intrusive_ref_counter
+    {
+    private:
+        mutable typename Policy::count_type d_refCnt;
+
+    protected:
+        intrusive_ref_counter() : d_refCnt(0) {}
+        intrusive_ref_counter(const intrusive_ref_counter &) : d_refCnt(0) {}
+        intrusive_ref_counter &operator=(const intrusive_ref_counter &)
+        {
+            return *this;
+        }
+        ~intrusive_ref_counter() = default;
+
+    public:
+        unsigned long use_count() const
+        {
+            return Policy::load(d_refCnt);
+        }
+
+        friend void intrusive_ptr_add_ref(const intrusive_ref_counter *p)
+        {
+            Policy::increment(p->d_refCnt);
+        }
+
+        friend void intrusive_ptr_release(const intrusive_ref_counter *p)
+        {
+            if (Policy::decrement(p->d_refCnt))
+            {
+                delete static_cast<const Derived *>(p);
+            }
+        }
+    };
+
+    template <typename T>
+    class intrusive_ptr
+    {
+    private:
+        T *d_ptr;
+
+        struct adopt_t
+        {
+        };
+
+        intrusive_ptr(T *ptr, adopt_t) : d_ptr(ptr) {}
+
+    public:
+        intrusive_ptr() : d_ptr(nullptr) {}
+        intrusive_ptr(std::nullptr_t) : d_ptr(nullptr) {}
+        // Takes a new reference, like retain()
+        explicit intrusive_ptr(T *ptr) : d_ptr(ptr)
+        {
+            if (d_ptr)
+            {
+                intrusive_ptr_add_ref(d_ptr);
+            }
+        }
+        intrusive_ptr(const intrusive_ptr &other) : intrusive_ptr(other.d_ptr) {}
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+        intrusive_ptr(const intrusive_ptr<U> &other) : intrusive_ptr(other.get()) {}
+        intrusive_ptr(intrusive_ptr &&other) noexcept : d_ptr(other.d_ptr)
+        {
+            other.d_ptr = nullptr;
+        }
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+        intrusive_ptr(intrusive_ptr<U> &&other) noexcept : d_ptr(other.detach()) {}
+        intrusive_ptr &operator=(const intrusive_ptr &other)
+        {
+            intrusive_ptr(other).swap(*this);
+            return *this;
+        }
+        intrusive_ptr &operator=(intrusive_ptr &&other) noexcept
+        {
+            intrusive_ptr(static_cast<intrusive_ptr &&>(other)).swap(*this);
+            return *this;
+        }
+        ~intrusive_ptr()
+        {
+            if (d_ptr)
+            {
+                intrusive_ptr_release(d_ptr);
+            }
+        }
+
+        // Take over a reference the caller owns (e.g. from detach()), count unchanged
+        static intrusive_ptr adopt(T *ptr)
+        {
+            return intrusive_ptr(ptr, adopt_t());
+        }
+        // Take a new reference to ptr
+        static intrusive_ptr retain(T *ptr)
+        {
+            return intrusive_ptr(ptr);
+        }
+        // Hand the reference to the caller, who must give it back through adopt() or
+        // intrusive_ptr_release()
+        [[nodiscard]] T *detach()
+        {
+            T *ptr = d_ptr;
+            d_ptr = nullptr;
+            return ptr;
+        }
+
+        void reset()
+        {
+            intrusive_ptr().swap(*this);
+        }
+        void swap(intrusive_ptr &other) noexcept
+        {
+            std::swap(d_ptr, other.d_ptr);
+        }
+        T *get() const
+        {
+            return d_ptr;
+        }
+        T *operator->() const
+        {
+            return d_ptr;
+        }
+        T &operator*() const
+        {
+            return *d_ptr;
+        }
+        explicit operator bool() const
+        {
+            return d_ptr;
+        }
+    };
+
+    template <typename T, typename U>
+    bool operator==(const intrusive_ptr<T> &a, const intrusive_ptr<U> &b)
+    {
+        return a.get() == b.get();
+    }
+
+    template <typename T>
+    bool operator==(const intrusive_ptr<T> &a, std::nullptr_t)
+    {
+        return !a;
+    }
+
+    template <typename T, typename... Args>
+    intrusive_ptr<T> make_intrusive(Args &&...args)
+    {
+        return intrusive_ptr<T>(new T(svr::forward<Args>(args)...));
+    }
+}
+
+#endif
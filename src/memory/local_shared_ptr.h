@@ -0,0 +1,264 @@
+#ifndef SVR_LOCAL_SHARED_PTR
+#define SVR_LOCAL_SHARED_PTR
+
+#include "cstddef"
+#include "cstdio"
+#include "cstdlib"
+#include "memory"
+#include "new"
+#include "thread"
+#include "type_traits"
+#include "utility"
+#include "templates/forward.h"
+#include "templates/move.h"
+
+// Debug builds check that every count change happens on the thread that created the object.
+// Define SVR_LOCAL_SHARED_PTR_CHECKS to 0 or 1 to override
+#ifndef SVR_LOCAL_SHARED_PTR_CHECKS
+#ifdef NDEBUG
+#define SVR_LOCAL_SHARED_PTR_CHECKS 0
+#else
+#define SVR_LOCAL_SHARED_PTR_CHECKS 1
+#endif
+#endif
+
+/**
+ shared_ptr for objects that never leave one thread (graph nodes, parse trees, per-request
+ state). Same layout as svr::shared_ptr, but the count is a plain long, so copies and
+ destruction are an ordinary increment and decrement instead of a locked RMW with acq_rel
+ ordering.
+ a) Not thread-safe in any way: two threads touching copies of the same object race on the
+ count. That is the point, and also the danger, hence the debug check. With
+ SVR_LOCAL_SHARED_PTR_CHECKS every copy and release compares the calling thread with the
+ thread that created the block and aborts on a mismatch
+ b) Strong count only, no weak_ptr and no allocator. Object lifetime is the only thing the
+ block manages, so it stays two words plus the vtable pointer
+ c) make_local_shared puts the count and the object in one allocation, like make_shared
+ */
+namespace svr
+{
+    class local_control_block
+    {
+    private:
+        long d_count;
+#if SVR_LOCAL_SHARED_PTR_CHECKS
+        std::thread::id d_owner;
+#endif
+
+        void checkOwner() const
+        {
+#if SVR_LOCAL_SHARED_PTR_CHECKS
+            if (d_owner != std::this_thread::get_id()) [[unlikely]]
+            {
+                std::fputs("svr::local_shared_ptr used from a thread other than the one that created it\n", stderr);
+                std::abort();
+            }
+#endif
+        }
+
+    protected:
+        local_control_block() : d_count(1)
+        {
+#if SVR_LOCAL_SHARED_PTR_CHECKS
+            d_owner = std::this_thread::get_id();
+#endif
+        }
+
+        virtual ~local_control_block() = default;
+
+        // Destroys the object and frees the block
+        virtual void destroy() = 0;
+
+    public:
+        void retain()
+        {
+            checkOwner();
+            ++d_count;
+        }
+
+        void release()
+        {
+            checkOwner();
+            if (--d_count == 0)
+            {
+                destroy();
+            }
+        }
+
+        long use_count() const
+        {
+            return d_count;
+        }
+    };
+
+    template <typename TYPE, typename Deleter = std::default_delete<TYPE>>
+    class local_pointer_control_block : public local_control_block
+    {
+    private:
+        TYPE *d_instance;
+        [[no_unique_address]] Deleter d_deleter;
+
+    protected:
+        void destroy() override
+        {
+            d_deleter(d_instance);
+            delete this;
+        }
+
+    public:
+        local_pointer_control_block(TYPE *instance, Deleter deleter) : d_instance(instance), d_deleter(svr::move(deleter))
+        {
+        }
+    };
+
+    template <typename TYPE>
+    class local_inplace_control_block : public local_control_block
+    {
+    private:
+        alignas(TYPE) unsigned char d_storage[sizeof(TYPE)];
+
+    protected:
+        void destroy() override
+        {
+            get()->~TYPE();
+            delete this;
+        }
+
+    public:
+        template <typename... Args>
+        explicit local_inplace_control_block(Args &&...args)
+        {
+            ::new (static_cast<void *>(d_storage)) TYPE(svr::forward<Args>(args)...);
+        }
+
+        TYPE *get()
+        {
+            return std::launder(reinterpret_cast<TYPE *>(d_storage));
+        }
+    };
+
+    template <typename TYPE>
+    class local_shared_ptr
+    {
+    private:
+        TYPE *d_ptr;
+        svr::local_control_block *d_cntrl;
+
+        template <typename U>
+        friend class local_shared_ptr;
+
+        template <typename T, typename... Args>
+        friend local_shared_ptr<T> make_local_shared(Args &&...args);
+
+        struct adopt_t
+        {
+        };
+
+        local_shared_ptr(TYPE *ptr, svr::local_control_block *cntrl, adopt_t) : d_ptr(ptr), d_cntrl(cntrl) {}
+
+        template <typename Deleter>
+        static svr::local_control_block *makeBlock(TYPE *instance, Deleter &deleter)
+        {
+            try
+            {
+                return new local_pointer_control_block<TYPE, Deleter>(instance, deleter);
+            }
+            catch (...)
+            {
+                deleter(instance);
+                throw;
+            }
+        }
+
+    public:
+        local_shared_ptr() : d_ptr(nullptr), d_cntrl(nullptr) {}
+        local_shared_ptr(std::nullptr_t) : local_shared_ptr() {}
+        explicit local_shared_ptr(TYPE *instance) : local_shared_ptr(instance, std::default_delete<TYPE>()) {}
+        template <typename Deleter, typename = std::enable_if_t<std::is_invocable_v<Deleter &, TYPE *>>>
+        local_shared_ptr(TYPE *instance, Deleter deleter) : d_ptr(instance), d_cntrl(makeBlock(instance, deleter)) {}
+        // Aliasing: shares ownership with other but points at ptr
+        template <typename U>
+        local_shared_ptr(const local_shared_ptr<U> &other, TYPE *ptr) : d_ptr(ptr), d_cntrl(other.d_cntrl)
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->retain();
+            }
+        }
+        local_shared_ptr(const local_shared_ptr &other) : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->retain();
+            }
+        }
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U *, TYPE *>>>
+        local_shared_ptr(const local_shared_ptr<U> &other) : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->retain();
+            }
+        }
+        local_shared_ptr(local_shared_ptr &&other) noexcept : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            other.d_ptr = nullptr;
+            other.d_cntrl = nullptr;
+        }
+        local_shared_ptr &operator=(const local_shared_ptr &other)
+        {
+            local_shared_ptr(other).swap(*this);
+            return *this;
+        }
+        local_shared_ptr &operator=(local_shared_ptr &&other) noexcept
+        {
+            local_shared_ptr(svr::move(other)).swap(*this);
+            return *this;
+        }
+        ~local_shared_ptr()
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->release();
+            }
+        }
+        void reset()
+        {
+            local_shared_ptr().swap(*this);
+        }
+        void swap(local_shared_ptr &other) noexcept
+        {
+            std::swap(d_ptr, other.d_ptr);
+            std::swap(d_cntrl, other.d_cntrl);
+        }
+        TYPE *get() const
+        {
+            return d_ptr;
+        }
+        TYPE *operator->() const
+        {
+            return d_ptr;
+        }
+        TYPE &operator*() const
+        {
+            return *d_ptr;
+        }
+        explicit operator bool() const
+        {
+            return d_ptr;
+        }
+        long use_count() const
+        {
+            return d_cntrl ? d_cntrl->use_count() : 0;
+        }
+    };
+
+    template <typename T, typename... Args>
+    local_shared_ptr<T> make_local_shared(Args &&...args)
+    {
+        auto *cntrl = new local_inplace_control_block<T>(svr::forward<Args>(args)...);
+        return local_shared_ptr<T>(cntrl->get(), cntrl, typename local_shared_ptr<T>::adopt_t());
+    }
+}
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef SVR_MONOTONIC_ARENA
+#define SVR_MONOTONIC_ARENA
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include "multithreading/spinlock/spinlock.h"
+#include "templates/forward.h"
+
+/**
+ Bump-pointer arena for memory that all dies at the same moment (one request, one frame, one
+ parse). An allocation is an align-up and a pointer increment; nothing is freed individually.
+
+ a) Memory comes in blocks from ::operator new, each aligned to a cache line and chained
+ through a small header at its start. A block that runs out is followed by one twice its size
+ (up to MAX_BLOCK_SIZE), or by one just big enough for an oversized request
+ b) reset() rewinds to the first block and keeps the chain, so the next request bumps through
+ memory that is already mapped and probably cached. That is O(1) whatever was allocated.
+ release() gives the blocks back to the system
+ c) Destructors are not run. Objects with non-trivial destructors must be destroyed by their
+ owner (a container does that anyway, ArenaDeleter does it for unique_ptr) before reset()
+ d) Not thread-safe: one arena per thread or per request. ArenaAllocator copies only point at
+ the arena, so a container using it must not outlive the arena's next reset()
+ */
+namespace svr
+{
+    class MonotonicArena
+    {
+        struct alignas(SVR_CACHELINE_SIZE) Block
+        {
+            Block* d_next;
+            size_t d_size;
+
+            unsigned char* begin()
+            {
+                return reinterpret_cast<unsigned char*>(this + 1);
+            }
+
+            unsigned char* end()
+            {
+                return reinterpret_cast<unsigned char*>(this) + d_size;
+            }
+        };
+
+        static constexpr size_t MAX_BLOCK_SIZE = 1 << 20;
+
+        private:
+            Block* d_first{nullptr};
+            Block* d_current{nullptr};
+            unsigned char* d_ptr{nullptr};
+            unsigned char* d_end{nullptr};
+            size_t d_nextBlockSize;
+
+            void use(Block* block)
+            {
+                d_current = block;
+                d_ptr = block->begin();
+                d_end = block->end();
+            }
+
+            // Slow path: move to the next block in the chain that fits, or append a new one
+            void* allocateFromNextBlock(size_t bytes, size_t alignment)
+            {
+                const size_t needed = sizeof(Block) + bytes + (alignment > SVR_CACHELINE_SIZE ? alignment : 0);
+                Block* previous = d_current;
+                // Blocks kept by reset() are reused in order. One that is too small for this
+                // request is skipped, not unlinked: it fits smaller requests after the next reset
+                for(Block* block = d_current ? d_current->d_next : nullptr; block; block = block->d_next)
+                {
+                    previous = block;
+                    if(block->d_size >= needed)
+                    {
+                        use(block);
+                        return allocate(bytes, alignment);
+                    }
+                }
+                size_t size = d_nextBlockSize;
+                while(size < needed)
+                {
+                    size *= 2;
+                }
+                if(d_nextBlockSize < MAX_BLOCK_SIZE)
+                {
+                    d_nextBlockSize *= 2;
+                }
+                Block* block = static_cast<Block*>(::operator new(size, std::align_val_t(SVR_CACHELINE_SIZE)));
+                block->d_next = nullptr;
+                block->d_size = size;
+                if(previous)
+                {
+                    previous->d_next = block;
+                }
+                else
+                {
+                    d_first = block;
+                }
+                use(block);
+                return allocate(bytes, alignment);
+            }
+
+        public:
+            static constexpr size_t DEFAULT_BLOCK_SIZE = 4096;
+
+            // No memory is taken until the first allocation
+            explicit MonotonicArena(size_t initialBlockSize = DEFAULT_BLOCK_SIZE)
+                : d_nextBlockSize(initialBlockSize > 2 * sizeof(Block) ? initialBlockSize : 2 * sizeof(Block))
+            {
+            }
+
+            MonotonicArena(const MonotonicArena&) = delete;
+            MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+            ~MonotonicArena()
+            {
+                release();
+            }
+
+            void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+            {
+                const uintptr_t aligned = (reinterpret_cast<uintptr_t>(d_ptr) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+                // Compared as integers: with no block yet d_ptr and d_end are both null
+                if(aligned + bytes <= reinterpret_cast<uintptr_t>(d_end) && d_ptr) [[likely]]
+                {
+                    d_ptr = reinterpret_cast<unsigned char*>(aligned + bytes);
+                    return reinterpret_cast<void*>(aligned);
+                }
+                return allocateFromNextBlock(bytes, alignment);
+            }
+
+            // Only the most recent allocation is actually given back; anything else waits for
+            // reset(). Lets a vector that grows at the top of the arena reuse its old buffer
+            void deallocate(void* ptr, size_t bytes)
+            {
+                if(static_cast<unsigned char*>(ptr) + bytes == d_ptr)
+                {
+                    d_ptr = static_cast<unsigned char*>(ptr);
+                }
+            }
+
+            template<typename T, typename... Args>
+            T* create(Args&&... args)
+            {
+                return ::new(allocate(sizeof(T), alignof(T))) T(svr::forward<Args>(args)...);
+            }
+
+            // Everything allocated so far becomes invalid. Blocks are kept for reuse
+            void reset()
+            {
+                if(d_first)
+                {
+                    use(d_first);
+                }
+            }
+
+            // Everything allocated so far becomes invalid. Blocks go back to the system
+            void release()
+            {
+                Block* block = d_first;
+                while(block)
+                {
+                    Block* next = block->d_next;
+                    ::operator delete(block, std::align_val_t(SVR_CACHELINE_SIZE));
+                    block = next;
+                }
+                d_first = d_current = nullptr;
+                d_ptr = d_end = nullptr;
+            }
+
+            // Bytes held from the system, used or not
+            size_t capacity() const
+            {
+                size_t total = 0;
+                for(Block* block = d_first; block; block = block->d_next)
+                {
+                    total += block->d_size - sizeof(Block);
+                }
+                return total;
+            }
+    };
+
+    // STL-style allocator over a MonotonicArena. Stateful (one pointer); copies and rebinds
+    // share the arena and compare equal exactly when they do
+    template<typename T>
+    class ArenaAllocator
+    {
+        template<typename U>
+        friend class ArenaAllocator;
+
+        private:
+            MonotonicArena* d_arena;
+
+        public:
+            using value_type = T;
+            // Containers moved or swapped between arenas keep their memory's allocator
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_swap = std::true_type;
+
+            ArenaAllocator(MonotonicArena& arena) : d_arena(&arena) {}
+            template<typename U>
+            ArenaAllocator(const ArenaAllocator<U>& other) : d_arena(other.d_arena) {}
+
+            T* allocate(size_t n)
+            {
+                return static_cast<T*>(d_arena->allocate(n * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T* ptr, size_t n)
+            {
+                d_arena->deallocate(ptr, n * sizeof(T));
+            }
+
+            MonotonicArena& arena() const
+            {
+                return *d_arena;
+            }
+
+            template<typename U>
+            bool operator==(const ArenaAllocator<U>& other) const
+            {
+                return d_arena == other.d_arena;
+            }
+    };
+
+    // Deleter for unique_ptr<T, ArenaDeleter<T>> over MonotonicArena::create: runs the
+    // destructor and leaves the memory to the arena
+    template<typename T>
+    struct ArenaDeleter
+    {
+        void operator()(T* ptr) const
+        {
+            ptr->~T();
+        }
+    };
+}
+
+#endif
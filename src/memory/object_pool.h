@@ -0,0 +1,250 @@
+#ifndef SVR_OBJECT_POOL
+#define SVR_OBJECT_POOL
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include "memory/unique_ptr.h"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+#include "templates/forward.h"
+
+/**
+ Fixed capacity pool of T, carved out of one cache line aligned slab at construction.
+ After that, acquire() and release() never touch malloc.
+
+ a) Every object gets its own cache line (or several), so two objects handed to two
+ threads never false share
+ b) Free objects are tracked by slot index. The global free list is a Treiber stack whose
+ head packs {version, index} into one 64 bit word. The version is bumped on every successful
+ CAS, which is what protects against ABA: a stale head with the right index but old version
+ fails the CAS. This avoids needing a 128 bit CAS (cmpxchg16b / libatomic)
+ c) The "next" links live in a side array of atomics, not inside the object storage. A
+ popper that lost the race may still read the link of a slot that is now in use; with a
+ side array that read is a harmless atomic load instead of a data race on the user object
+ d) In front of the global stack sits a per-thread magazine (indexed by ThreadSlot). Most
+ acquire/release pairs hit only the magazine, which is plain memory owned by one thread.
+ Magazines refill and flush half their size at a time, and a flush pushes the whole
+ batch with a single CAS
+ e) Objects parked in one thread's magazine are invisible to other threads, so size the pool
+ with some slack (up to MAGAZINE_SIZE per thread) if it must never report exhaustion
+ */
+namespace svr
+{
+    template<typename T>
+    class ObjectPool;
+
+    // Deleter returning objects to the pool they came from. Default constructible
+    // so unique_ptr<T, PoolDeleter<T>> keeps its default and nullptr constructors
+    template<typename T>
+    struct PoolDeleter
+    {
+        ObjectPool<T>* d_pool{nullptr};
+
+        void operator()(T* ptr) const
+        {
+            d_pool->release(ptr);
+        }
+    };
+
+    template<typename T>
+    class ObjectPool
+    {
+        static constexpr uint32_t NIL = UINT32_MAX;
+        static constexpr uint32_t MAGAZINE_SIZE = 32;
+        static constexpr size_t SLOT_ALIGN = alignof(T) > SVR_CACHELINE_SIZE ? alignof(T) : SVR_CACHELINE_SIZE;
+        static constexpr size_t SLOT_SIZE = (sizeof(T) + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+
+        struct alignas(SVR_CACHELINE_SIZE) Magazine
+        {
+            uint32_t d_count{0};
+            uint32_t d_items[MAGAZINE_SIZE];
+        };
+
+        private:
+            size_t d_capacity;
+            unsigned char* d_slab;
+            svr::unique_ptr<std::atomic<uint32_t>[]> d_next;
+            svr::unique_ptr<Magazine[]> d_magazines;
+
+            // {version:32, index:32}
+            alignas(SVR_CACHELINE_SIZE) std::atomic<uint64_t> d_head;
+            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<uint64_t>)];
+
+            static uint32_t indexOf(uint64_t head)
+            {
+                return static_cast<uint32_t>(head);
+            }
+
+            static uint64_t nextHead(uint64_t head, uint32_t index)
+            {
+                return ((head >> 32) + 1) << 32 | index;
+            }
+
+            T* slotAt(uint32_t index) const
+            {
+                return reinterpret_cast<T*>(d_slab + index * SLOT_SIZE);
+            }
+
+            uint32_t slotOf(T* ptr) const
+            {
+                return static_cast<uint32_t>((reinterpret_cast<unsigned char*>(ptr) - d_slab) / SLOT_SIZE);
+            }
+
+            uint32_t popGlobal()
+            {
+                uint64_t head = d_head.load(std::memory_order_acquire);
+                while(true)
+                {
+                    uint32_t index = indexOf(head);
+                    if(index == NIL) [[unlikely]]
+                    {
+                        return NIL;
+                    }
+                    uint32_t next = d_next[index].load(std::memory_order_relaxed);
+                    if(d_head.compare_exchange_weak(head, nextHead(head, next), std::memory_order_acquire, std::memory_order_acquire))
+                    {
+                        return index;
+                    }
+                }
+            }
+
+            // Push an already linked chain first -> ... -> last with one CAS
+            void pushGlobal(uint32_t first, uint32_t last)
+            {
+                uint64_t head = d_head.load(std::memory_order_relaxed);
+                do
+                {
+                    d_next[last].store(indexOf(head), std::memory_order_relaxed);
+                } while(!d_head.compare_exchange_weak(head, nextHead(head, first), std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            uint32_t take()
+            {
+                size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    return popGlobal();
+                }
+
+                Magazine& magazine = d_magazines[slot];
+                if(magazine.d_count == 0) [[unlikely]]
+                {
+                    while(magazine.d_count < MAGAZINE_SIZE / 2)
+                    {
+                        uint32_t index = popGlobal();
+                        if(index == NIL)
+                        {
+                            break;
+                        }
+                        magazine.d_items[magazine.d_count++] = index;
+                    }
+                    if(magazine.d_count == 0)
+                    {
+                        return NIL;
+                    }
+                }
+                return magazine.d_items[--magazine.d_count];
+            }
+
+            void give(uint32_t index)
+            {
+                size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    pushGlobal(index, index);
+                    return;
+                }
+
+                Magazine& magazine = d_magazines[slot];
+                if(magazine.d_count == MAGAZINE_SIZE) [[unlikely]]
+                {
+                    // Flush the upper half as one chain
+                    uint32_t first = magazine.d_items[MAGAZINE_SIZE / 2];
+                    for(uint32_t i = MAGAZINE_SIZE / 2; i + 1 < MAGAZINE_SIZE; ++i)
+                    {
+                        d_next[magazine.d_items[i]].store(magazine.d_items[i + 1], std::memory_order_relaxed);
+                    }
+                    pushGlobal(first, magazine.d_items[MAGAZINE_SIZE - 1]);
+                    magazine.d_count = MAGAZINE_SIZE / 2;
+                }
+                magazine.d_items[magazine.d_count++] = index;
+            }
+
+        public:
+            ObjectPool(const ObjectPool&) = delete;
+            ObjectPool(ObjectPool&&) = delete;
+            ObjectPool& operator=(const ObjectPool&) = delete;
+            ObjectPool& operator=(ObjectPool&&) = delete;
+
+            explicit ObjectPool(size_t capacity)
+                : d_capacity(capacity)
+                , d_slab(static_cast<unsigned char*>(::operator new(capacity * SLOT_SIZE, std::align_val_t{SLOT_ALIGN})))
+                , d_next(new std::atomic<uint32_t>[capacity])
+                , d_magazines(new Magazine[ThreadSlot::MAX_SLOTS])
+                , d_head(capacity == 0 ? NIL : 0)
+            {
+                static_assert(std::atomic<uint64_t>::is_always_lock_free);
+                for(size_t i = 0; i < capacity; ++i)
+                {
+                    d_next[i].store(i + 1 == capacity ? NIL : static_cast<uint32_t>(i + 1), std::memory_order_relaxed);
+                }
+            }
+
+            // Objects still checked out are not destroyed, release them first
+            ~ObjectPool()
+            {
+                ::operator delete(d_slab, std::align_val_t{SLOT_ALIGN});
+            }
+
+            // Construct a T in a free slot, nullptr if the pool is exhausted
+            template<typename... Args>
+            T* acquire(Args&&... args)
+            {
+                uint32_t index = take();
+                if(index == NIL) [[unlikely]]
+                {
+                    return nullptr;
+                }
+                if constexpr (std::is_nothrow_constructible_v<T, Args&&...>)
+                {
+                    return new(slotAt(index)) T(svr::forward<Args>(args)...);
+                }
+                else
+                {
+                    try
+                    {
+                        return new(slotAt(index)) T(svr::forward<Args>(args)...);
+                    }
+                    catch(...)
+                    {
+                        give(index);
+                        throw;
+                    }
+                }
+            }
+
+            // Destroy an object obtained from acquire() and return its slot
+            void release(T* ptr)
+            {
+                ptr->~T();
+                give(slotOf(ptr));
+            }
+
+            // Same as acquire(), but owned by a unique_ptr that releases back here
+            template<typename... Args>
+            svr::unique_ptr<T, PoolDeleter<T>> make_unique(Args&&... args)
+            {
+                return svr::unique_ptr<T, PoolDeleter<T>>(acquire(svr::forward<Args>(args)...), PoolDeleter<T>{this});
+            }
+
+            size_t capacity() const
+            {
+                return d_capacity;
+            }
+    };
+}
+
+#endif
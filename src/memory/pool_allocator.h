@@ -0,0 +1,221 @@
+#ifndef SVR_POOL_ALLOCATOR
+#define SVR_POOL_ALLOCATOR
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+
+/**
+ Thread-caching pool of fixed-size blocks, and an STL allocator on top of it. Meant for many
+ short-lived objects of one type (allocate_shared control blocks, list and map nodes).
+
+ a) One pool per (size, alignment), shared by every allocator instance and every rebind to a
+ type of that size, so the allocator is stateless and all instances compare equal
+ b) In front of the pool sits a magazine per ThreadSlot, plain memory owned by one thread, so
+ most allocate/deallocate pairs are a pointer pop/push with no atomics at all. Free blocks are
+ linked through their own storage
+ c) A magazine that runs empty takes a whole batch from the depot; one that holds 2 * BATCH
+ blocks gives BATCH back. The depot is a list of batches under a spin lock, so a lock is taken
+ once per BATCH operations, not per block. Blocks freed on another thread than the one that
+ allocated them simply join the freeing thread's magazine
+ d) When the depot is empty a chunk of BATCH blocks comes from ::operator new. Chunks are never
+ returned, the pool only grows to its high-water mark. That is the point for churn, but do not
+ use it for one-off bursts
+ e) Threads without a ThreadSlot go to the depot under the lock for every block
+ */
+namespace svr
+{
+    template<size_t SIZE, size_t ALIGN>
+    class FixedSizePool
+    {
+        struct FreeBlock
+        {
+            FreeBlock* d_next;
+            // Only meaningful on the first block of a batch in the depot
+            FreeBlock* d_nextBatch;
+        };
+
+        static constexpr size_t BATCH = 64;
+        static constexpr size_t BLOCK_ALIGN = ALIGN > alignof(FreeBlock) ? ALIGN : alignof(FreeBlock);
+        static constexpr size_t RAW_SIZE = SIZE > sizeof(FreeBlock) ? SIZE : sizeof(FreeBlock);
+
+        struct alignas(SVR_CACHELINE_SIZE) Magazine
+        {
+            size_t d_count{0};
+            FreeBlock* d_head{nullptr};
+        };
+
+        struct Depot
+        {
+            SpinLock<> d_lock;
+            FreeBlock* d_batches{nullptr};
+        };
+
+        static inline Magazine s_magazines[ThreadSlot::MAX_SLOTS];
+        static inline Depot s_depot;
+
+        // Whole batch from the depot, or a new chunk. Returns the first block and the count
+        static FreeBlock* takeBatch(size_t& count)
+        {
+            s_depot.d_lock.lock();
+            FreeBlock* batch = s_depot.d_batches;
+            if(batch)
+            {
+                s_depot.d_batches = batch->d_nextBatch;
+            }
+            s_depot.d_lock.unlock();
+            if(batch)
+            {
+                count = 0;
+                for(FreeBlock* b = batch; b; b = b->d_next)
+                {
+                    ++count;
+                }
+                return batch;
+            }
+            unsigned char* chunk = static_cast<unsigned char*>(::operator new(BATCH * BLOCK_SIZE, std::align_val_t(BLOCK_ALIGN)));
+            for(size_t i = 0; i < BATCH; ++i)
+            {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * BLOCK_SIZE);
+                block->d_next = i + 1 < BATCH ? reinterpret_cast<FreeBlock*>(chunk + (i + 1) * BLOCK_SIZE) : nullptr;
+            }
+            count = BATCH;
+            return reinterpret_cast<FreeBlock*>(chunk);
+        }
+
+        static void giveBatch(FreeBlock* batch)
+        {
+            s_depot.d_lock.lock();
+            batch->d_nextBatch = s_depot.d_batches;
+            s_depot.d_batches = batch;
+            s_depot.d_lock.unlock();
+        }
+
+        // No ThreadSlot: one block at a time straight from the depot
+        static void* allocateShared()
+        {
+            s_depot.d_lock.lock();
+            FreeBlock* block = s_depot.d_batches;
+            if(block)
+            {
+                FreeBlock* rest = block->d_next;
+                if(rest)
+                {
+                    rest->d_nextBatch = block->d_nextBatch;
+                    s_depot.d_batches = rest;
+                }
+                else
+                {
+                    s_depot.d_batches = block->d_nextBatch;
+                }
+            }
+            s_depot.d_lock.unlock();
+            if(block)
+            {
+                return block;
+            }
+            size_t count;
+            block = takeBatch(count);
+            if(block->d_next)
+            {
+                giveBatch(block->d_next);
+            }
+            return block;
+        }
+
+        public:
+            static constexpr size_t BLOCK_SIZE = (RAW_SIZE + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+
+            static void* allocate()
+            {
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    return allocateShared();
+                }
+                Magazine& magazine = s_magazines[slot];
+                if(!magazine.d_head) [[unlikely]]
+                {
+                    magazine.d_head = takeBatch(magazine.d_count);
+                }
+                FreeBlock* block = magazine.d_head;
+                magazine.d_head = block->d_next;
+                --magazine.d_count;
+                return block;
+            }
+
+            static void deallocate(void* ptr)
+            {
+                FreeBlock* block = static_cast<FreeBlock*>(ptr);
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    block->d_next = nullptr;
+                    giveBatch(block);
+                    return;
+                }
+                Magazine& magazine = s_magazines[slot];
+                block->d_next = magazine.d_head;
+                magazine.d_head = block;
+                if(++magazine.d_count == 2 * BATCH) [[unlikely]]
+                {
+                    // Keep the first BATCH blocks (most recently freed, likely still in
+                    // cache) and hand the rest back
+                    FreeBlock* last = magazine.d_head;
+                    for(size_t i = 1; i < BATCH; ++i)
+                    {
+                        last = last->d_next;
+                    }
+                    giveBatch(last->d_next);
+                    last->d_next = nullptr;
+                    magazine.d_count = BATCH;
+                }
+            }
+    };
+
+    // Stateless allocator: single objects come from FixedSizePool<sizeof(T), alignof(T)>,
+    // arrays from ::operator new
+    template<typename T>
+    class PoolAllocator
+    {
+        public:
+            using value_type = T;
+
+            PoolAllocator() = default;
+            template<typename U>
+            PoolAllocator(const PoolAllocator<U>&) {}
+
+            T* allocate(size_t n)
+            {
+                // Named here, not at class scope, so the allocator can be a member of the
+                // (still incomplete) type it allocates, as in allocate_shared's block
+                using Pool = FixedSizePool<sizeof(T), alignof(T)>;
+                if(n == 1) [[likely]]
+                {
+                    return static_cast<T*>(Pool::allocate());
+                }
+                return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+            }
+
+            void deallocate(T* ptr, size_t n)
+            {
+                using Pool = FixedSizePool<sizeof(T), alignof(T)>;
+                if(n == 1) [[likely]]
+                {
+                    Pool::deallocate(ptr);
+                    return;
+                }
+                ::operator delete(ptr, std::align_val_t(alignof(T)));
+            }
+
+            template<typename U>
+            bool operator==(const PoolAllocator<U>&) const
+            {
+                return true;
+            }
+    };
+}
+
+#endif
@@ -2,30 +2,234 @@
 #define SVR_SHARED_PTR
 
 #include "atomic"
-#include "test.h"
+#include "cstddef"
+#include "memory"
+#include "new"
+#include "type_traits"
+#include "utility"
+#include "helpers/test.h"
+#include "templates/forward.h"
+#include "templates/move.h"
 
+/**
+ a) The control block owns the reference counts and knows how to destroy the object. It is not
+ templated on the object type: what differs between shared_ptr(new T), shared_ptr(p, deleter,
+ alloc) and make_shared (object lives inside the block) is hidden behind two virtuals,
+ dispose() (destroy the object) and destroy() (free the block). That lets shared_ptr<Derived>
+ convert to shared_ptr<Base>, and lets the aliasing constructor point at a member while
+ keeping the whole object alive
+ b) Two counts. d_strong counts shared_ptrs; when it hits zero the object is disposed.
+ d_weak counts weak_ptrs plus one for all the strong owners together, so the block is freed
+ only after the last strong owner and the last weak_ptr are gone
+ c) weak_ptr::lock() is a CAS loop that increments d_strong only while it is non-zero, so a
+ weak reference never resurrects a dying object and never takes a lock
+ d) make_shared does one allocation for counts and object, so they share cache lines and a
+ shared object costs one malloc instead of two. With weak_ptrs around the object's storage
+ stays allocated (already destroyed) until the last weak_ptr goes
+ e) shared_ptr keeps the object pointer next to the control block pointer, so get(), -> and *
+ never touch the control block. Only copies and destruction do
+ f) Custom deleters and allocators are stored in the block with [[no_unique_address]], so
+ stateless ones cost nothing. The allocator is rebound to the block type and also frees it.
+ allocate_shared is make_shared with the block (object included) taken from an allocator,
+ so with svr::PoolAllocator churning shared objects stays off the global heap
+ */
 namespace svr
 {
     template <typename TYPE>
     class shared_ptr;
 
     template <typename TYPE>
+    class weak_ptr;
+
     class control_block
     {
+    private:
+        std::atomic<long> d_strong;
+        std::atomic<long> d_weak;
+
+    protected:
+        control_block() : d_strong(1), d_weak(1)
+        {
+        }
+
+        virtual ~control_block() = default;
+
+        // Destroys the object, runs when the last strong owner lets go
+        virtual void dispose() = 0;
+        // Frees the block, runs when the last strong or weak reference lets go
+        virtual void destroy() = 0;
+
+    public:
+        void retain()
+        {
+            d_strong.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Take a strong reference unless the object is already gone
+        bool try_retain()
+        {
+            long count = d_strong.load(std::memory_order_relaxed);
+            while (count != 0)
+            {
+                if (d_strong.compare_exchange_weak(count, count + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void release()
+        {
+            if (d_strong.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                dispose();
+                release_weak();
+            }
+        }
+
+        void retain_weak()
+        {
+            d_weak.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release_weak()
+        {
+            if (d_weak.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                destroy();
+            }
+        }
+
+        long use_count() const
+        {
+            return d_strong.load(std::memory_order_relaxed);
+        }
+    };
+
+    // Allocate and construct BLOCK with a copy of alloc rebound to BLOCK
+    template <typename BLOCK, typename Alloc, typename... Args>
+    BLOCK *allocate_control_block(const Alloc &alloc, Args &&...args)
+    {
+        using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<BLOCK>;
+        using Traits = std::allocator_traits<BlockAlloc>;
+        BlockAlloc blockAlloc(alloc);
+        BLOCK *block = Traits::allocate(blockAlloc, 1);
+        try
+        {
+            ::new (static_cast<void *>(block)) BLOCK(svr::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            Traits::deallocate(blockAlloc, block, 1);
+            throw;
+        }
+        return block;
+    }
+
+    // Counterpart of allocate_control_block, called by the block on itself
+    template <typename BLOCK, typename Alloc>
+    void deallocate_control_block(BLOCK *block, const Alloc &alloc)
+    {
+        using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<BLOCK>;
+        BlockAlloc blockAlloc(alloc);
+        block->~BLOCK();
+        std::allocator_traits<BlockAlloc>::deallocate(blockAlloc, block, 1);
+    }
+
+    // Block for shared_ptr(p[, deleter[, alloc]]): the object was allocated on its own
+    template <typename TYPE, typename Deleter = std::default_delete<TYPE>, typename Alloc = std::allocator<TYPE>>
+    class pointer_control_block : public control_block
+    {
     private:
         TYPE *d_instance;
-        std::atomic<long> d_refCnt;
+        [[no_unique_address]] Deleter d_deleter;
+        [[no_unique_address]] Alloc d_alloc;
+
+    protected:
+        void dispose() override
+        {
+            d_deleter(d_instance);
+        }
 
+        void destroy() override
+        {
+            Alloc alloc(svr::move(d_alloc));
+            deallocate_control_block(this, alloc);
+        }
+
+    public:
+        pointer_control_block(TYPE *instance, Deleter deleter, const Alloc &alloc)
+            : d_instance(instance), d_deleter(svr::move(deleter)), d_alloc(alloc)
+        {
+        }
+    };
+
+    // Block for make_shared: the object is constructed in the block itself
+    template <typename TYPE>
+    class inplace_control_block : public control_block
+    {
+    private:
+        alignas(TYPE) unsigned char d_storage[sizeof(TYPE)];
+
+    protected:
+        void dispose() override
+        {
+            get()->~TYPE();
+        }
+
+        void destroy() override
+        {
+            delete this;
+        }
+
+    public:
+        template <typename... Args>
+        explicit inplace_control_block(Args &&...args)
+        {
+            ::new (static_cast<void *>(d_storage)) TYPE(svr::forward<Args>(args)...);
+        }
+
+        TYPE *get()
+        {
+            return std::launder(reinterpret_cast<TYPE *>(d_storage));
+        }
+    };
+
+    // Block for allocate_shared: the object lives in the block and the block comes from (and
+    // goes back to) alloc rebound to the block type
+    template <typename TYPE, typename Alloc>
+    class allocated_inplace_control_block : public control_block
+    {
     public:
-        friend class shared_ptr<TYPE>;
+        using block_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<allocated_inplace_control_block>;
+
+    private:
+        [[no_unique_address]] block_allocator d_alloc;
+        alignas(TYPE) unsigned char d_storage[sizeof(TYPE)];
 
-        control_block(TYPE *instance) : d_instance(instance), d_refCnt(1)
+    protected:
+        void dispose() override
         {
+            get()->~TYPE();
         }
 
-        ~control_block()
+        void destroy() override
         {
-            delete d_instance;
+            block_allocator alloc(svr::move(d_alloc));
+            deallocate_control_block(this, alloc);
+        }
+
+    public:
+        template <typename... Args>
+        explicit allocated_inplace_control_block(const Alloc &alloc, Args &&...args) : d_alloc(alloc)
+        {
+            ::new (static_cast<void *>(d_storage)) TYPE(svr::forward<Args>(args)...);
+        }
+
+        TYPE *get()
+        {
+            return std::launder(reinterpret_cast<TYPE *>(d_storage));
         }
     };
 
@@ -33,82 +237,284 @@ namespace svr
     class shared_ptr
     {
     private:
-        svr::control_block<TYPE> *d_cntrl;
+        TYPE *d_ptr;
+        svr::control_block *d_cntrl;
+
+        template <typename U>
+        friend class shared_ptr;
+
+        template <typename U>
+        friend class weak_ptr;
+
+        template <typename T, typename... Args>
+        friend shared_ptr<T> make_shared(Args &&...args);
+
+        template <typename T, typename Alloc, typename... Args>
+        friend shared_ptr<T> allocate_shared(const Alloc &alloc, Args &&...args);
+
+        struct adopt_t
+        {
+        };
+
+        // Adopts one strong reference that the caller already holds on cntrl
+        shared_ptr(TYPE *ptr, svr::control_block *cntrl, adopt_t) : d_ptr(ptr), d_cntrl(cntrl) {}
+
+        template <typename Deleter, typename Alloc>
+        static svr::control_block *makeBlock(TYPE *instance, Deleter &deleter, const Alloc &alloc)
+        {
+            try
+            {
+                return allocate_control_block<pointer_control_block<TYPE, Deleter, Alloc>>(alloc, instance, deleter, alloc);
+            }
+            catch (...)
+            {
+                deleter(instance);
+                throw;
+            }
+        }
 
     public:
-        shared_ptr() : d_cntrl(nullptr) {}
-        explicit shared_ptr(TYPE *instance) : d_cntrl(new control_block(instance)) {}
-        shared_ptr(const shared_ptr &other) : d_cntrl(other.d_cntrl)
+        shared_ptr() : d_ptr(nullptr), d_cntrl(nullptr) {}
+        shared_ptr(std::nullptr_t) : shared_ptr() {}
+        explicit shared_ptr(TYPE *instance) : shared_ptr(instance, std::default_delete<TYPE>()) {}
+        template <typename Deleter, typename = std::enable_if_t<std::is_invocable_v<Deleter &, TYPE *>>>
+        shared_ptr(TYPE *instance, Deleter deleter) : shared_ptr(instance, svr::move(deleter), std::allocator<TYPE>()) {}
+        template <typename Deleter, typename Alloc, typename = std::enable_if_t<std::is_invocable_v<Deleter &, TYPE *>>>
+        shared_ptr(TYPE *instance, Deleter deleter, const Alloc &alloc) : d_ptr(instance), d_cntrl(makeBlock(instance, deleter, alloc)) {}
+        // Aliasing: shares ownership with other but points at ptr (usually a member of *other)
+        template <typename U>
+        shared_ptr(const shared_ptr<U> &other, TYPE *ptr) : d_ptr(ptr), d_cntrl(other.d_cntrl)
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->retain();
+            }
+        }
+        shared_ptr(const shared_ptr &other) : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->retain();
+            }
+        }
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U *, TYPE *>>>
+        shared_ptr(const shared_ptr<U> &other) : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
         {
             if (d_cntrl)
             {
-                d_cntrl->d_refCnt.fetch_add(1, std::memory_order_relaxed);
+                d_cntrl->retain();
             }
         }
-        shared_ptr(shared_ptr &&other) : d_cntrl(other.d_cntrl)
+        shared_ptr(shared_ptr &&other) noexcept : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            other.d_ptr = nullptr;
+            other.d_cntrl = nullptr;
+        }
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U *, TYPE *>>>
+        shared_ptr(shared_ptr<U> &&other) noexcept : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
         {
+            other.d_ptr = nullptr;
             other.d_cntrl = nullptr;
         }
         shared_ptr &operator=(const shared_ptr &other)
         {
-            if (this == &other)
+            // Same owner (also covers self-assignment): the count would not change
+            if (d_cntrl == other.d_cntrl)
             {
+                d_ptr = other.d_ptr;
                 return *this;
             }
-
-            if (d_cntrl && d_cntrl->d_refCnt.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            // Retain first, other may only be kept alive by *this
+            if (other.d_cntrl)
             {
-                delete d_cntrl;
+                other.d_cntrl->retain();
             }
-            d_cntrl = other.d_cntrl;
             if (d_cntrl)
             {
-                d_cntrl->d_refCnt.fetch_add(1, std::memory_order_relaxed);
+                d_cntrl->release();
             }
-
+            d_ptr = other.d_ptr;
+            d_cntrl = other.d_cntrl;
             return *this;
         }
-        shared_ptr &operator=(shared_ptr &&other)
+        shared_ptr &operator=(shared_ptr &&other) noexcept
         {
             if (this == &other)
             {
                 return *this;
             }
-            if (d_cntrl && d_cntrl->d_refCnt.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            if (d_cntrl)
             {
-                delete d_cntrl;
+                d_cntrl->release();
             }
+            d_ptr = other.d_ptr;
             d_cntrl = other.d_cntrl;
+            other.d_ptr = nullptr;
             other.d_cntrl = nullptr;
             return *this;
         }
         ~shared_ptr()
         {
-            if (d_cntrl && d_cntrl->d_refCnt.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            if (d_cntrl)
             {
-                delete d_cntrl;
+                d_cntrl->release();
             }
         }
+        void reset()
+        {
+            shared_ptr().swap(*this);
+        }
+        void swap(shared_ptr &other) noexcept
+        {
+            std::swap(d_ptr, other.d_ptr);
+            std::swap(d_cntrl, other.d_cntrl);
+        }
         TYPE *get() const
         {
-            return d_cntrl ? d_cntrl->d_instance : nullptr;
+            return d_ptr;
         }
 
         TYPE *operator->() const
         {
-            return d_cntrl->d_instance;
+            return d_ptr;
         }
 
         TYPE &operator*() const
         {
-            return *(d_cntrl->d_instance);
+            return *d_ptr;
+        }
+
+        explicit operator bool() const
+        {
+            return d_ptr;
         }
 
         long use_count() const
         {
-            return d_cntrl ? d_cntrl->d_refCnt.load() : 0;
+            return d_cntrl ? d_cntrl->use_count() : 0;
+        }
+
+        // Same control block, i.e. same owned object, whatever they point at
+        template <typename U>
+        bool owner_equal(const shared_ptr<U> &other) const
+        {
+            return d_cntrl == other.d_cntrl;
         }
     };
+
+    template <typename T, typename U>
+    bool operator==(const shared_ptr<T> &a, const shared_ptr<U> &b)
+    {
+        return a.get() == b.get();
+    }
+
+    template <typename T>
+    bool operator==(const shared_ptr<T> &a, std::nullptr_t)
+    {
+        return !a;
+    }
+
+    template <typename TYPE>
+    class weak_ptr
+    {
+    private:
+        TYPE *d_ptr;
+        svr::control_block *d_cntrl;
+
+        template <typename U>
+        friend class weak_ptr;
+
+    public:
+        weak_ptr() : d_ptr(nullptr), d_cntrl(nullptr) {}
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U *, TYPE *>>>
+        weak_ptr(const shared_ptr<U> &owner) : d_ptr(owner.d_ptr), d_cntrl(owner.d_cntrl)
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->retain_weak();
+            }
+        }
+        weak_ptr(const weak_ptr &other) : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->retain_weak();
+            }
+        }
+        weak_ptr(weak_ptr &&other) noexcept : d_ptr(other.d_ptr), d_cntrl(other.d_cntrl)
+        {
+            other.d_ptr = nullptr;
+            other.d_cntrl = nullptr;
+        }
+        weak_ptr &operator=(const weak_ptr &other)
+        {
+            weak_ptr(other).swap(*this);
+            return *this;
+        }
+        weak_ptr &operator=(weak_ptr &&other) noexcept
+        {
+            weak_ptr(svr::move(other)).swap(*this);
+            return *this;
+        }
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U *, TYPE *>>>
+        weak_ptr &operator=(const shared_ptr<U> &owner)
+        {
+            weak_ptr(owner).swap(*this);
+            return *this;
+        }
+        ~weak_ptr()
+        {
+            if (d_cntrl)
+            {
+                d_cntrl->release_weak();
+            }
+        }
+        void reset()
+        {
+            weak_ptr().swap(*this);
+        }
+        void swap(weak_ptr &other) noexcept
+        {
+            std::swap(d_ptr, other.d_ptr);
+            std::swap(d_cntrl, other.d_cntrl);
+        }
+
+        // Strong reference if the object is still alive, empty otherwise. Lock-free
+        shared_ptr<TYPE> lock() const
+        {
+            if (d_cntrl && d_cntrl->try_retain())
+            {
+                return shared_ptr<TYPE>(d_ptr, d_cntrl, typename shared_ptr<TYPE>::adopt_t());
+            }
+            return shared_ptr<TYPE>();
+        }
+
+        bool expired() const
+        {
+            return use_count() == 0;
+        }
+
+        long use_count() const
+        {
+            return d_cntrl ? d_cntrl->use_count() : 0;
+        }
+    };
+
+    // One allocation holding both the reference counts and the object
+    template <typename T, typename... Args>
+    shared_ptr<T> make_shared(Args &&...args)
+    {
+        auto *cntrl = new inplace_control_block<T>(svr::forward<Args>(args)...);
+        return shared_ptr<T>(cntrl->get(), cntrl, typename shared_ptr<T>::adopt_t());
+    }
+
+    // make_shared with the single allocation coming from alloc (e.g. svr::PoolAllocator)
+    template <typename T, typename Alloc, typename... Args>
+    shared_ptr<T> allocate_shared(const Alloc &alloc, Args &&...args)
+    {
+        auto *cntrl = allocate_control_block<allocated_inplace_control_block<T, Alloc>>(alloc, alloc, svr::forward<Args>(args)...);
+        return shared_ptr<T>(cntrl->get(), cntrl, typename shared_ptr<T>::adopt_t());
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,335 @@
+#ifndef SVR_SLAB_ALLOCATOR
+#define SVR_SLAB_ALLOCATOR
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include "memory/unique_ptr.h"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+#include "templates/forward.h"
+
+/**
+ General-purpose allocator for small objects, sorted into fixed size classes (16 bytes apart up
+ to 128, then four classes per doubling up to MAX_SIZE). Larger requests go to ::operator new.
+ Built for messages that one thread allocates and another frees after a queue hop.
+
+ a) Frees are sized: the caller (SlabAllocator, SlabDeleter) knows the size, so blocks carry no
+ header and a size maps to its class with one table lookup
+ b) Every ThreadSlot has a cache per class: an active list of up to BATCH free blocks plus at
+ most one full batch, all plain memory of one thread. Allocation pops the active list, a free
+ pushes onto it, no atomics either way. When the active list fills up it becomes the full batch;
+ when it runs dry it takes one (magazines, as in Bonwick's vmem)
+ c) The central depot per class is a fixed array of atomic batch pointers. A thread with two
+ full batches hands the older one over with a CAS from null into a free entry, and a thread that
+ runs dry takes one with exchange(nullptr). Neither operation reads through a pointer it has
+ not yet won, so there is no ABA and no lock. If every entry is taken the batch goes onto an
+ overflow stack under a spin lock, so a thread that only frees never holds more than two batches
+ d) A cross-thread free is therefore as cheap as a local one: the consumer's cache fills up and
+ ships whole batches back through the depot, one CAS per BATCH frees, where the producer picks
+ them up with one exchange per BATCH allocations
+ e) Chunks of BATCH blocks come from ::operator new aligned to a cache line and are never
+ returned. Blocks are 16-byte aligned; SlabAllocator sends more strictly aligned types to
+ ::operator new. Threads without a ThreadSlot share one extra cache under a spin lock
+ */
+namespace svr
+{
+    class SlabHeap
+    {
+        struct FreeBlock
+        {
+            FreeBlock* d_next;
+            // Only meaningful on the first block of a full batch
+            FreeBlock* d_nextBatch;
+        };
+
+        static constexpr size_t SHARED_CACHE = ThreadSlot::MAX_SLOTS;
+
+        static constexpr size_t CLASS_SIZES[] = {
+            16, 32, 48, 64, 80, 96, 112, 128,
+            160, 192, 224, 256, 320, 384, 448, 512,
+            640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+            2560, 3072, 3584, 4096};
+        static constexpr size_t NUM_CLASSES = sizeof(CLASS_SIZES) / sizeof(CLASS_SIZES[0]);
+
+        public:
+            static constexpr size_t MAX_SIZE = CLASS_SIZES[NUM_CLASSES - 1];
+            static constexpr size_t ALIGNMENT = 16;
+            static constexpr size_t BATCH = 32;
+            static constexpr size_t DEPOT_SLOTS = 32;
+
+        private:
+            // Class of every size, in 16 byte steps
+            static constexpr std::array<uint8_t, MAX_SIZE / 16 + 1> CLASS_OF = []() {
+                std::array<uint8_t, MAX_SIZE / 16 + 1> table{};
+                size_t cls = 0;
+                for(size_t step = 0; step < table.size(); ++step)
+                {
+                    while(CLASS_SIZES[cls] < step * 16)
+                    {
+                        ++cls;
+                    }
+                    table[step] = static_cast<uint8_t>(cls);
+                }
+                return table;
+            }();
+
+            struct Cache
+            {
+                FreeBlock* d_head{nullptr};
+                size_t d_count{0};
+                FreeBlock* d_full{nullptr};
+            };
+
+            struct alignas(SVR_CACHELINE_SIZE) ThreadCache
+            {
+                Cache d_classes[NUM_CLASSES];
+            };
+
+            struct alignas(SVR_CACHELINE_SIZE) Depot
+            {
+                std::atomic<FreeBlock*> d_batches[DEPOT_SLOTS]{};
+                // Batches chained through d_nextBatch, only written under d_overflowLock
+                std::atomic<FreeBlock*> d_overflow{nullptr};
+                SpinLock<> d_overflowLock;
+            };
+
+            static ThreadCache& cacheOf(size_t slot)
+            {
+                static ThreadCache s_caches[ThreadSlot::MAX_SLOTS + 1];
+                return s_caches[slot];
+            }
+
+            static Depot& depotOf(size_t cls)
+            {
+                static Depot s_depots[NUM_CLASSES];
+                return s_depots[cls];
+            }
+
+            static SpinLock<>& sharedLock()
+            {
+                static SpinLock<> s_lock;
+                return s_lock;
+            }
+
+            // Threads start their scan at different entries so they rarely meet on one line
+            static void give(size_t cls, size_t slot, FreeBlock* batch)
+            {
+                Depot& depot = depotOf(cls);
+                for(size_t i = 0; i < DEPOT_SLOTS; ++i)
+                {
+                    std::atomic<FreeBlock*>& entry = depot.d_batches[(slot + i) % DEPOT_SLOTS];
+                    FreeBlock* expected = nullptr;
+                    if(!entry.load(std::memory_order_relaxed) && entry.compare_exchange_strong(expected, batch, std::memory_order_release, std::memory_order_relaxed))
+                    {
+                        return;
+                    }
+                }
+                depot.d_overflowLock.lock();
+                batch->d_nextBatch = depot.d_overflow.load(std::memory_order_relaxed);
+                depot.d_overflow.store(batch, std::memory_order_relaxed);
+                depot.d_overflowLock.unlock();
+            }
+
+            static FreeBlock* take(size_t cls, size_t slot)
+            {
+                Depot& depot = depotOf(cls);
+                for(size_t i = 0; i < DEPOT_SLOTS; ++i)
+                {
+                    std::atomic<FreeBlock*>& entry = depot.d_batches[(slot + i) % DEPOT_SLOTS];
+                    if(entry.load(std::memory_order_relaxed))
+                    {
+                        if(FreeBlock* batch = entry.exchange(nullptr, std::memory_order_acquire))
+                        {
+                            return batch;
+                        }
+                    }
+                }
+                FreeBlock* batch = nullptr;
+                if(depot.d_overflow.load(std::memory_order_relaxed))
+                {
+                    depot.d_overflowLock.lock();
+                    if((batch = depot.d_overflow.load(std::memory_order_relaxed)))
+                    {
+                        depot.d_overflow.store(batch->d_nextBatch, std::memory_order_relaxed);
+                    }
+                    depot.d_overflowLock.unlock();
+                }
+                return batch;
+            }
+
+            static FreeBlock* newChunk(size_t cls)
+            {
+                const size_t size = CLASS_SIZES[cls];
+                unsigned char* chunk = static_cast<unsigned char*>(::operator new(BATCH * size, std::align_val_t(SVR_CACHELINE_SIZE)));
+                for(size_t i = 0; i < BATCH; ++i)
+                {
+                    FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * size);
+                    block->d_next = i + 1 < BATCH ? reinterpret_cast<FreeBlock*>(chunk + (i + 1) * size) : nullptr;
+                }
+                return reinterpret_cast<FreeBlock*>(chunk);
+            }
+
+            static void* allocateFrom(Cache& cache, size_t cls, size_t slot)
+            {
+                if(!cache.d_head) [[unlikely]]
+                {
+                    if(cache.d_full)
+                    {
+                        cache.d_head = cache.d_full;
+                        cache.d_full = nullptr;
+                    }
+                    else if(!(cache.d_head = take(cls, slot)))
+                    {
+                        cache.d_head = newChunk(cls);
+                    }
+                    cache.d_count = BATCH;
+                }
+                FreeBlock* block = cache.d_head;
+                cache.d_head = block->d_next;
+                --cache.d_count;
+                return block;
+            }
+
+            static void deallocateTo(Cache& cache, size_t cls, size_t slot, void* ptr)
+            {
+                FreeBlock* block = static_cast<FreeBlock*>(ptr);
+                block->d_next = cache.d_head;
+                cache.d_head = block;
+                if(++cache.d_count == BATCH) [[unlikely]]
+                {
+                    // The newest full batch stays for this thread's next refill, the older one
+                    // goes to the depot and is not touched again: another thread may own it
+                    if(cache.d_full)
+                    {
+                        give(cls, slot, cache.d_full);
+                    }
+                    cache.d_full = block;
+                    cache.d_head = nullptr;
+                    cache.d_count = 0;
+                }
+            }
+
+        public:
+            // Size class a request of bytes is served from, NUM_CLASSES for ::operator new
+            static size_t size_class(size_t bytes)
+            {
+                return bytes <= MAX_SIZE ? CLASS_OF[(bytes + 15) / 16] : NUM_CLASSES;
+            }
+
+            // Bytes actually reserved for a request of bytes
+            static size_t block_size(size_t bytes)
+            {
+                return bytes <= MAX_SIZE ? CLASS_SIZES[size_class(bytes)] : bytes;
+            }
+
+            static void* allocate(size_t bytes)
+            {
+                if(bytes > MAX_SIZE) [[unlikely]]
+                {
+                    return ::operator new(bytes);
+                }
+                const size_t cls = CLASS_OF[(bytes + 15) / 16];
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    sharedLock().lock();
+                    void* ptr = allocateFrom(cacheOf(SHARED_CACHE).d_classes[cls], cls, slot);
+                    sharedLock().unlock();
+                    return ptr;
+                }
+                return allocateFrom(cacheOf(slot).d_classes[cls], cls, slot);
+            }
+
+            // bytes must be the size ptr was allocated with
+            static void deallocate(void* ptr, size_t bytes)
+            {
+                if(bytes > MAX_SIZE) [[unlikely]]
+                {
+                    ::operator delete(ptr, bytes);
+                    return;
+                }
+                const size_t cls = CLASS_OF[(bytes + 15) / 16];
+                const size_t slot = ThreadSlot::id();
+                if(slot == ThreadSlot::INVALID) [[unlikely]]
+                {
+                    sharedLock().lock();
+                    deallocateTo(cacheOf(SHARED_CACHE).d_classes[cls], cls, slot, ptr);
+                    sharedLock().unlock();
+                    return;
+                }
+                deallocateTo(cacheOf(slot).d_classes[cls], cls, slot, ptr);
+            }
+    };
+
+    // Stateless allocator over SlabHeap, all instances compare equal. Over-aligned types go to
+    // ::operator new
+    template<typename T>
+    class SlabAllocator
+    {
+        static constexpr bool OVER_ALIGNED = alignof(T) > SlabHeap::ALIGNMENT;
+
+        public:
+            using value_type = T;
+
+            SlabAllocator() = default;
+            template<typename U>
+            SlabAllocator(const SlabAllocator<U>&) {}
+
+            T* allocate(size_t n)
+            {
+                if constexpr(OVER_ALIGNED)
+                {
+                    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+                }
+                return static_cast<T*>(SlabHeap::allocate(n * sizeof(T)));
+            }
+
+            void deallocate(T* ptr, size_t n)
+            {
+                if constexpr(OVER_ALIGNED)
+                {
+                    ::operator delete(ptr, std::align_val_t(alignof(T)));
+                    return;
+                }
+                SlabHeap::deallocate(ptr, n * sizeof(T));
+            }
+
+            template<typename U>
+            bool operator==(const SlabAllocator<U>&) const
+            {
+                return true;
+            }
+    };
+
+    // Deleter for unique_ptr<T, SlabDeleter<T>> over make_slab_unique
+    template<typename T>
+    struct SlabDeleter
+    {
+        void operator()(T* ptr) const
+        {
+            ptr->~T();
+            SlabAllocator<T>().deallocate(ptr, 1);
+        }
+    };
+
+    template<typename T, typename... Args>
+    svr::unique_ptr<T, SlabDeleter<T>> make_slab_unique(Args&&... args)
+    {
+        T* ptr = SlabAllocator<T>().allocate(1);
+        try
+        {
+            ::new(static_cast<void*>(ptr)) T(svr::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            SlabAllocator<T>().deallocate(ptr, 1);
+            throw;
+        }
+        return svr::unique_ptr<T, SlabDeleter<T>>(ptr, SlabDeleter<T>());
+    }
+}
+
+#endif
@@ -146,6 +146,15 @@ namespace svr
         return unique_ptr<T>(new T(svr::forward<Args>(args)...));
     }
 
+    // Default-initializes instead of value-initializing: no zeroing for trivial types, for
+    // objects that are about to be overwritten anyway
+    template<typename T,
+             typename = std::enable_if_t<!std::is_array<T>::value>>
+    unique_ptr<T> make_unique_for_overwrite()
+    {
+        return unique_ptr<T>(new T);
+    }
+
     template<typename T, typename Deleter>
     class unique_ptr<T[], Deleter>
     {
@@ -164,6 +173,9 @@ namespace svr
             unique_ptr(std::nullptr_t ptr) : d_ptr{ptr} {}
             // Constructor taking in plain pointer
             unique_ptr(T* ptr): d_ptr(ptr) {}
+            // Constructor taking in plain pointer and deleter, for deleters that carry state
+            // such as the element count or the mapping size
+            unique_ptr(T* ptr, Deleter&& deleter): d_ptr(ptr), d_deleter(std::forward<Deleter>(deleter)){}
             // Copy constructor
             unique_ptr(const unique_ptr&) = delete;
             // Copy assignment operator
@@ -261,6 +273,17 @@ namespace svr
         using ElementType = typename std::remove_extent<T>::type;
         return unique_ptr<T>(new ElementType[n]());
     }
+
+    // Array version of make_unique_for_overwrite. new ElementType[n] without the () leaves
+    // trivial elements uninitialized, so a large scratch buffer costs no memory bandwidth
+    // until it is written. See memory/aligned_buffer.h for aligned and huge-page buffers
+    template<typename T,
+             typename = std::enable_if_t<std::is_unbounded_array<T>::value>>
+    unique_ptr<T> make_unique_for_overwrite(std::size_t n)
+    {
+        using ElementType = typename std::remove_extent<T>::type;
+        return unique_ptr<T>(new ElementType[n]);
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
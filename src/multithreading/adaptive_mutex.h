@@ -0,0 +1,129 @@
+#ifndef SVR_ADAPTIVE_MUTEX
+#define SVR_ADAPTIVE_MUTEX
+
+#include <atomic>
+#include <cstdint>
+#include "multithreading/spinlock/spinlock.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ Spin-then-park mutex. The spin locks in spinlock.h are great while threads <= cores and
+ terrible after that, std::mutex goes to the kernel as soon as it sees contention. This
+ one spins for a while first and only then sleeps on a futex.
+
+ a) The lock word has three states (Drepper, "Futexes Are Tricky"): 0 unlocked, 1 locked
+ with no sleepers, 2 locked and somebody may be sleeping. unlock() only makes the wake
+ syscall when the word was 2, so an uncontended lock/unlock is one CAS and one fetch_sub
+ b) The spin budget adapts like glibc's PTHREAD_MUTEX_ADAPTIVE_NP: every contended lock()
+ moves d_spinEstimate 1/8 of the way towards the number of spins it actually needed (or the
+ full budget if spinning did not help). Locks with short critical sections learn to spin,
+ locks whose holders sleep or get preempted learn to park quickly
+ c) Spinning reads the word first and only CASes when it looks free (test and test and set),
+ with cpu_relax() in between
+ d) Off Linux, parking uses C++20 atomic wait/notify, which is a futex (or equivalent) on
+ every mainstream library anyway
+ */
+namespace svr
+{
+    class AdaptiveMutex
+    {
+        static constexpr uint32_t UNLOCKED = 0;
+        static constexpr uint32_t LOCKED = 1;
+        static constexpr uint32_t CONTENDED = 2;
+        static constexpr int32_t MAX_SPINS = 1000;
+        static constexpr int32_t INITIAL_SPINS = 100;
+
+        private:
+            alignas(SVR_CACHELINE_SIZE) std::atomic<uint32_t> d_state{UNLOCKED};
+            // Only a hint, relaxed loads and stores are enough
+            std::atomic<int32_t> d_spinEstimate{INITIAL_SPINS};
+            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<uint32_t>) - sizeof(std::atomic<int32_t>)]{};
+
+            void park()
+            {
+            #if defined(__linux__)
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&d_state), FUTEX_WAIT_PRIVATE, CONTENDED, nullptr, nullptr, 0);
+            #else
+                d_state.wait(CONTENDED, std::memory_order_relaxed);
+            #endif
+            }
+
+            void wakeOne()
+            {
+            #if defined(__linux__)
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&d_state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+            #else
+                d_state.notify_one();
+            #endif
+            }
+
+            void updateEstimate(int32_t estimate, int32_t spins)
+            {
+                d_spinEstimate.store(estimate + (spins - estimate) / 8, std::memory_order_relaxed);
+            }
+
+            void lockSlow()
+            {
+                const int32_t estimate = d_spinEstimate.load(std::memory_order_relaxed);
+                const int32_t maxSpins = estimate * 2 + 10 < MAX_SPINS ? estimate * 2 + 10 : MAX_SPINS;
+                for(int32_t spins = 0; spins < maxSpins; ++spins)
+                {
+                    cpu_relax();
+                    uint32_t expected = UNLOCKED;
+                    if(d_state.load(std::memory_order_relaxed) == UNLOCKED &&
+                       d_state.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+                    {
+                        updateEstimate(estimate, spins);
+                        return;
+                    }
+                }
+                updateEstimate(estimate, maxSpins);
+
+                // Announce a sleeper. Whoever sees 2 in unlock() will wake one of us, and a
+                // woken thread takes the lock as 2 because more sleepers may be behind it
+                uint32_t state = d_state.exchange(CONTENDED, std::memory_order_acquire);
+                while(state != UNLOCKED)
+                {
+                    park();
+                    state = d_state.exchange(CONTENDED, std::memory_order_acquire);
+                }
+            }
+
+        public:
+            AdaptiveMutex() = default;
+            AdaptiveMutex(const AdaptiveMutex&) = delete;
+            AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+
+            void lock()
+            {
+                uint32_t expected = UNLOCKED;
+                if(d_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) [[likely]]
+                {
+                    return;
+                }
+                lockSlow();
+            }
+
+            bool try_lock()
+            {
+                uint32_t expected = UNLOCKED;
+                return d_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+            }
+
+            void unlock()
+            {
+                if(d_state.fetch_sub(1, std::memory_order_release) != LOCKED) [[unlikely]]
+                {
+                    d_state.store(UNLOCKED, std::memory_order_release);
+                    wakeOne();
+                }
+            }
+    };
+}
+
+#endif
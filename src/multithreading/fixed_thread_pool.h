@@ -10,6 +10,7 @@
 #include <atomic>
 #include <iostream>
 #include <chrono>
+#include "containers/small_vector.h"
 
 namespace svr
 {
@@ -35,7 +36,8 @@ namespace svr
                 {
                     while(!d_stop.load())
                     {
-                        std::vector<Item> items;
+                        // One job per wakeup today: the inline slot means no allocation per loop
+                        svr::small_vector<Item, 1> items;
                         {
                             std::unique_lock<std::mutex> lk(d_mx);
                             d_cv.wait(lk, [this](){
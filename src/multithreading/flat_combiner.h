@@ -0,0 +1,183 @@
+#ifndef SVR_FLAT_COMBINER
+#define SVR_FLAT_COMBINER
+
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include "memory/unique_ptr.h"
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+#include "templates/forward.h"
+
+/**
+ Flat combining (Hendler, Incze, Shavit, Tzafrir). For short operations on a shared structure
+ the expensive part of a lock is not the lock, it is every new holder pulling the structure's
+ cache lines over to its own core. Here threads do not run their operation themselves:
+ a) apply(f) publishes a pointer to f in the caller's own publication record (one cache line
+ per ThreadSlot) and then tries to become the combiner
+ b) The combiner (whoever wins d_lock) walks all records and runs every pending operation
+ against the state, so a whole batch runs on one core while the state stays in its cache
+ c) Everybody else spins on the "done" flag of their own request, which lives on their own
+ stack, i.e. not on a shared line
+ d) The request (closure, result, exception) lives on the requester's stack. The combiner
+ clears the record first and sets done last, and never touches the request after that, so the
+ requester can return and reuse its record right away
+ e) Exceptions thrown by f are carried back and rethrown in the requesting thread; the
+ combiner keeps going
+ */
+namespace svr
+{
+    template<typename State>
+    class FlatCombiner
+    {
+        static constexpr int COMBINING_PASSES = 2;
+
+        struct Request
+        {
+            void (*d_run)(Request*, State&);
+            std::atomic<bool> d_done{false};
+            std::exception_ptr d_error;
+
+            explicit Request(void (*run)(Request*, State&)) : d_run(run) {}
+        };
+
+        template<typename F, typename R>
+        struct TypedRequest : Request
+        {
+            F& d_fn;
+            std::optional<R> d_result;
+
+            explicit TypedRequest(F& fn) : Request(&run), d_fn(fn) {}
+
+            static void run(Request* base, State& state)
+            {
+                TypedRequest* self = static_cast<TypedRequest*>(base);
+                self->d_result.emplace(self->d_fn(state));
+            }
+        };
+
+        template<typename F>
+        struct TypedRequest<F, void> : Request
+        {
+            F& d_fn;
+
+            explicit TypedRequest(F& fn) : Request(&run), d_fn(fn) {}
+
+            static void run(Request* base, State& state)
+            {
+                static_cast<TypedRequest*>(base)->d_fn(state);
+            }
+        };
+
+        struct alignas(SVR_CACHELINE_SIZE) Record
+        {
+            std::atomic<Request*> d_request{nullptr};
+        };
+
+        private:
+            SpinLock<PauseBackoff> d_lock;
+            svr::unique_ptr<Record[]> d_records;
+            alignas(SVR_CACHELINE_SIZE) State d_state;
+
+            static void execute(Request* request, State& state)
+            {
+                try
+                {
+                    request->d_run(request, state);
+                }
+                catch(...)
+                {
+                    request->d_error = std::current_exception();
+                }
+            }
+
+            // Caller holds d_lock
+            void combine(int passes)
+            {
+                for(int pass = 0; pass < passes; ++pass)
+                {
+                    for(size_t i = 0, used = ThreadSlot::high_water(); i < used; ++i)
+                    {
+                        Request* request = d_records[i].d_request.load(std::memory_order_acquire);
+                        if(request)
+                        {
+                            execute(request, d_state);
+                            d_records[i].d_request.store(nullptr, std::memory_order_relaxed);
+                            request->d_done.store(true, std::memory_order_release);
+                        }
+                    }
+                }
+            }
+
+            template<typename R, typename Req>
+            static R finish(Req& request)
+            {
+                if(request.d_error) [[unlikely]]
+                {
+                    std::rethrow_exception(request.d_error);
+                }
+                if constexpr (!std::is_void_v<R>)
+                {
+                    return std::move(*request.d_result);
+                }
+            }
+
+        public:
+            template<typename... Args>
+            explicit FlatCombiner(Args&&... args)
+                : d_records(new Record[ThreadSlot::MAX_SLOTS])
+                , d_state(svr::forward<Args>(args)...)
+            {
+            }
+
+            FlatCombiner(const FlatCombiner&) = delete;
+            FlatCombiner& operator=(const FlatCombiner&) = delete;
+
+            // Run f(state) under mutual exclusion with every other apply() and return its result
+            template<typename F>
+            auto apply(F&& f) -> std::invoke_result_t<F&, State&>
+            {
+                using R = std::invoke_result_t<F&, State&>;
+                static_assert(!std::is_reference_v<R>, "Results are handed across threads, return by value");
+
+                TypedRequest<std::remove_reference_t<F>, R> request(f);
+                const size_t slot = ThreadSlot::id();
+                // Uncontended, or no record to publish in: run it ourselves under the lock
+                // and serve whoever showed up in the meantime
+                if(slot == ThreadSlot::INVALID || d_lock.try_lock())
+                {
+                    if(slot == ThreadSlot::INVALID) [[unlikely]]
+                    {
+                        d_lock.lock();
+                    }
+                    execute(&request, d_state);
+                    combine(1);
+                    d_lock.unlock();
+                    return finish<R>(request);
+                }
+
+                d_records[slot].d_request.store(&request, std::memory_order_release);
+                unsigned spins = 0;
+                while(!request.d_done.load(std::memory_order_acquire))
+                {
+                    if(d_lock.try_lock())
+                    {
+                        combine(COMBINING_PASSES);
+                        d_lock.unlock();
+                        continue;
+                    }
+                    spin_wait(spins);
+                }
+                return finish<R>(request);
+            }
+
+            // Unsynchronized access, for setup and teardown only
+            State& unsafe_state()
+            {
+                return d_state;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef SVR_NUMA
+#define SVR_NUMA
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace svr
+{
+    /**
+    NUMA layout as Linux exposes it in /sys/devices/system/node/node<N>/cpulist, read once.
+    Node ids in sysfs can be sparse (node0, node2), so nodes are renumbered densely: node()
+    returns an index in [0, numNodes()), which is what per-node arrays want. Without sysfs
+    (non-Linux, containers hiding it) everything is one node
+    */
+    class NumaTopology
+    {
+        private:
+            std::vector<std::vector<unsigned>> d_cpusOfNode;
+            std::vector<size_t> d_nodeOfCpu;
+
+            // "0-3,8-11" -> 0 1 2 3 8 9 10 11
+            static std::vector<unsigned> parseCpuList(const std::string& list)
+            {
+                std::vector<unsigned> cpus;
+                std::stringstream ss(list);
+                std::string range;
+                while(std::getline(ss, range, ','))
+                {
+                    if(range.empty() || range == "\n")
+                    {
+                        continue;
+                    }
+                    size_t dash = range.find('-');
+                    unsigned first = std::stoul(range.substr(0, dash));
+                    unsigned last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+                    for(unsigned cpu = first; cpu <= last; ++cpu)
+                    {
+                        cpus.push_back(cpu);
+                    }
+                }
+                return cpus;
+            }
+
+            NumaTopology()
+            {
+                std::error_code ec;
+                std::vector<std::pair<unsigned, std::vector<unsigned>>> nodes;
+                for(const auto& dirEntry : std::filesystem::directory_iterator("/sys/devices/system/node", ec))
+                {
+                    const std::string name = dirEntry.path().filename().string();
+                    if(name.rfind("node", 0) != 0 || name.size() == 4 || name.find_first_not_of("0123456789", 4) != std::string::npos)
+                    {
+                        continue;
+                    }
+                    std::ifstream in(dirEntry.path() / "cpulist");
+                    std::string list;
+                    std::getline(in, list);
+                    std::vector<unsigned> cpus = parseCpuList(list);
+                    // Memory-only nodes have no cpus and never show up in node()
+                    if(!cpus.empty())
+                    {
+                        nodes.emplace_back(std::stoul(name.substr(4)), std::move(cpus));
+                    }
+                }
+                std::sort(nodes.begin(), nodes.end());
+                for(auto& node : nodes)
+                {
+                    d_cpusOfNode.push_back(std::move(node.second));
+                }
+
+                if(d_cpusOfNode.empty())
+                {
+                    unsigned numCpus = std::thread::hardware_concurrency();
+                    d_cpusOfNode.emplace_back();
+                    for(unsigned cpu = 0; cpu < (numCpus ? numCpus : 1); ++cpu)
+                    {
+                        d_cpusOfNode[0].push_back(cpu);
+                    }
+                }
+
+                for(size_t node = 0; node < d_cpusOfNode.size(); ++node)
+                {
+                    for(unsigned cpu : d_cpusOfNode[node])
+                    {
+                        if(cpu >= d_nodeOfCpu.size())
+                        {
+                            d_nodeOfCpu.resize(cpu + 1, 0);
+                        }
+                        d_nodeOfCpu[cpu] = node;
+                    }
+                }
+            }
+
+        public:
+            static const NumaTopology& instance()
+            {
+                static const NumaTopology topology;
+                return topology;
+            }
+
+            size_t numNodes() const
+            {
+                return d_cpusOfNode.size();
+            }
+
+            const std::vector<unsigned>& cpusOfNode(size_t node) const
+            {
+                return d_cpusOfNode[node];
+            }
+
+            size_t nodeOfCpu(unsigned cpu) const
+            {
+                return cpu < d_nodeOfCpu.size() ? d_nodeOfCpu[cpu] : 0;
+            }
+
+            // Node the calling thread runs on right now. sched_getcpu is a vDSO/rseq read on
+            // current glibc, cheap enough to call per lock acquisition
+            size_t node() const
+            {
+            #if defined(__linux__)
+                int cpu = sched_getcpu();
+                return cpu < 0 ? 0 : nodeOfCpu(static_cast<unsigned>(cpu));
+            #else
+                return 0;
+            #endif
+            }
+
+            // Pin the calling thread to one cpu. Returns false if that is not possible
+            static bool pinCurrentThread(unsigned cpu)
+            {
+            #if defined(__linux__)
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+            #else
+                return false;
+            #endif
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,382 @@
+#ifndef SVR_PROFILED_LOCK
+#define SVR_PROFILED_LOCK
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <vector>
+#include "multithreading/spinlock/spinlock.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ Contention profiling for any lock with lock()/unlock() (everything in spinlock.h,
+ AdaptiveMutex, std::mutex, ...). Wrap the lock in ProfiledLock<L> and every acquisition is
+ attributed to its call site: how long it waited, how long it held the lock, how many times it
+ probed before getting it.
+
+ a) Timing is rdtsc on x86 (tens of cycles, no syscall) and steady_clock elsewhere. Ticks are
+ converted to nanoseconds only when a report is built, against steady_clock over the time since
+ the profiler started. Starting (with the first profiled lock) spins for CALIBRATION_NS to turn
+ CONTENDED_WAIT_NS into ticks; nothing sleeps or calibrates on the lock path after that
+ b) Each thread writes into its own fixed-size table of call sites, so recording never
+ contends and never allocates after the thread's first profiled lock. Entries are written by
+ their owner thread only, with plain load + store on relaxed atomics (no RMW), which keeps the
+ hot path cheap while report() reads them from another thread
+ c) Call sites come from std::source_location defaulted on lock(). std::lock_guard would make
+ every site point into <mutex>, so use ProfiledLockGuard, which takes the location itself
+ d) lock() calls L::lock() and times around it, so the profiled lock keeps L's fairness and
+ sleeping behaviour. An acquisition counts as contended when it waited longer than
+ CONTENDED_WAIT_NS. The spins column is always 0 in this mode, since L does not say how often
+ it spun. ProfiledLock<L, true> probes try_lock() up to MAX_PROBES times before L::lock() and
+ reports the probes as spins. It requires L::try_lock() (CLHSpinLock has none), lets a thread
+ overtake the queue of ticket/MCS/cohort locks and puts a spin in front of sleeping locks, so it
+ profiles a different lock: opt in only to study spinning
+ e) unlock() must run on the thread that called lock(), it writes the hold time into that
+ thread's table
+ f) Tables of exited threads stay registered so their numbers still show up in reports
+ */
+namespace svr
+{
+    struct LockSiteStats
+    {
+        const char* file;
+        const char* function;
+        uint32_t line;
+        uint64_t acquisitions;
+        uint64_t contended;
+        uint64_t spins;
+        double waitNs;
+        double holdNs;
+        double maxWaitNs;
+    };
+
+    class LockProfiler
+    {
+        public:
+            static constexpr size_t SITES_PER_THREAD = 256;
+            static constexpr double CONTENDED_WAIT_NS = 1000;
+            static constexpr double CALIBRATION_NS = 100000;
+
+            struct Entry
+            {
+                std::atomic<const char*> d_file{nullptr};
+                std::atomic<const char*> d_function{nullptr};
+                std::atomic<uint32_t> d_line{0};
+                std::atomic<uint64_t> d_acquisitions{0};
+                std::atomic<uint64_t> d_contended{0};
+                std::atomic<uint64_t> d_spins{0};
+                std::atomic<uint64_t> d_waitTicks{0};
+                std::atomic<uint64_t> d_holdTicks{0};
+                std::atomic<uint64_t> d_maxWaitTicks{0};
+
+                // Single writer, so a load and a store is enough
+                static void add(std::atomic<uint64_t>& counter, uint64_t value)
+                {
+                    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+                }
+
+                void recordAcquire(uint64_t waitTicks, uint64_t spins, bool contended)
+                {
+                    add(d_acquisitions, 1);
+                    add(d_contended, contended);
+                    add(d_spins, spins);
+                    add(d_waitTicks, waitTicks);
+                    if(waitTicks > d_maxWaitTicks.load(std::memory_order_relaxed))
+                    {
+                        d_maxWaitTicks.store(waitTicks, std::memory_order_relaxed);
+                    }
+                }
+
+                void recordRelease(uint64_t holdTicks)
+                {
+                    add(d_holdTicks, holdTicks);
+                }
+            };
+
+            static uint64_t ticks()
+            {
+            #if defined(__x86_64__) || defined(__i386__)
+                return __rdtsc();
+            #else
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            #endif
+            }
+
+            // CONTENDED_WAIT_NS in ticks
+            static uint64_t contendedTicks()
+            {
+                return registry().d_contendedTicks;
+            }
+
+            // Entry for a call site in the calling thread's table. Open addressing on
+            // (file, line); the last entry collects sites that did not fit
+            static Entry& entry(const std::source_location& loc)
+            {
+                Entry* entries = threadTable().d_entries;
+                const char* file = loc.file_name();
+                const uint32_t line = loc.line();
+                size_t index = (reinterpret_cast<uintptr_t>(file) ^ (line * 0x9E3779B1u)) % (SITES_PER_THREAD - 1);
+                for(size_t probes = 0; probes < SITES_PER_THREAD - 1; ++probes)
+                {
+                    Entry& candidate = entries[index];
+                    const char* candidateFile = candidate.d_file.load(std::memory_order_relaxed);
+                    if(!candidateFile)
+                    {
+                        candidate.d_line.store(line, std::memory_order_relaxed);
+                        candidate.d_function.store(loc.function_name(), std::memory_order_relaxed);
+                        candidate.d_file.store(file, std::memory_order_release);
+                        return candidate;
+                    }
+                    if(candidateFile == file && candidate.d_line.load(std::memory_order_relaxed) == line) [[likely]]
+                    {
+                        return candidate;
+                    }
+                    index = index + 1 == SITES_PER_THREAD - 1 ? 0 : index + 1;
+                }
+                Entry& overflow = entries[SITES_PER_THREAD - 1];
+                if(!overflow.d_file.load(std::memory_order_relaxed))
+                {
+                    overflow.d_function.store("<other sites>", std::memory_order_relaxed);
+                    overflow.d_file.store("<overflow>", std::memory_order_release);
+                }
+                return overflow;
+            }
+
+            // Per-site totals over all threads, most total wait time first
+            static std::vector<LockSiteStats> report(size_t top = 10)
+            {
+                std::vector<LockSiteStats> sites;
+                const double nsPerTick = nanosPerTick();
+                std::lock_guard<std::mutex> lk(registry().d_mx);
+                for(const auto& table : registry().d_tables)
+                {
+                    for(const Entry& e : table->d_entries)
+                    {
+                        const char* file = e.d_file.load(std::memory_order_acquire);
+                        if(!file)
+                        {
+                            continue;
+                        }
+                        const uint32_t line = e.d_line.load(std::memory_order_relaxed);
+                        auto it = std::find_if(sites.begin(), sites.end(), [&](const LockSiteStats& s){ return s.file == file && s.line == line; });
+                        if(it == sites.end())
+                        {
+                            sites.push_back(LockSiteStats{file, e.d_function.load(std::memory_order_relaxed), line, 0, 0, 0, 0, 0, 0});
+                            it = sites.end() - 1;
+                        }
+                        it->acquisitions += e.d_acquisitions.load(std::memory_order_relaxed);
+                        it->contended += e.d_contended.load(std::memory_order_relaxed);
+                        it->spins += e.d_spins.load(std::memory_order_relaxed);
+                        it->waitNs += e.d_waitTicks.load(std::memory_order_relaxed) * nsPerTick;
+                        it->holdNs += e.d_holdTicks.load(std::memory_order_relaxed) * nsPerTick;
+                        it->maxWaitNs = std::max(it->maxWaitNs, e.d_maxWaitTicks.load(std::memory_order_relaxed) * nsPerTick);
+                    }
+                }
+                std::sort(sites.begin(), sites.end(), [](const LockSiteStats& a, const LockSiteStats& b){ return a.waitNs > b.waitNs; });
+                if(sites.size() > top)
+                {
+                    sites.resize(top);
+                }
+                return sites;
+            }
+
+            static void print(std::ostream& os, size_t top = 10)
+            {
+                os << "file:line,function,acquisitions,contended,spins,wait_ns,hold_ns,max_wait_ns\n";
+                for(const LockSiteStats& s : report(top))
+                {
+                    os << s.file << ':' << s.line << ',' << s.function << ',' << s.acquisitions << ',' << s.contended << ','
+                       << s.spins << ',' << s.waitNs << ',' << s.holdNs << ',' << s.maxWaitNs << '\n';
+                }
+            }
+
+        private:
+            struct Table
+            {
+                Entry d_entries[SITES_PER_THREAD];
+            };
+
+            struct Registry
+            {
+                std::mutex d_mx;
+                std::vector<std::unique_ptr<Table>> d_tables;
+                // Both clocks at start, report() converts over everything since
+                const std::chrono::steady_clock::time_point d_wallStart = std::chrono::steady_clock::now();
+                const uint64_t d_tickStart = ticks();
+                const double d_quickNsPerTick = quickNanosPerTick();
+                const uint64_t d_contendedTicks = static_cast<uint64_t>(CONTENDED_WAIT_NS / d_quickNsPerTick);
+            };
+
+            static Registry& registry()
+            {
+                static Registry registry;
+                return registry;
+            }
+
+            // Registered once per thread, owned by the registry so it outlives the thread
+            static Table& threadTable()
+            {
+                thread_local Table* table = []()
+                {
+                    Registry& r = registry();
+                    std::lock_guard<std::mutex> lk(r.d_mx);
+                    r.d_tables.push_back(std::make_unique<Table>());
+                    return r.d_tables.back().get();
+                }();
+                return *table;
+            }
+
+            // Ticks against steady_clock while spinning for CALIBRATION_NS, precise enough for
+            // the contended threshold
+            static double quickNanosPerTick()
+            {
+            #if defined(__x86_64__) || defined(__i386__)
+                const auto wallStart = std::chrono::steady_clock::now();
+                const uint64_t tickStart = ticks();
+                double wall = 0;
+                while(wall < CALIBRATION_NS)
+                {
+                    cpu_relax();
+                    wall = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wallStart).count();
+                }
+                const uint64_t tickEnd = ticks();
+                return tickEnd > tickStart ? wall / (tickEnd - tickStart) : 1.0;
+            #else
+                return 1.0;
+            #endif
+            }
+
+            // For reports: over the whole run once it is long enough to beat the quick estimate
+            static double nanosPerTick()
+            {
+            #if defined(__x86_64__) || defined(__i386__)
+                const Registry& r = registry();
+                const double wall = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - r.d_wallStart).count();
+                const uint64_t elapsed = ticks() - r.d_tickStart;
+                return wall > 100 * CALIBRATION_NS && elapsed ? wall / elapsed : r.d_quickNsPerTick;
+            #else
+                return 1.0;
+            #endif
+            }
+    };
+
+    template<typename L, bool PROBE = false>
+        requires (!PROBE || requires(L& lock) { lock.try_lock(); })
+    class ProfiledLock
+    {
+        static constexpr uint64_t MAX_PROBES = 128;
+
+        private:
+            L d_lock;
+            // Written by the holder only
+            uint64_t d_acquiredAt{0};
+            LockProfiler::Entry* d_holderEntry{nullptr};
+
+            void acquired(LockProfiler::Entry& entry, uint64_t start, uint64_t spins, bool contended)
+            {
+                const uint64_t now = LockProfiler::ticks();
+                entry.recordAcquire(now - start, spins, contended);
+                d_acquiredAt = now;
+                d_holderEntry = &entry;
+            }
+
+        public:
+            void lock(std::source_location loc = std::source_location::current())
+            {
+                // Read first: the first call starts the profiler, which must not count as waiting
+                [[maybe_unused]] const uint64_t threshold = LockProfiler::contendedTicks();
+                const uint64_t start = LockProfiler::ticks();
+                if constexpr (PROBE)
+                {
+                    uint64_t spins = 0;
+                    while(!d_lock.try_lock())
+                    {
+                        if(++spins == MAX_PROBES)
+                        {
+                            d_lock.lock();
+                            break;
+                        }
+                        cpu_relax();
+                    }
+                    acquired(LockProfiler::entry(loc), start, spins, spins != 0);
+                }
+                else
+                {
+                    d_lock.lock();
+                    const bool contended = LockProfiler::ticks() - start > threshold;
+                    acquired(LockProfiler::entry(loc), start, 0, contended);
+                }
+            }
+
+            bool try_lock(std::source_location loc = std::source_location::current())
+            {
+                const uint64_t start = LockProfiler::ticks();
+                if(!d_lock.try_lock())
+                {
+                    return false;
+                }
+                acquired(LockProfiler::entry(loc), start, 0, false);
+                return true;
+            }
+
+            void unlock()
+            {
+                LockProfiler::Entry* entry = d_holderEntry;
+                const uint64_t held = LockProfiler::ticks() - d_acquiredAt;
+                d_lock.unlock();
+                entry->recordRelease(held);
+            }
+
+            L& underlying()
+            {
+                return d_lock;
+            }
+    };
+
+    // Scoped guard that attributes the acquisition to the line constructing it
+    template<typename Lock>
+    class ProfiledLockGuard
+    {
+        private:
+            Lock& d_lock;
+        public:
+            explicit ProfiledLockGuard(Lock& lock, std::source_location loc = std::source_location::current()) : d_lock(lock)
+            {
+                // Also accepts plain locks, so it can be used with MaybeProfiledLock
+                if constexpr (requires { d_lock.lock(loc); })
+                {
+                    d_lock.lock(loc);
+                }
+                else
+                {
+                    d_lock.lock();
+                }
+            }
+            ProfiledLockGuard(const ProfiledLockGuard&) = delete;
+            ProfiledLockGuard& operator=(const ProfiledLockGuard&) = delete;
+            ~ProfiledLockGuard()
+            {
+                d_lock.unlock();
+            }
+    };
+
+    // Build with -DSVR_PROFILE_LOCKS (e.g. canaries) to profile every lock declared through this
+    #if defined(SVR_PROFILE_LOCKS)
+    template<typename L>
+    using MaybeProfiledLock = ProfiledLock<L>;
+    #else
+    template<typename L>
+    using MaybeProfiledLock = L;
+    #endif
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SVR_SHARDED_COUNTER
+#define SVR_SHARDED_COUNTER
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+
+namespace svr
+{
+    /**
+    Statistics counter that many threads bump and somebody occasionally reads. One shared
+    atomic makes every increment pull the same line across cores; here each thread adds into
+    its own cache-line-padded shard and load() sums the shards.
+    a) The shard is picked by ThreadSlot rather than sched_getcpu(): a slot stays with its
+    thread, so the shard stays in that core's cache even when threads outnumber cores, and
+    no cpu lookup is needed per increment. Threads only share a shard when there are more
+    live slots than SHARDS (or a thread got ThreadSlot::INVALID), which is why adds are still a
+    relaxed fetch_add and not a plain store
+    b) load() only walks shards below ThreadSlot::high_water(), the rest were never written
+    c) load() is not a snapshot: adds racing with it may or may not be counted. Each add
+    is counted exactly once, so a counter that only grows is read monotonically by one reader
+    d) Relaxed throughout, the counter orders nothing else. Use a plain atomic for flags
+    */
+    template<typename T = long long, size_t SHARDS = 64>
+    class ShardedCounter
+    {
+        static_assert(std::is_integral_v<T>, "Shards are summed with integer wrap-around");
+        static_assert(SHARDS != 0, "Need at least one shard");
+
+        struct alignas(SVR_CACHELINE_SIZE) Shard
+        {
+            std::atomic<T> d_value{0};
+        };
+
+        private:
+            Shard d_shards[SHARDS];
+
+            size_t usedShards() const
+            {
+                size_t used = ThreadSlot::high_water();
+                return used < SHARDS ? used : SHARDS;
+            }
+
+        public:
+            ShardedCounter() = default;
+            ShardedCounter(const ShardedCounter&) = delete;
+            ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+            void add(T delta)
+            {
+                d_shards[ThreadSlot::id() % SHARDS].d_value.fetch_add(delta, std::memory_order_relaxed);
+            }
+
+            void increment()
+            {
+                add(1);
+            }
+
+            void decrement()
+            {
+                add(T(-1));
+            }
+
+            T load() const
+            {
+                T sum = 0;
+                for(size_t i = 0, used = usedShards(); i < used; ++i)
+                {
+                    sum += d_shards[i].d_value.load(std::memory_order_relaxed);
+                }
+                return sum;
+            }
+
+            // Zero every shard and return what was taken. Adds racing with it end up either
+            // in the returned value or in the counter afterwards, never lost
+            T exchange_zero()
+            {
+                T sum = 0;
+                for(size_t i = 0, used = usedShards(); i < used; ++i)
+                {
+                    sum += d_shards[i].d_value.exchange(0, std::memory_order_relaxed);
+                }
+                return sum;
+            }
+
+            static constexpr size_t shards()
+            {
+                return SHARDS;
+            }
+    };
+}
+
+#endif
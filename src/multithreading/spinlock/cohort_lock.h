@@ -0,0 +1,102 @@
+#ifndef SVR_COHORT_LOCK
+#define SVR_COHORT_LOCK
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "memory/unique_ptr.h"
+#include "multithreading/numa.h"
+#include "multithreading/spinlock/spinlock.h"
+
+/**
+ Lock cohorting (Dice, Marathe, Shavit) on top of ticket locks, a.k.a. C-TKT-TKT.
+
+ Every other lock here hands ownership to whichever core wins next, which on a multi-socket
+ box is often on the other socket, so the lock word and all the data the critical section
+ touches cross the interconnect on every hand-off. A cohort lock has one local lock per NUMA
+ node plus one global lock:
+ a) lock(): take the local lock of the node we run on, then the global lock unless the
+ previous local owner passed it to us
+ b) unlock(): if someone on the same node is queued on the local lock, keep the global
+ lock and pass it along with the local one, up to MAX_LOCAL_PASSES times in a row. Otherwise
+ (or when the bound is hit, so other nodes are not starved) release the global lock too
+ c) The global lock may be released by a different thread than the one that took it, so it
+ must be thread-oblivious. TicketSpinLock is; MCS is not
+ d) The local lock must be able to tell whether anyone is waiting behind the holder. A ticket
+ lock can: next ticket - now serving > 1
+ e) The holder's node is remembered in the lock, the thread may migrate between lock() and
+ unlock()
+ */
+namespace svr
+{
+    template<uint32_t MAX_LOCAL_PASSES = 64>
+    class CohortLock
+    {
+        struct alignas(SVR_CACHELINE_SIZE) LocalLock
+        {
+            std::atomic<size_t> d_nextTicket{0};
+            alignas(SVR_CACHELINE_SIZE) std::atomic<size_t> d_nowServing{0};
+            // Protected by the local lock itself
+            bool d_globalPassed{false};
+            uint32_t d_passes{0};
+
+            void lock()
+            {
+                const size_t ticket = d_nextTicket.fetch_add(1, std::memory_order_relaxed);
+                spin_until([this, ticket](){ return d_nowServing.load(std::memory_order_acquire) == ticket; });
+            }
+
+            bool hasWaiters() const
+            {
+                return d_nextTicket.load(std::memory_order_relaxed) - d_nowServing.load(std::memory_order_relaxed) > 1;
+            }
+
+            void unlock()
+            {
+                d_nowServing.store(d_nowServing.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+        };
+
+        private:
+            const NumaTopology& d_topology;
+            svr::unique_ptr<LocalLock[]> d_locals;
+            TicketSpinLock d_global;
+            // Written by the holder only
+            alignas(SVR_CACHELINE_SIZE) size_t d_ownerNode{0};
+
+        public:
+            CohortLock() : d_topology(NumaTopology::instance()), d_locals(new LocalLock[d_topology.numNodes()]) {}
+            CohortLock(const CohortLock&) = delete;
+            CohortLock& operator=(const CohortLock&) = delete;
+
+            void lock()
+            {
+                const size_t node = d_topology.node();
+                LocalLock& local = d_locals[node];
+                local.lock();
+                if(!local.d_globalPassed)
+                {
+                    d_global.lock();
+                }
+                d_ownerNode = node;
+            }
+
+            void unlock()
+            {
+                LocalLock& local = d_locals[d_ownerNode];
+                if(local.d_passes < MAX_LOCAL_PASSES && local.hasWaiters())
+                {
+                    ++local.d_passes;
+                    local.d_globalPassed = true;
+                    local.unlock();
+                    return;
+                }
+                local.d_passes = 0;
+                local.d_globalPassed = false;
+                d_global.unlock();
+                local.unlock();
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef SVR_RW_SPIN_LOCK
+#define SVR_RW_SPIN_LOCK
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "multithreading/spinlock/spinlock.h"
+#include "multithreading/thread_slot.h"
+
+/**
+ Reader-writer spin locks for read-mostly data. Both follow the std::shared_mutex interface
+ (lock/unlock/try_lock for writers, lock_shared/unlock_shared/try_lock_shared for readers), so
+ std::unique_lock and std::shared_lock work with them.
+
+ Both prefer writers: once a writer announces itself, new readers back off until it is done.
+ Writers are rare by assumption, so starving them behind an endless stream of readers is the
+ failure we care about. Readers cannot be starved the same way because writers leave as soon as
+ their (short) critical section ends
+ */
+namespace svr
+{
+    /**
+    One word: bit 0 writer holds the lock, bit 1 a writer is waiting, the rest is the reader count.
+    Simple and compact, but every reader does an RMW on the same line, so with many readers on
+    many cores the line still bounces. Use DistributedRWSpinLock when that shows up
+    */
+    class RWSpinLock
+    {
+        static constexpr uint32_t WRITER = 1;
+        static constexpr uint32_t WRITER_PENDING = 2;
+        static constexpr uint32_t READER = 4;
+
+        private:
+            alignas(SVR_CACHELINE_SIZE) std::atomic<uint32_t> d_state{0};
+            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<uint32_t>)]{};
+        public:
+            void lock()
+            {
+                unsigned spins = 0;
+                while(true)
+                {
+                    uint32_t state = d_state.load(std::memory_order_relaxed);
+                    // Only the pending bit may be set, i.e. no readers and no writer
+                    if((state & ~WRITER_PENDING) == 0)
+                    {
+                        if(d_state.compare_exchange_weak(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed)) [[likely]]
+                        {
+                            return;
+                        }
+                        continue;
+                    }
+                    // Acquiring clears the pending bit, so writers queued behind another
+                    // writer have to set it again
+                    if(!(state & WRITER_PENDING))
+                    {
+                        d_state.fetch_or(WRITER_PENDING, std::memory_order_relaxed);
+                    }
+                    spin_wait(spins);
+                }
+            }
+
+            bool try_lock()
+            {
+                uint32_t state = d_state.load(std::memory_order_relaxed);
+                return (state & ~WRITER_PENDING) == 0 &&
+                       d_state.compare_exchange_strong(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+            }
+
+            void unlock()
+            {
+                d_state.fetch_and(~WRITER, std::memory_order_release);
+            }
+
+            void lock_shared()
+            {
+                while(true)
+                {
+                    // Optimistic: one fetch_add instead of a CAS loop in the common case
+                    if(!(d_state.fetch_add(READER, std::memory_order_acquire) & (WRITER | WRITER_PENDING))) [[likely]]
+                    {
+                        return;
+                    }
+                    d_state.fetch_sub(READER, std::memory_order_relaxed);
+                    spin_until([this](){ return !(d_state.load(std::memory_order_relaxed) & (WRITER | WRITER_PENDING)); });
+                }
+            }
+
+            bool try_lock_shared()
+            {
+                if(!(d_state.fetch_add(READER, std::memory_order_acquire) & (WRITER | WRITER_PENDING)))
+                {
+                    return true;
+                }
+                d_state.fetch_sub(READER, std::memory_order_relaxed);
+                return false;
+            }
+
+            void unlock_shared()
+            {
+                d_state.fetch_sub(READER, std::memory_order_release);
+            }
+    };
+
+    /**
+    Reader count split over SLOTS cache-line-padded indicators, one picked per thread through
+    ThreadSlot. A reader only writes its own line, so read-side throughput scales with cores.
+    Writers pay instead: lock() raises d_writer (which turns new readers away) and then waits
+    for every indicator to drain.
+
+    Reader and writer each publish, then check the other side (reader: increment, then read
+    d_writer; writer: set d_writer, then read the indicators). That is a store-load pattern,
+    so those four operations are seq_cst; everything else can stay relaxed/acquire/release
+    */
+    template<size_t SLOTS = 64>
+    class DistributedRWSpinLock
+    {
+        static_assert(SLOTS != 0, "Need at least one reader indicator");
+        static_assert(SLOTS <= ThreadSlot::MAX_SLOTS, "Indicators beyond ThreadSlot::MAX_SLOTS are never used");
+
+        struct alignas(SVR_CACHELINE_SIZE) Indicator
+        {
+            std::atomic<uint32_t> d_readers{0};
+        };
+
+        private:
+            alignas(SVR_CACHELINE_SIZE) std::atomic<bool> d_writer{false};
+            Indicator d_indicators[SLOTS];
+
+            Indicator& myIndicator()
+            {
+                return d_indicators[ThreadSlot::id() % SLOTS];
+            }
+
+            // Slots above the high-water mark have never been handed to a thread, so their
+            // indicators are known to be zero and the writer can skip them. Threads without a
+            // slot share the indicator of INVALID, which may lie above the mark
+            size_t usedIndicators() const
+            {
+                constexpr size_t SHARED = ThreadSlot::INVALID % SLOTS + 1;
+                const size_t used = ThreadSlot::high_water();
+                return used > SHARED ? (used < SLOTS ? used : SLOTS) : SHARED;
+            }
+
+            void waitForReaders()
+            {
+                for(size_t i = 0, used = usedIndicators(); i < used; ++i)
+                {
+                    Indicator& indicator = d_indicators[i];
+                    spin_until([&indicator](){ return indicator.d_readers.load(std::memory_order_seq_cst) == 0; });
+                }
+            }
+
+        public:
+            void lock()
+            {
+                unsigned spins = 0;
+                while(true)
+                {
+                    bool expected = false;
+                    if(!d_writer.load(std::memory_order_relaxed) &&
+                       d_writer.compare_exchange_weak(expected, true, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                    spin_wait(spins);
+                }
+                waitForReaders();
+            }
+
+            bool try_lock()
+            {
+                bool expected = false;
+                if(!d_writer.compare_exchange_strong(expected, true, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return false;
+                }
+                for(size_t i = 0, used = usedIndicators(); i < used; ++i)
+                {
+                    if(d_indicators[i].d_readers.load(std::memory_order_seq_cst) != 0)
+                    {
+                        d_writer.store(false, std::memory_order_release);
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            void unlock()
+            {
+                d_writer.store(false, std::memory_order_release);
+            }
+
+            void lock_shared()
+            {
+                Indicator& indicator = myIndicator();
+                while(true)
+                {
+                    indicator.d_readers.fetch_add(1, std::memory_order_seq_cst);
+                    if(!d_writer.load(std::memory_order_seq_cst)) [[likely]]
+                    {
+                        return;
+                    }
+                    indicator.d_readers.fetch_sub(1, std::memory_order_relaxed);
+                    spin_until([this](){ return !d_writer.load(std::memory_order_acquire); });
+                }
+            }
+
+            bool try_lock_shared()
+            {
+                Indicator& indicator = myIndicator();
+                indicator.d_readers.fetch_add(1, std::memory_order_seq_cst);
+                if(!d_writer.load(std::memory_order_seq_cst))
+                {
+                    return true;
+                }
+                indicator.d_readers.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            // Must run on the thread that called lock_shared(), the indicator is per thread
+            void unlock_shared()
+            {
+                myIndicator().d_readers.fetch_sub(1, std::memory_order_release);
+            }
+    };
+}
+
+#endif
@@ -34,152 +34,608 @@ make it spin lock
 6) compare_exchange_weak() in loop performs better on some RISC architectures instead of 
 compare_exchange_strong()
 7) It might be nice to spin a few times before yielding. This is because spin locks are used for infrequently locked
-and small code blocks, so it might be the case that spinning a few more times will get the lock
+and small code blocks, so it might be the case that spinning a few more times will get the lock, see SpinThenYieldBackoff
 8) You need to think about throughput. In this case, when a thread releases the lock, there is a high
 change that it reacquires it back, so one thread is doing a lot of work, but we need every thread to make progress
 as well. Think about usage before thinking about the optimizations
-9) _mm_pause() can be used if hyperthreading is enabled
+9) _mm_pause() can be used if hyperthreading is enabled, see cpu_relax()
+10) TicketSpinLock, MCSSpinLock and CLHSpinLock address 8) by granting the lock in FIFO order. MCS and CLH
+also give every waiter its own cache line to spin on, so a release invalidates one line instead of
+one line in every waiting core
+11) All the combinations of 1), 2), 3), 7) and 9) are one SpinLock<Backoff, Padding, Word> template, and the
+named classes from before are aliases of it
 */
 
 #ifndef SVR_SPIN_LOCK
 #define SVR_SPIN_LOCK
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <new>
 #include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace svr
 {
-    class BasicSpinLockWithAtomicFlag
+    // Tell the core we are in a spin-wait loop. On x86 this is pause, which stops the
+    // pipeline from filling with speculative loads of the lock word and gives the sibling
+    // hyperthread the execution resources
+    inline void cpu_relax()
     {
-        private:
-            std::atomic_flag isLocked{};
-        public:
-            void lock()
+    #if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+    #elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+    #endif
+    }
+
+    #if defined(__cpp_lib_hardware_interference_size)
+    #define SVR_CACHELINE_SIZE std::hardware_destructive_interference_size
+    #else
+    #define SVR_CACHELINE_SIZE 64
+    #endif
+
+    // Waiters spin with pause for a while and then start yielding. With more threads than
+    // cores the thread holding the lock (or, for the FIFO locks, the thread the lock is handed
+    // to next) may be descheduled, and spinning cannot make progress until it runs again
+    inline constexpr unsigned SVR_SPINS_BEFORE_YIELD = 1024;
+
+    // One step of a wait loop, spins counts the steps taken so far
+    inline void spin_wait(unsigned& spins)
+    {
+        if(spins < SVR_SPINS_BEFORE_YIELD) [[likely]]
+        {
+            ++spins;
+            cpu_relax();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    template<typename Predicate>
+    void spin_until(Predicate&& done)
+    {
+        for(unsigned spins = 0; !done();)
+        {
+            spin_wait(spins);
+        }
+    }
+
+    /**
+    Backoff policies for SpinLock. lock() creates one per call and calls pause() after every
+    failed attempt, so stateful policies (exponential, spin-then-yield) start fresh each time.
+    The stateless ones are empty and inline away completely
+    */
+    struct NoBackoff
+    {
+        void pause() {}
+    };
+
+    struct PauseBackoff
+    {
+        void pause()
+        {
+            cpu_relax();
+        }
+    };
+
+    struct YieldBackoff
+    {
+        void pause()
+        {
+            std::this_thread::yield();
+        }
+    };
+
+    // Point 7: spin a few times before giving the core away
+    template<unsigned SPINS = SVR_SPINS_BEFORE_YIELD>
+    struct SpinThenYieldBackoff
+    {
+        unsigned d_spins{0};
+
+        void pause()
+        {
+            if(d_spins < SPINS) [[likely]]
             {
-                while(isLocked.test_and_set(std::memory_order_acquire));
+                ++d_spins;
+                cpu_relax();
             }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    };
 
-            void unlock()
+    // Pause for a random count in [limit/2, limit], then double the limit up to MAX_SPINS.
+    // The jitter keeps waiters that failed together from retrying together
+    template<unsigned MIN_SPINS = 4, unsigned MAX_SPINS = 1024>
+    struct ExponentialBackoff
+    {
+        static_assert(MIN_SPINS != 0 && MIN_SPINS <= MAX_SPINS);
+
+        unsigned d_limit{MIN_SPINS};
+
+        // xorshift32, one stream per thread
+        static unsigned random()
+        {
+            thread_local unsigned state = static_cast<unsigned>(reinterpret_cast<uintptr_t>(&state)) | 1u;
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        void pause()
+        {
+            for(unsigned spins = d_limit / 2 + random() % (d_limit / 2 + 1); spins != 0; --spins)
             {
-                isLocked.clear(std::memory_order_release);
+                cpu_relax();
             }
+            d_limit = d_limit * 2 < MAX_SPINS ? d_limit * 2 : MAX_SPINS;
+        }
     };
 
-    class BasicSpinLockWithAtomicBool
+    // Padding policies: whether the lock gets a cache line to itself (point 1)
+    struct NoPadding
     {
-        private:
-            std::atomic<bool> isLocked{false};
-        public:
-            void lock()
+        template<typename Word>
+        static constexpr size_t alignment = alignof(Word);
+    };
+
+    struct CacheLinePadding
+    {
+        template<typename Word>
+        static constexpr size_t alignment = SVR_CACHELINE_SIZE;
+    };
+
+    /**
+    Lock word policies: the flag type and how it is acquired. Each one spins with whatever
+    Backoff the lock hands it
+    */
+    // test_and_set on an atomic_flag until it was clear. Every attempt is an RMW
+    struct FlagTestAndSet
+    {
+        std::atomic_flag d_flag{};
+
+        template<typename Backoff>
+        void lock(Backoff& backoff)
+        {
+            while(d_flag.test_and_set(std::memory_order_acquire))
             {
-                while(!isLocked.exchange(true, std::memory_order_acquire));
+                backoff.pause();
             }
+        }
 
-            void unlock()
+        bool try_lock()
+        {
+            return !d_flag.test_and_set(std::memory_order_acquire);
+        }
+
+        void unlock()
+        {
+            d_flag.clear(std::memory_order_release);
+        }
+    };
+
+    // exchange on a bool until it returns false. Every attempt is an RMW
+    struct BoolExchange
+    {
+        std::atomic<bool> d_locked{false};
+
+        template<typename Backoff>
+        void lock(Backoff& backoff)
+        {
+            while(d_locked.exchange(true, std::memory_order_acquire))
             {
-                isLocked.store(false, std::memory_order_release);
+                backoff.pause();
             }
+        }
+
+        bool try_lock()
+        {
+            return !d_locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock()
+        {
+            d_locked.store(false, std::memory_order_release);
+        }
     };
 
-    #if defined(__cpp_lib_hardware_interference_size)
-    #define SVR_CACHELINE_SIZE std::hardware_destructive_interference_size
-    #else
-    #define SVR_CACHELINE_SIZE 64
-    #endif
-    class SpinLockWithAtomicFlagWithoutFalseSharing
+    // Point 2: read until the lock looks free and only then CAS, so waiters share the
+    // line instead of stealing it from each other
+    struct BoolTestAndTestAndSet
     {
-        private:
-            alignas(SVR_CACHELINE_SIZE) std::atomic_flag isLocked{};
-            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic_flag)];
-        public:
-            void lock()
+        std::atomic<bool> d_locked{false};
+
+        template<typename Backoff>
+        void lock(Backoff& backoff)
+        {
+            while(true)
             {
-                while(isLocked.test_and_set(std::memory_order_acquire));
+                if(!d_locked.load(std::memory_order_relaxed)) [[likely]]
+                {
+                    bool expected = false;
+                    if(d_locked.compare_exchange_weak(expected, true, std::memory_order_acquire, std::memory_order_relaxed)) [[likely]]
+                    {
+                        return;
+                    }
+                }
+                backoff.pause();
             }
+        }
 
-            void unlock()
+        bool try_lock()
+        {
+            bool expected = false;
+            return !d_locked.load(std::memory_order_relaxed) &&
+                   d_locked.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        void unlock()
+        {
+            d_locked.store(false, std::memory_order_release);
+        }
+    };
+
+    // Optimistic: try the exchange first (cheapest when uncontended), and after a failure
+    // wait with plain loads until the lock looks free again
+    struct BoolExchangeThenTest
+    {
+        std::atomic<bool> d_locked{false};
+
+        template<typename Backoff>
+        void lock(Backoff& backoff)
+        {
+            while(d_locked.exchange(true, std::memory_order_acquire))
             {
-                isLocked.clear(std::memory_order_release);
+                do
+                {
+                    backoff.pause();
+                } while(d_locked.load(std::memory_order_relaxed));
             }
+        }
+
+        bool try_lock()
+        {
+            return !d_locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock()
+        {
+            d_locked.store(false, std::memory_order_release);
+        }
     };
-    
-    class SpinLockWithAtomicBoolWithoutFalseSharing
+
+    /**
+    One spin lock, three compile-time knobs: what to do between attempts (Backoff), whether
+    to own a cache line (Padding) and how the lock word is taken (Word). Tune per call site
+    with an alias instead of copying a class
+    */
+    template<typename Backoff = SpinThenYieldBackoff<>, typename Padding = CacheLinePadding, typename Word = BoolTestAndTestAndSet>
+    class alignas(Padding::template alignment<Word>) SpinLock
     {
         private:
-            alignas(SVR_CACHELINE_SIZE) std::atomic<bool> isLocked;
-            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<bool>)];
+            Word d_word;
         public:
+            using backoff_type = Backoff;
+
             void lock()
             {
-                while(!isLocked.exchange(true, std::memory_order_acquire));
+                Backoff backoff;
+                d_word.lock(backoff);
+            }
+
+            bool try_lock()
+            {
+                return d_word.try_lock();
             }
 
             void unlock()
             {
-                isLocked.store(false, std::memory_order_release);
+                d_word.unlock();
             }
     };
 
-    class SpinLockWithOptimizedLoadsAndThreadYielding
+    using BasicSpinLockWithAtomicFlag = SpinLock<NoBackoff, NoPadding, FlagTestAndSet>;
+    using BasicSpinLockWithAtomicBool = SpinLock<NoBackoff, NoPadding, BoolExchange>;
+    using SpinLockWithAtomicFlagWithoutFalseSharing = SpinLock<NoBackoff, CacheLinePadding, FlagTestAndSet>;
+    using SpinLockWithAtomicBoolWithoutFalseSharing = SpinLock<NoBackoff, CacheLinePadding, BoolExchange>;
+    using SpinLockWithOptimizedLoadsAndThreadYielding = SpinLock<YieldBackoff, CacheLinePadding, BoolTestAndTestAndSet>;
+    using SpinLockWithOptimizedWritesAndThreadYielding = SpinLock<YieldBackoff, CacheLinePadding, BoolExchangeThenTest>;
+
+    static_assert(sizeof(SpinLockWithAtomicFlagWithoutFalseSharing) == SVR_CACHELINE_SIZE);
+    static_assert(sizeof(BasicSpinLockWithAtomicBool) == sizeof(std::atomic<bool>));
+
+    /**
+    FIFO lock: lock() draws a ticket with one fetch_add and waits until now serving reaches it,
+    so the thread that just released cannot win the lock straight back (point 8 above).
+    Waiters still share the d_nowServing line, but they only read it, and each backs off in
+    proportion to how far it is from the head of the queue so the line is not hammered
+    */
+    class TicketSpinLock
     {
+        static constexpr size_t BACKOFF_PER_WAITER = 32;
+
         private:
-            alignas(SVR_CACHELINE_SIZE) std::atomic<bool> isLocked{false};
-            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<bool>)]{};
+            alignas(SVR_CACHELINE_SIZE) std::atomic<size_t> d_nextTicket{0};
+            alignas(SVR_CACHELINE_SIZE) std::atomic<size_t> d_nowServing{0};
+            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<size_t>)]{};
         public:
             void lock()
             {
-                // test and test and set
+                const size_t ticket = d_nextTicket.fetch_add(1, std::memory_order_relaxed);
+                size_t spins = 0;
                 while(true)
                 {
-                    if(!isLocked.load(std::memory_order_relaxed)) [[likely]]
+                    const size_t serving = d_nowServing.load(std::memory_order_acquire);
+                    if(serving == ticket) [[likely]]
+                    {
+                        return;
+                    }
+                    if(spins < SVR_SPINS_BEFORE_YIELD) [[likely]]
                     {
-                        bool expected = false;
-                        isLocked.compare_exchange_weak(expected, true, std::memory_order_acquire, std::memory_order_relaxed);
-                        if(!expected) [[likely]]
+                        for(size_t i = (ticket - serving) * BACKOFF_PER_WAITER; i != 0; --i, ++spins)
                         {
-                            break;
+                            cpu_relax();
                         }
                     }
-                    
-                    // yield core 
-                    std::this_thread::yield();
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
                 }
             }
 
+            bool try_lock()
+            {
+                size_t serving = d_nowServing.load(std::memory_order_acquire);
+                return d_nextTicket.compare_exchange_strong(serving, serving + 1, std::memory_order_acquire, std::memory_order_relaxed);
+            }
+
             void unlock()
             {
-                isLocked.store(false, std::memory_order_release);
+                // Only the holder writes d_nowServing
+                d_nowServing.store(d_nowServing.load(std::memory_order_relaxed) + 1, std::memory_order_release);
             }
     };
 
-    class SpinLockWithOptimizedWritesAndThreadYielding
+    /**
+    Mellor-Crummey and Scott queue lock. Every waiter enqueues its own node with one exchange on
+    d_tail and then spins on the flag inside that node, i.e. on its own cache line. unlock()
+    writes exactly one remote line, the successor's flag, so the hand-off costs one cache
+    line transfer no matter how many threads are waiting, and the order is FIFO.
+
+    lock(Node&)/unlock(Node&) let the caller supply the node (usually on its stack). Plain
+    lock()/unlock() take one from a small thread_local cache and remember it in d_owner, so
+    the class still fits std::lock_guard and the benchmark template
+    */
+    class MCSSpinLock
     {
+        public:
+            struct alignas(SVR_CACHELINE_SIZE) Node
+            {
+                std::atomic<Node*> d_next{nullptr};
+                std::atomic<bool> d_locked{false};
+            };
+
         private:
-            alignas(SVR_CACHELINE_SIZE) std::atomic<bool> isLocked{false};
-            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<bool>)]{};
+            static constexpr size_t CACHED_NODES = 8;
+
+            struct NodeCache
+            {
+                Node d_nodes[CACHED_NODES];
+                bool d_inUse[CACHED_NODES]{};
+            };
+
+            alignas(SVR_CACHELINE_SIZE) std::atomic<Node*> d_tail{nullptr};
+            // Written by the holder only, after it acquired
+            Node* d_owner{nullptr};
+            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<Node*>) - sizeof(Node*)]{};
+
+            static NodeCache& nodeCache()
+            {
+                thread_local NodeCache cache;
+                return cache;
+            }
+
+            // Nodes are only busy between lock() and unlock(), so a handful per thread
+            // covers any sane nesting depth. Beyond that fall back to the heap
+            static Node* takeNode()
+            {
+                NodeCache& cache = nodeCache();
+                for(size_t i = 0; i < CACHED_NODES; ++i)
+                {
+                    if(!cache.d_inUse[i])
+                    {
+                        cache.d_inUse[i] = true;
+                        return &cache.d_nodes[i];
+                    }
+                }
+                return new Node;
+            }
+
+            static void giveNode(Node* node)
+            {
+                NodeCache& cache = nodeCache();
+                if(node >= cache.d_nodes && node < cache.d_nodes + CACHED_NODES)
+                {
+                    cache.d_inUse[node - cache.d_nodes] = false;
+                    return;
+                }
+                delete node;
+            }
+
         public:
+            void lock(Node& node)
+            {
+                node.d_next.store(nullptr, std::memory_order_relaxed);
+                node.d_locked.store(true, std::memory_order_relaxed);
+                Node* prev = d_tail.exchange(&node, std::memory_order_acq_rel);
+                if(prev) [[unlikely]]
+                {
+                    prev->d_next.store(&node, std::memory_order_release);
+                    spin_until([&node](){ return !node.d_locked.load(std::memory_order_acquire); });
+                }
+            }
+
+            bool try_lock(Node& node)
+            {
+                node.d_next.store(nullptr, std::memory_order_relaxed);
+                Node* expected = nullptr;
+                return d_tail.compare_exchange_strong(expected, &node, std::memory_order_acquire, std::memory_order_relaxed);
+            }
+
+            void unlock(Node& node)
+            {
+                Node* next = node.d_next.load(std::memory_order_acquire);
+                if(!next)
+                {
+                    Node* expected = &node;
+                    if(d_tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) [[likely]]
+                    {
+                        return;
+                    }
+                    // Someone swapped d_tail but has not linked itself behind us yet
+                    spin_until([&node, &next](){ return (next = node.d_next.load(std::memory_order_acquire)) != nullptr; });
+                }
+                next->d_locked.store(false, std::memory_order_release);
+            }
+
             void lock()
             {
-                // test and test and set
-                while(true)
+                Node* node = takeNode();
+                lock(*node);
+                d_owner = node;
+            }
+
+            bool try_lock()
+            {
+                Node* node = takeNode();
+                if(!try_lock(*node))
+                {
+                    giveNode(node);
+                    return false;
+                }
+                d_owner = node;
+                return true;
+            }
+
+            void unlock()
+            {
+                Node* node = d_owner;
+                unlock(*node);
+                giveNode(node);
+            }
+    };
+
+    /**
+    Craig, Landin and Hagersten queue lock. Like MCS every waiter spins on its own line, but
+    here it is the predecessor's node: lock() publishes a locked node with one exchange on
+    d_tail and waits for the node it got back to be unlocked. unlock() is a single store and
+    never has to wait for a successor to link in, which MCS sometimes does.
+
+    The price is that nodes migrate: after unlock() the thread keeps its predecessor's node
+    and leaves its own in the queue. Ownership is conserved (each node belongs either to one
+    thread's spare list or to exactly one lock), so threads free their spares on exit and the
+    lock frees whatever node is left in d_tail
+    */
+    class CLHSpinLock
+    {
+        public:
+            struct alignas(SVR_CACHELINE_SIZE) Node
+            {
+                std::atomic<bool> d_locked{false};
+            };
+
+        private:
+            static constexpr size_t SPARE_NODES = 8;
+
+            struct SpareNodes
+            {
+                Node* d_nodes[SPARE_NODES]{};
+                ~SpareNodes()
                 {
-                    if(!isLocked.exchange(true, std::memory_order_acquire))
+                    for(Node* node : d_nodes)
                     {
-                        break;
+                        delete node;
                     }
+                }
+            };
 
-                    while(isLocked.load(std::memory_order_relaxed))
+            alignas(SVR_CACHELINE_SIZE) std::atomic<Node*> d_tail;
+            // Written by the holder only, after it acquired
+            Node* d_owner{nullptr};
+            Node* d_ownerPred{nullptr};
+            char padding_[SVR_CACHELINE_SIZE - sizeof(std::atomic<Node*>) - 2 * sizeof(Node*)]{};
+
+            static SpareNodes& spareNodes()
+            {
+                thread_local SpareNodes spares;
+                return spares;
+            }
+
+            static Node* takeNode()
+            {
+                SpareNodes& spares = spareNodes();
+                for(Node*& node : spares.d_nodes)
+                {
+                    if(node)
                     {
-                        // yield core 
-                        std::this_thread::yield();
+                        return std::exchange(node, nullptr);
                     }
                 }
+                return new Node;
+            }
+
+            static void giveNode(Node* node)
+            {
+                SpareNodes& spares = spareNodes();
+                for(Node*& spare : spares.d_nodes)
+                {
+                    if(!spare)
+                    {
+                        spare = node;
+                        return;
+                    }
+                }
+                delete node;
+            }
+
+        public:
+            CLHSpinLock() : d_tail(new Node) {}
+            CLHSpinLock(const CLHSpinLock&) = delete;
+            CLHSpinLock& operator=(const CLHSpinLock&) = delete;
+
+            ~CLHSpinLock()
+            {
+                delete d_tail.load(std::memory_order_relaxed);
+            }
+
+            void lock()
+            {
+                Node* node = takeNode();
+                node->d_locked.store(true, std::memory_order_relaxed);
+                Node* pred = d_tail.exchange(node, std::memory_order_acq_rel);
+                spin_until([pred](){ return !pred->d_locked.load(std::memory_order_acquire); });
+                d_owner = node;
+                d_ownerPred = pred;
             }
 
             void unlock()
             {
-                isLocked.store(false, std::memory_order_release);
+                Node* node = d_owner;
+                Node* pred = d_ownerPred;
+                node->d_locked.store(false, std::memory_order_release);
+                giveNode(pred);
             }
     };
 }
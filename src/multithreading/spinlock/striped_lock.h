@@ -0,0 +1,102 @@
+#ifndef SVR_STRIPED_LOCK
+#define SVR_STRIPED_LOCK
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "multithreading/spinlock/spinlock.h"
+
+namespace svr
+{
+    /**
+    Fixed array of locks for a table whose entries are locked independently (hash map buckets,
+    per-account balances). A key hashes to one stripe, so unrelated keys rarely wait on each
+    other, without paying for one lock per entry.
+    a) Each stripe sits on its own cache line (SVR_CACHELINE_SIZE), whatever the padding of L
+    itself, so neighbouring stripes do not false-share
+    b) std::hash of integers is the identity on libstdc++, so the hash is mixed (Fibonacci
+    hashing) before taking the stripe; otherwise keys with a common stride pile onto few stripes
+    c) L is any lock with lock()/unlock() (everything in spinlock.h, AdaptiveMutex,
+    std::mutex, ...). MCSSpinLock works through its lock()/unlock() overloads
+    d) Locks that need several stripes take them through lock_all() or in increasing stripe
+    order, like lock_all() does, to avoid deadlock
+    */
+    template<typename L = SpinLock<>, size_t STRIPES = 64>
+    class StripedLock
+    {
+        static_assert(STRIPES != 0, "Need at least one stripe");
+
+        struct alignas(SVR_CACHELINE_SIZE) Stripe
+        {
+            L d_lock;
+        };
+
+        private:
+            Stripe d_stripes[STRIPES];
+
+        public:
+            StripedLock() = default;
+            StripedLock(const StripedLock&) = delete;
+            StripedLock& operator=(const StripedLock&) = delete;
+
+            template<typename Key>
+            static size_t stripe_of(const Key& key)
+            {
+                uint64_t h = static_cast<uint64_t>(std::hash<Key>{}(key)) * 0x9E3779B97F4A7C15ull;
+                return static_cast<size_t>(h >> 32) % STRIPES;
+            }
+
+            template<typename Key>
+            L& lock_for(const Key& key)
+            {
+                return d_stripes[stripe_of(key)].d_lock;
+            }
+
+            L& stripe(size_t index)
+            {
+                return d_stripes[index].d_lock;
+            }
+
+            template<typename Key>
+            void lock(const Key& key)
+            {
+                lock_for(key).lock();
+            }
+
+            template<typename Key>
+            bool try_lock(const Key& key)
+            {
+                return lock_for(key).try_lock();
+            }
+
+            template<typename Key>
+            void unlock(const Key& key)
+            {
+                lock_for(key).unlock();
+            }
+
+            // Whole-table operations (resize, clear)
+            void lock_all()
+            {
+                for(Stripe& s : d_stripes)
+                {
+                    s.d_lock.lock();
+                }
+            }
+
+            void unlock_all()
+            {
+                for(size_t i = STRIPES; i-- > 0;)
+                {
+                    d_stripes[i].d_lock.unlock();
+                }
+            }
+
+            static constexpr size_t stripes()
+            {
+                return STRIPES;
+            }
+    };
+}
+
+#endif
@@ -51,6 +51,12 @@ namespace svr
                 
             }
 
+            // For allocators without a default state, e.g. ArenaAllocator
+            explicit SpscBounded(const Alloc& alloc) : d_alloc(alloc), d_arr(d_alloc.allocate(N + 2*NUM_PADDING_ELEMENTS))
+            {
+
+            }
+
             ~SpscBounded()
             {
                 d_alloc.deallocate(d_arr, N + 2*NUM_PADDING_ELEMENTS);
@@ -117,6 +123,11 @@ namespace svr
 
             }
 
+            explicit SpscBoundedMutex(const Alloc& alloc):d_alloc(alloc), d_arr(d_alloc.allocate(N))
+            {
+
+            }
+
             ~SpscBoundedMutex()
             {
                 d_alloc.deallocate(d_arr, N);
@@ -0,0 +1,82 @@
+#ifndef SVR_THREAD_SLOT
+#define SVR_THREAD_SLOT
+
+#include <atomic>
+#include <cstddef>
+
+#ifndef SVR_MAX_THREAD_SLOTS
+#define SVR_MAX_THREAD_SLOTS 256
+#endif
+
+namespace svr
+{
+    /**
+    Hands out a small dense integer per live thread, so per-thread state can live in a plain
+    array indexed by slot instead of a thread_local map (which would allocate and could not be
+    walked by other threads).
+    a) A slot is released when its thread exits and may be handed to a new thread later, so
+    whatever is stored per slot must be valid for "whoever owns the slot now", not for one
+    particular thread
+    b) Release and acquire of a slot are a release store / acquire CAS pair, so everything the
+    previous owner wrote is visible to the next one
+    c) Threads beyond SVR_MAX_THREAD_SLOTS get INVALID and callers must take a shared slow path
+    */
+    class ThreadSlot
+    {
+        public:
+            static constexpr size_t MAX_SLOTS = SVR_MAX_THREAD_SLOTS;
+            static constexpr size_t INVALID = MAX_SLOTS;
+
+            // Slot of the calling thread, assigned on first use
+            static size_t id()
+            {
+                thread_local Holder holder;
+                return holder.d_id;
+            }
+
+            // One past the highest slot ever handed out. Scanners (e.g. aggregating
+            // per-slot counters) only need to look at [0, high_water()). Updates and loads are
+            // seq_cst so a scanner that publishes a flag and then reads this cannot miss a
+            // thread that registered before checking that flag
+            static size_t high_water()
+            {
+                return s_highWater.load(std::memory_order_seq_cst);
+            }
+
+        private:
+            struct Holder
+            {
+                size_t d_id;
+                Holder() : d_id(acquire()) {}
+                ~Holder()
+                {
+                    if(d_id != INVALID)
+                    {
+                        s_used[d_id].store(false, std::memory_order_release);
+                    }
+                }
+            };
+
+            static size_t acquire()
+            {
+                for(size_t i = 0; i < MAX_SLOTS; ++i)
+                {
+                    bool expected = false;
+                    if(!s_used[i].load(std::memory_order_relaxed) &&
+                       s_used[i].compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed))
+                    {
+                        size_t highWater = s_highWater.load(std::memory_order_seq_cst);
+                        while(highWater < i + 1 &&
+                              !s_highWater.compare_exchange_weak(highWater, i + 1, std::memory_order_seq_cst, std::memory_order_seq_cst));
+                        return i;
+                    }
+                }
+                return INVALID;
+            }
+
+            static inline std::atomic<bool> s_used[MAX_SLOTS]{};
+            static inline std::atomic<size_t> s_highWater{0};
+    };
+}
+
+#endif
@@ -76,13 +76,13 @@ namespace svr
     // because we can't figure it out from the value they pass
     // which is always an l-value expression
     template<typename T>
-    T&& forward(typename svr::remove_reference<T>::type &value)
+    constexpr T&& forward(typename svr::remove_reference<T>::type &value) noexcept
     {
         return static_cast<T&&>(value);
     }
 
     template<typename T>
-    T&& forward(typename svr::remove_reference<T>::type &&value)
+    constexpr T&& forward(typename svr::remove_reference<T>::type &&value) noexcept
     {
         return static_cast<T&&>(value);
     }
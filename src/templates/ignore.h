@@ -6,12 +6,12 @@ namespace svr
     struct _ignore
     {
         template<typename T>
-        _ignore& operator=(T&& val)
+        constexpr _ignore& operator=(T&&)
         {
             return *this;
         }
     };
-    _ignore ignore;
+    inline _ignore ignore;
 }
 
 #endif
\ No newline at end of file
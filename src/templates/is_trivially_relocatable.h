@@ -0,0 +1,27 @@
+#ifndef SVR_IS_TRIVIALLY_RELOCATABLE
+#define SVR_IS_TRIVIALLY_RELOCATABLE
+
+#include <type_traits>
+#include "integral_constant.h"
+
+namespace svr
+{
+    /**
+    A type is trivially relocatable if moving an object to a new address and ending the old
+    one's lifetime can be done with memcpy. Every trivially copyable type is, and so are many
+    types with non-trivial special members that merely own a pointer (unique_ptr, most
+    strings and vectors), as long as nothing points back into the object itself.
+    Containers use this to grow and shift with one memcpy instead of a move and a destructor
+    per element. Types opt in by specializing:
+        template<> struct svr::is_trivially_relocatable<Handle> : svr::true_type {};
+    */
+    template<typename T>
+    struct is_trivially_relocatable : svr::integral_constant<bool, std::is_trivially_copyable_v<T>>
+    {
+    };
+
+    template<typename T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+}
+
+#endif
@@ -6,7 +6,7 @@
 namespace svr
 {
     template <typename T>
-    typename svr::remove_reference<T>::type &&move(T &&val)
+    constexpr typename svr::remove_reference<T>::type &&move(T &&val) noexcept
     {
         return static_cast<typename svr::remove_reference<T>::type &&>(val);
     }
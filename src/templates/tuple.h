@@ -1,67 +1,378 @@
 #ifndef SVR_TUPLE
 #define SVR_TUPLE
 
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "templates/forward.h"
+#include "templates/ignore.h"
+#include "templates/move.h"
+#include "templates/type_pack.h"
+
+/**
+ Flat tuple: every element is a leaf base tuple_leaf<I, T> of one class, built from an
+ index_sequence, instead of value + rest nested one level per element.
+ a) get<I> is a single cast to the leaf with index I, no chain of getter instantiations, and
+ type_at_t finds the element type without recursion either
+ b) Leaves hold their element as [[no_unique_address]], so empty elements (stateless
+ allocators, comparators, tags) take no space, the same trick unique_ptr uses for its deleter
+ c) Constructors perfectly forward, so elements are moved when possible and move-only types
+ such as unique_ptr work. The element-wise constructor is explicit exactly when one of the
+ conversions is
+ d) Elements may be references: tie() and forward_as_tuple() build such tuples, and assigning
+ to them assigns through the references
+ e) std::tuple_size and std::tuple_element are specialized, so structured bindings work.
+ apply() calls get unqualified, so it also unpacks std::tuple, std::pair and std::array
+ */
 namespace svr
 {
-    template <typename T, typename... Ts>
-    struct tuple
+    template<typename... Ts>
+    class tuple;
+
+    namespace detail
     {
-        tuple(const T &t, const Ts &...ts) : value(t), rest(ts...)
+        template<size_t I, typename T>
+        struct tuple_leaf;
+
+        struct tuple_access
         {
-        }
+            // The I-th element of t, with t's constness and value category
+            template<size_t I, typename Tuple>
+            static constexpr decltype(auto) get(Tuple&& t) noexcept
+            {
+                using T = std::remove_cvref_t<Tuple>;
+                using Element = typename T::template element<I>;
+                using Leaf = tuple_leaf<I, Element>;
+                if constexpr(std::is_const_v<std::remove_reference_t<Tuple>>)
+                {
+                    const Leaf& leaf = t.d_impl;
+                    if constexpr(std::is_lvalue_reference_v<Tuple>)
+                    {
+                        return static_cast<const Element&>(leaf.d_value);
+                    }
+                    else
+                    {
+                        return static_cast<const Element&&>(leaf.d_value);
+                    }
+                }
+                else
+                {
+                    Leaf& leaf = t.d_impl;
+                    if constexpr(std::is_lvalue_reference_v<Tuple>)
+                    {
+                        return static_cast<Element&>(leaf.d_value);
+                    }
+                    else
+                    {
+                        return static_cast<Element&&>(leaf.d_value);
+                    }
+                }
+            }
+        };
 
-        T value;
-        tuple<Ts...> rest;
-    };
+        template<size_t I, typename T>
+        struct tuple_leaf
+        {
+            [[no_unique_address]] T d_value;
 
-    template <typename T>
-    struct tuple<T>
-    {
-        tuple(const T &t) : value(t)
+            constexpr tuple_leaf() requires std::is_default_constructible_v<T> : d_value() {}
+
+            template<typename U>
+            constexpr tuple_leaf(std::in_place_t, U&& value) : d_value(svr::forward<U>(value))
+            {
+            }
+        };
+
+        template<typename Seq, typename... Ts>
+        struct tuple_impl;
+
+        template<size_t... Is, typename... Ts>
+        struct tuple_impl<std::index_sequence<Is...>, Ts...> : tuple_leaf<Is, Ts>...
         {
-        }
+            constexpr tuple_impl() = default;
 
-        T value;
-    };
+            template<typename... Us>
+            constexpr explicit tuple_impl(std::in_place_t, Us&&... values)
+                : tuple_leaf<Is, Ts>(std::in_place, svr::forward<Us>(values))...
+            {
+            }
+
+            // Element-wise assignment, through references as well
+            template<typename Other>
+            constexpr void assign(Other&& other)
+            {
+                ((static_cast<tuple_leaf<Is, Ts>&>(*this).d_value = tuple_access::get<Is>(svr::forward<Other>(other))), ...);
+            }
+        };
+    }
 
-    template <size_t N, typename T, typename... Ts>
-    struct nth_type : nth_type<N - 1, Ts...>
+    template<typename... Ts>
+    class tuple
     {
-        static_assert(N < sizeof...(Ts) + 1,
-                      "index out of bounds");
+        friend struct detail::tuple_access;
+
+        template<typename... Us>
+        friend class tuple;
+
+        template<size_t I>
+        using element = type_at_t<I, Ts...>;
+
+        using Impl = detail::tuple_impl<std::index_sequence_for<Ts...>, Ts...>;
+
+        static constexpr bool HAS_REFERENCE = (std::is_reference_v<Ts> || ...);
+
+        private:
+            [[no_unique_address]] Impl d_impl;
+
+            struct from_tuple_t
+            {
+            };
+
+            template<typename Other, size_t... Is>
+            constexpr tuple(from_tuple_t, Other&& other, std::index_sequence<Is...>)
+                : d_impl(std::in_place, detail::tuple_access::get<Is>(svr::forward<Other>(other))...)
+            {
+            }
+
+        public:
+            constexpr tuple() requires (std::is_default_constructible_v<Ts> && ...) = default;
+
+            constexpr tuple(const Ts&... values)
+                requires (sizeof...(Ts) >= 1 && (std::is_copy_constructible_v<Ts> && ...))
+                : d_impl(std::in_place, values...)
+            {
+            }
+
+            template<typename... Us>
+                requires (sizeof...(Us) == sizeof...(Ts) && sizeof...(Ts) >= 1 &&
+                          !(sizeof...(Ts) == 1 && (std::is_same_v<std::remove_cvref_t<Us>, tuple> && ...)) &&
+                          (std::is_constructible_v<Ts, Us&&> && ...))
+            constexpr explicit(!(std::is_convertible_v<Us&&, Ts> && ...)) tuple(Us&&... values)
+                : d_impl(std::in_place, svr::forward<Us>(values)...)
+            {
+            }
+
+            template<typename... Us>
+                requires (sizeof...(Us) == sizeof...(Ts) && !std::is_same_v<tuple<Us...>, tuple> &&
+                          (std::is_constructible_v<Ts, const Us&> && ...))
+            constexpr explicit(!(std::is_convertible_v<const Us&, Ts> && ...)) tuple(const tuple<Us...>& other)
+                : tuple(from_tuple_t{}, other, std::index_sequence_for<Ts...>{})
+            {
+            }
+
+            template<typename... Us>
+                requires (sizeof...(Us) == sizeof...(Ts) && !std::is_same_v<tuple<Us...>, tuple> &&
+                          (std::is_constructible_v<Ts, Us&&> && ...))
+            constexpr explicit(!(std::is_convertible_v<Us&&, Ts> && ...)) tuple(tuple<Us...>&& other)
+                : tuple(from_tuple_t{}, svr::move(other), std::index_sequence_for<Ts...>{})
+            {
+            }
+
+            constexpr tuple(const tuple&) = default;
+            constexpr tuple(tuple&&) = default;
+
+            constexpr tuple& operator=(const tuple&) requires (!HAS_REFERENCE) = default;
+            constexpr tuple& operator=(tuple&&) requires (!HAS_REFERENCE) = default;
+
+            // Tuples of references assign through them, as tie(a, b) = tie(c, d) expects
+            constexpr tuple& operator=(const tuple& other) requires HAS_REFERENCE
+            {
+                d_impl.assign(other);
+                return *this;
+            }
+
+            constexpr tuple& operator=(tuple&& other) requires HAS_REFERENCE
+            {
+                d_impl.assign(svr::move(other));
+                return *this;
+            }
+
+            template<typename... Us>
+                requires (sizeof...(Us) == sizeof...(Ts) && !std::is_same_v<tuple<Us...>, tuple> &&
+                          (std::is_assignable_v<Ts&, const Us&> && ...))
+            constexpr tuple& operator=(const tuple<Us...>& other)
+            {
+                d_impl.assign(other);
+                return *this;
+            }
+
+            template<typename... Us>
+                requires (sizeof...(Us) == sizeof...(Ts) && !std::is_same_v<tuple<Us...>, tuple> &&
+                          (std::is_assignable_v<Ts&, Us&&> && ...))
+            constexpr tuple& operator=(tuple<Us...>&& other)
+            {
+                d_impl.assign(svr::move(other));
+                return *this;
+            }
+
+            constexpr void swap(tuple& other)
+            {
+                [this, &other]<size_t... Is>(std::index_sequence<Is...>) {
+                    using std::swap;
+                    (swap(detail::tuple_access::get<Is>(*this), detail::tuple_access::get<Is>(other)), ...);
+                }(std::index_sequence_for<Ts...>{});
+            }
     };
 
-    template <typename T, typename... Ts>
-    struct nth_type<0, T, Ts...>
+    template<typename... Ts>
+    tuple(Ts...) -> tuple<Ts...>;
+
+    template<size_t I, typename... Ts>
+    constexpr type_at_t<I, Ts...>& get(tuple<Ts...>& t) noexcept
     {
-        using value_type = T;
-    };
+        return detail::tuple_access::get<I>(t);
+    }
 
-    template <size_t N>
-    struct getter
+    template<size_t I, typename... Ts>
+    constexpr const type_at_t<I, Ts...>& get(const tuple<Ts...>& t) noexcept
     {
-        template <typename T, typename... Ts>
-        static nth_type<N, T, Ts...>::value_type &get(tuple<T, Ts...> &t)
-        {
-            return getter<N - 1>::get(t.rest);
-        }
-    };
+        return detail::tuple_access::get<I>(t);
+    }
 
-    template <>
-    struct getter<0>
+    template<size_t I, typename... Ts>
+    constexpr type_at_t<I, Ts...>&& get(tuple<Ts...>&& t) noexcept
     {
-        template <typename T, typename... Ts>
-        static nth_type<0, T, Ts...>::value_type &get(tuple<T, Ts...> &t)
-        {
-            return t.value;
-        }
+        return detail::tuple_access::get<I>(svr::move(t));
+    }
+
+    template<size_t I, typename... Ts>
+    constexpr const type_at_t<I, Ts...>&& get(const tuple<Ts...>&& t) noexcept
+    {
+        return detail::tuple_access::get<I>(svr::move(t));
+    }
+
+    template<typename T, typename... Ts>
+    constexpr T& get(tuple<Ts...>& t) noexcept
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the tuple");
+        return detail::tuple_access::get<index_of_v<T, Ts...>>(t);
+    }
+
+    template<typename T, typename... Ts>
+    constexpr const T& get(const tuple<Ts...>& t) noexcept
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the tuple");
+        return detail::tuple_access::get<index_of_v<T, Ts...>>(t);
+    }
+
+    template<typename T, typename... Ts>
+    constexpr T&& get(tuple<Ts...>&& t) noexcept
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the tuple");
+        return detail::tuple_access::get<index_of_v<T, Ts...>>(svr::move(t));
+    }
+
+    template<typename T, typename... Ts>
+    constexpr const T&& get(const tuple<Ts...>&& t) noexcept
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the tuple");
+        return detail::tuple_access::get<index_of_v<T, Ts...>>(svr::move(t));
+    }
+
+    // Kept for code written against the recursive tuple; prefer type_at_t
+    template<size_t N, typename... Ts>
+    struct nth_type
+    {
+        using value_type = type_at_t<N, Ts...>;
     };
 
-    template <size_t N, typename... Ts>
-    typename nth_type<N, Ts...>::value_type &get(tuple<Ts...> &ts)
+    // Decays, and unwraps std::reference_wrapper into a reference like std::make_tuple
+    template<typename... Ts>
+    constexpr tuple<std::unwrap_ref_decay_t<Ts>...> make_tuple(Ts&&... values)
+    {
+        return tuple<std::unwrap_ref_decay_t<Ts>...>(svr::forward<Ts>(values)...);
+    }
+
+    template<typename... Ts>
+    constexpr tuple<Ts&&...> forward_as_tuple(Ts&&... values) noexcept
+    {
+        return tuple<Ts&&...>(svr::forward<Ts>(values)...);
+    }
+
+    // svr::ignore in a position drops that element
+    template<typename... Ts>
+    constexpr tuple<Ts&...> tie(Ts&... values) noexcept
+    {
+        return tuple<Ts&...>(values...);
+    }
+
+    // f(get<0>(t), get<1>(t), ...) with t's value category
+    template<typename F, typename Tuple>
+    constexpr decltype(auto) apply(F&& f, Tuple&& t)
+    {
+        return [&]<size_t... Is>(std::index_sequence<Is...>) -> decltype(auto) {
+            return std::invoke(svr::forward<F>(f), get<Is>(svr::forward<Tuple>(t))...);
+        }(std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<Tuple>>>{});
+    }
+
+    template<typename... Ts, typename... Us>
+        requires (sizeof...(Ts) == sizeof...(Us))
+    constexpr bool operator==(const tuple<Ts...>& lhs, const tuple<Us...>& rhs)
     {
-        return getter<N>::get(ts);
+        return [&]<size_t... Is>(std::index_sequence<Is...>) {
+            return ((svr::get<Is>(lhs) == svr::get<Is>(rhs)) && ...);
+        }(std::index_sequence_for<Ts...>{});
+    }
+
+    template<typename... Ts, typename... Us>
+        requires (sizeof...(Ts) == sizeof...(Us))
+    constexpr bool operator!=(const tuple<Ts...>& lhs, const tuple<Us...>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    // Lexicographic, element by element
+    template<typename... Ts, typename... Us>
+        requires (sizeof...(Ts) == sizeof...(Us))
+    constexpr bool operator<(const tuple<Ts...>& lhs, const tuple<Us...>& rhs)
+    {
+        return [&]<size_t... Is>(std::index_sequence<Is...>) {
+            bool less = false;
+            // Stops at the first element that differs
+            (void)((svr::get<Is>(lhs) < svr::get<Is>(rhs) ? (less = true) : svr::get<Is>(rhs) < svr::get<Is>(lhs)) || ...);
+            return less;
+        }(std::index_sequence_for<Ts...>{});
+    }
+
+    template<typename... Ts, typename... Us>
+        requires (sizeof...(Ts) == sizeof...(Us))
+    constexpr bool operator>(const tuple<Ts...>& lhs, const tuple<Us...>& rhs)
+    {
+        return rhs < lhs;
+    }
+
+    template<typename... Ts, typename... Us>
+        requires (sizeof...(Ts) == sizeof...(Us))
+    constexpr bool operator<=(const tuple<Ts...>& lhs, const tuple<Us...>& rhs)
+    {
+        return !(rhs < lhs);
+    }
+
+    template<typename... Ts, typename... Us>
+        requires (sizeof...(Ts) == sizeof...(Us))
+    constexpr bool operator>=(const tuple<Ts...>& lhs, const tuple<Us...>& rhs)
+    {
+        return !(lhs < rhs);
+    }
+
+    template<typename... Ts>
+    constexpr void swap(tuple<Ts...>& lhs, tuple<Ts...>& rhs)
+    {
+        lhs.swap(rhs);
     }
 }
 
-#endif
\ No newline at end of file
+template<typename... Ts>
+struct std::tuple_size<svr::tuple<Ts...>> : std::integral_constant<size_t, sizeof...(Ts)>
+{
+};
+
+template<size_t I, typename... Ts>
+struct std::tuple_element<I, svr::tuple<Ts...>>
+{
+    using type = svr::type_at_t<I, Ts...>;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SVR_TYPE_PACK
+#define SVR_TYPE_PACK
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/**
+ Indexing into a parameter pack without recursion. The naive nth_type peels one type per
+ instantiation, so get<N> on a pack of M types costs O(M) instantiations per use; here every
+ type is paired with its index once and the lookup is a single overload resolution
+ a) type_at_t<I, Ts...> is the I-th type of the pack
+ b) index_of_v<T, Ts...> is the index of the first T, count_of_v how often T occurs. Both are
+ constant expressions, index_of_v is sizeof...(Ts) when T is not in the pack
+ */
+namespace svr
+{
+    namespace detail
+    {
+        template<size_t I, typename T>
+        struct indexed_type
+        {
+            using type = T;
+        };
+
+        template<typename Seq, typename... Ts>
+        struct indexed_pack;
+
+        template<size_t... Is, typename... Ts>
+        struct indexed_pack<std::index_sequence<Is...>, Ts...> : indexed_type<Is, Ts>...
+        {
+        };
+
+        // Only the base with index I matches, so T is deduced from it
+        template<size_t I, typename T>
+        indexed_type<I, T> select_indexed(const indexed_type<I, T>&);
+    }
+
+    template<size_t I, typename... Ts>
+    struct type_at
+    {
+        static_assert(I < sizeof...(Ts), "index out of bounds");
+        using type = typename decltype(detail::select_indexed<I>(detail::indexed_pack<std::index_sequence_for<Ts...>, Ts...>{}))::type;
+    };
+
+    template<size_t I, typename... Ts>
+    using type_at_t = typename type_at<I, Ts...>::type;
+
+    template<typename T, typename... Ts>
+    inline constexpr size_t count_of_v = (size_t(0) + ... + size_t(std::is_same_v<T, Ts>));
+
+    template<typename T, typename... Ts>
+    inline constexpr size_t index_of_v = []() {
+        constexpr bool matches[] = {std::is_same_v<T, Ts>..., true};
+        size_t index = 0;
+        while(!matches[index])
+        {
+            ++index;
+        }
+        return index;
+    }();
+}
+
+#endif
@@ -0,0 +1,657 @@
+#ifndef SVR_VARIANT
+#define SVR_VARIANT
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "templates/forward.h"
+#include "templates/move.h"
+#include "templates/type_pack.h"
+
+/**
+ Tagged union for closed sets of message types, so dispatch is an indexed jump instead of a
+ virtual call through a heap-allocated object.
+
+ a) The alternatives live in one suitably aligned byte buffer next to the smallest unsigned
+ index that fits: variant<char, int> is 8 bytes, and the index takes one byte for up to 254
+ alternatives. The largest index value means valueless_by_exception
+ b) Special members are conditionally trivial (C++20 requires-clauses on defaulted members):
+ when every alternative is trivially destructible so is the variant, and when every
+ alternative is trivially copyable the variant is too, so it can be memcpy'd through a queue
+ c) visit(visitor, variants...) dispatches once on the combined index of all variants
+ (row-major). Up to 8 combinations that is a switch the optimizer inlines the visitor into,
+ beyond that one constexpr table of function pointers and a single indirect call. There is one
+ thin thunk per combination of alternatives, the minimum since each combination may call a
+ different overload, and no nested dispatch per variant. Every combination must return the
+ same type
+ d) Works with svr::overloads:
+    visit(overloads{[](const Ping&) {...}, [](const Order& o) {...}}, message);
+ e) Converting construction and assignment pick the alternative overload resolution would pick
+ from one function per alternative, minus narrowing conversions, as std::variant does.
+ Duplicate alternative types are allowed but then only reachable by index
+ f) If constructing a new alternative throws, the old one is already gone and the variant is
+ valueless; visit and get then throw bad_variant_access. Assignments that switch alternatives
+ construct a temporary first when that keeps the old value alive (nothrow move, throwing copy)
+ */
+namespace svr
+{
+    inline constexpr size_t variant_npos = static_cast<size_t>(-1);
+
+    struct monostate
+    {
+        constexpr bool operator==(const monostate&) const = default;
+        constexpr auto operator<=>(const monostate&) const = default;
+    };
+
+    class bad_variant_access : public std::exception
+    {
+        public:
+            const char* what() const noexcept override
+            {
+                return "svr::bad_variant_access";
+            }
+    };
+
+    template<typename... Ts>
+    class variant;
+
+    template<typename V>
+    struct variant_size;
+
+    template<typename... Ts>
+    struct variant_size<variant<Ts...>> : std::integral_constant<size_t, sizeof...(Ts)>
+    {
+    };
+
+    template<typename V>
+    struct variant_size<const V> : variant_size<V>
+    {
+    };
+
+    template<typename V>
+    inline constexpr size_t variant_size_v = variant_size<V>::value;
+
+    template<size_t I, typename V>
+    struct variant_alternative;
+
+    template<size_t I, typename... Ts>
+    struct variant_alternative<I, variant<Ts...>>
+    {
+        using type = type_at_t<I, Ts...>;
+    };
+
+    template<size_t I, typename V>
+    struct variant_alternative<I, const V>
+    {
+        using type = const typename variant_alternative<I, V>::type;
+    };
+
+    template<size_t I, typename V>
+    using variant_alternative_t = typename variant_alternative<I, V>::type;
+
+    namespace detail
+    {
+        template<size_t N>
+        using variant_index_t = std::conditional_t<(N < 255), uint8_t, std::conditional_t<(N < 65535), uint16_t, uint32_t>>;
+
+        inline constexpr size_t VARIANT_SWITCH_LIMIT = 8;
+
+        template<size_t I, typename R, typename F>
+        R invoke_index(F& f)
+        {
+            static_assert(std::is_same_v<decltype(f(std::integral_constant<size_t, I>{})), R>,
+                          "visit requires the same return type for every alternative");
+            return f(std::integral_constant<size_t, I>{});
+        }
+
+        // f(std::integral_constant<size_t, I>{}) for I == index. Up to VARIANT_SWITCH_LIMIT
+        // cases this is a switch, which the optimizer can turn into a jump table and inline f
+        // into; beyond that a constexpr table of N function pointers
+        template<size_t N, typename F>
+        decltype(auto) with_index(size_t index, F&& f)
+        {
+            using Fn = std::remove_reference_t<F>;
+            using R = decltype(f(std::integral_constant<size_t, 0>{}));
+            if constexpr(N <= VARIANT_SWITCH_LIMIT)
+            {
+                switch(index)
+                {
+                    case 0: return invoke_index<0, R>(f);
+                    case 1: if constexpr(1 < N) { return invoke_index<1, R>(f); } [[fallthrough]];
+                    case 2: if constexpr(2 < N) { return invoke_index<2, R>(f); } [[fallthrough]];
+                    case 3: if constexpr(3 < N) { return invoke_index<3, R>(f); } [[fallthrough]];
+                    case 4: if constexpr(4 < N) { return invoke_index<4, R>(f); } [[fallthrough]];
+                    case 5: if constexpr(5 < N) { return invoke_index<5, R>(f); } [[fallthrough]];
+                    case 6: if constexpr(6 < N) { return invoke_index<6, R>(f); } [[fallthrough]];
+                    case 7: if constexpr(7 < N) { return invoke_index<7, R>(f); } [[fallthrough]];
+                    default: __builtin_unreachable();
+                }
+            }
+            else
+            {
+                return [index, &f]<size_t... Is>(std::index_sequence<Is...>) -> R {
+                    static constexpr R (*table[])(Fn&) = {&invoke_index<Is, R, Fn>...};
+                    return table[index](f);
+                }(std::make_index_sequence<N>{});
+            }
+        }
+
+        struct variant_access
+        {
+            // The I-th alternative of v, unchecked, with v's constness and value category
+            template<size_t I, typename V>
+            static decltype(auto) get(V&& v)
+            {
+                using Variant = std::remove_reference_t<V>;
+                using T = variant_alternative_t<I, Variant>;
+                auto* ptr = std::launder(reinterpret_cast<T*>(&v.d_storage));
+                if constexpr(std::is_lvalue_reference_v<V>)
+                {
+                    return *ptr;
+                }
+                else
+                {
+                    return svr::move(*ptr);
+                }
+            }
+        };
+
+        // Converting constructor: one choose(T_i) per alternative, usable only without
+        // narrowing, and overload resolution on the argument picks the index
+        template<size_t I, typename T, typename U>
+        struct variant_candidate
+        {
+            static std::integral_constant<size_t, I> choose(T)
+                requires requires(U&& u) { std::type_identity_t<T[]>{svr::forward<U>(u)}; };
+        };
+
+        template<typename U, typename Seq, typename... Ts>
+        struct variant_candidates;
+
+        template<typename U, size_t... Is, typename... Ts>
+        struct variant_candidates<U, std::index_sequence<Is...>, Ts...> : variant_candidate<Is, Ts, U>...
+        {
+            using variant_candidate<Is, Ts, U>::choose...;
+        };
+
+        template<typename U, typename... Ts>
+        using variant_chosen = decltype(variant_candidates<U, std::index_sequence_for<Ts...>, Ts...>::choose(std::declval<U>()));
+
+        template<typename T>
+        struct is_in_place_tag : std::false_type
+        {
+        };
+
+        template<typename T>
+        struct is_in_place_tag<std::in_place_type_t<T>> : std::true_type
+        {
+        };
+
+        template<size_t I>
+        struct is_in_place_tag<std::in_place_index_t<I>> : std::true_type
+        {
+        };
+    }
+
+    template<typename... Ts>
+    class variant
+    {
+        static_assert(sizeof...(Ts) > 0, "variant needs at least one alternative");
+        static_assert(((!std::is_reference_v<Ts> && !std::is_array_v<Ts> && !std::is_void_v<Ts>) && ...),
+                      "alternatives must be object types");
+
+        friend struct detail::variant_access;
+
+        template<size_t I>
+        using Alt = type_at_t<I, Ts...>;
+
+        using index_type = detail::variant_index_t<sizeof...(Ts)>;
+        static constexpr index_type NPOS = static_cast<index_type>(-1);
+
+        static constexpr bool TRIVIALLY_DESTRUCTIBLE = (std::is_trivially_destructible_v<Ts> && ...);
+        static constexpr bool COPY_CONSTRUCTIBLE = (std::is_copy_constructible_v<Ts> && ...);
+        static constexpr bool MOVE_CONSTRUCTIBLE = (std::is_move_constructible_v<Ts> && ...);
+        static constexpr bool COPY_ASSIGNABLE = COPY_CONSTRUCTIBLE && (std::is_copy_assignable_v<Ts> && ...);
+        static constexpr bool MOVE_ASSIGNABLE = MOVE_CONSTRUCTIBLE && (std::is_move_assignable_v<Ts> && ...);
+        static constexpr bool TRIVIALLY_COPY_CONSTRUCTIBLE = (std::is_trivially_copy_constructible_v<Ts> && ...);
+        static constexpr bool TRIVIALLY_MOVE_CONSTRUCTIBLE = (std::is_trivially_move_constructible_v<Ts> && ...);
+        static constexpr bool TRIVIALLY_COPY_ASSIGNABLE =
+            TRIVIALLY_DESTRUCTIBLE && TRIVIALLY_COPY_CONSTRUCTIBLE && (std::is_trivially_copy_assignable_v<Ts> && ...);
+        static constexpr bool TRIVIALLY_MOVE_ASSIGNABLE =
+            TRIVIALLY_DESTRUCTIBLE && TRIVIALLY_MOVE_CONSTRUCTIBLE && (std::is_trivially_move_assignable_v<Ts> && ...);
+        static constexpr bool NOTHROW_MOVE_CONSTRUCTIBLE = (std::is_nothrow_move_constructible_v<Ts> && ...);
+
+        template<typename U>
+        static constexpr bool IS_CONVERTING_ARGUMENT =
+            !std::is_same_v<std::remove_cvref_t<U>, variant> && !detail::is_in_place_tag<std::remove_cvref_t<U>>::value;
+
+        private:
+            alignas(Ts...) unsigned char d_storage[std::max({sizeof(Ts)...})];
+            index_type d_index;
+
+            template<size_t I>
+            Alt<I>& ref()
+            {
+                return *std::launder(reinterpret_cast<Alt<I>*>(&d_storage));
+            }
+
+            template<size_t I>
+            const Alt<I>& ref() const
+            {
+                return *std::launder(reinterpret_cast<const Alt<I>*>(&d_storage));
+            }
+
+            void destroy()
+            {
+                if constexpr(!TRIVIALLY_DESTRUCTIBLE)
+                {
+                    if(d_index != NPOS)
+                    {
+                        detail::with_index<sizeof...(Ts)>(d_index, [this](auto i) {
+                            using T = Alt<decltype(i)::value>;
+                            ref<decltype(i)::value>().~T();
+                        });
+                    }
+                }
+                d_index = NPOS;
+            }
+
+            // Old alternative destroyed first; valueless if the constructor throws
+            template<size_t I, typename... Args>
+            Alt<I>& construct(Args&&... args)
+            {
+                destroy();
+                ::new(static_cast<void*>(&d_storage)) Alt<I>(svr::forward<Args>(args)...);
+                d_index = static_cast<index_type>(I);
+                return ref<I>();
+            }
+
+            // Switch to alternative I constructed from arg, keeping the old value if building a
+            // temporary first gives that guarantee at the cost of one nothrow move
+            template<size_t I, typename U>
+            void assignAlternative(U&& arg)
+            {
+                if(d_index == I)
+                {
+                    ref<I>() = svr::forward<U>(arg);
+                }
+                else if constexpr(std::is_nothrow_constructible_v<Alt<I>, U> || !std::is_nothrow_move_constructible_v<Alt<I>>)
+                {
+                    construct<I>(svr::forward<U>(arg));
+                }
+                else
+                {
+                    Alt<I> tmp(svr::forward<U>(arg));
+                    construct<I>(svr::move(tmp));
+                }
+            }
+
+        public:
+            variant() noexcept(std::is_nothrow_default_constructible_v<Alt<0>>)
+                requires std::is_default_constructible_v<Alt<0>>
+                : d_index(NPOS)
+            {
+                construct<0>();
+            }
+
+            template<typename U, size_t I = detail::variant_chosen<U, Ts...>::value>
+                requires IS_CONVERTING_ARGUMENT<U>
+            variant(U&& arg) noexcept(std::is_nothrow_constructible_v<Alt<I>, U>) : d_index(NPOS)
+            {
+                construct<I>(svr::forward<U>(arg));
+            }
+
+            template<size_t I, typename... Args>
+                requires std::is_constructible_v<Alt<I>, Args...>
+            explicit variant(std::in_place_index_t<I>, Args&&... args) : d_index(NPOS)
+            {
+                construct<I>(svr::forward<Args>(args)...);
+            }
+
+            template<typename T, typename... Args>
+                requires (count_of_v<T, Ts...> == 1 && std::is_constructible_v<T, Args...>)
+            explicit variant(std::in_place_type_t<T>, Args&&... args) : d_index(NPOS)
+            {
+                construct<index_of_v<T, Ts...>>(svr::forward<Args>(args)...);
+            }
+
+            variant(const variant&) requires TRIVIALLY_COPY_CONSTRUCTIBLE = default;
+
+            variant(const variant& other) requires (COPY_CONSTRUCTIBLE && !TRIVIALLY_COPY_CONSTRUCTIBLE) : d_index(NPOS)
+            {
+                if(other.d_index != NPOS)
+                {
+                    detail::with_index<sizeof...(Ts)>(other.d_index, [this, &other](auto i) {
+                        construct<decltype(i)::value>(other.template ref<decltype(i)::value>());
+                    });
+                }
+            }
+
+            variant(variant&&) requires TRIVIALLY_MOVE_CONSTRUCTIBLE = default;
+
+            variant(variant&& other) noexcept(NOTHROW_MOVE_CONSTRUCTIBLE)
+                requires (MOVE_CONSTRUCTIBLE && !TRIVIALLY_MOVE_CONSTRUCTIBLE)
+                : d_index(NPOS)
+            {
+                if(other.d_index != NPOS)
+                {
+                    detail::with_index<sizeof...(Ts)>(other.d_index, [this, &other](auto i) {
+                        construct<decltype(i)::value>(svr::move(other.template ref<decltype(i)::value>()));
+                    });
+                }
+            }
+
+            ~variant() requires TRIVIALLY_DESTRUCTIBLE = default;
+
+            ~variant() requires (!TRIVIALLY_DESTRUCTIBLE)
+            {
+                destroy();
+            }
+
+            variant& operator=(const variant&) requires TRIVIALLY_COPY_ASSIGNABLE = default;
+
+            variant& operator=(const variant& other) requires (COPY_ASSIGNABLE && !TRIVIALLY_COPY_ASSIGNABLE)
+            {
+                if(this == &other)
+                {
+                    return *this;
+                }
+                if(other.d_index == NPOS)
+                {
+                    destroy();
+                    return *this;
+                }
+                detail::with_index<sizeof...(Ts)>(other.d_index, [this, &other](auto i) {
+                    assignAlternative<decltype(i)::value>(other.template ref<decltype(i)::value>());
+                });
+                return *this;
+            }
+
+            variant& operator=(variant&&) requires TRIVIALLY_MOVE_ASSIGNABLE = default;
+
+            variant& operator=(variant&& other) noexcept(NOTHROW_MOVE_CONSTRUCTIBLE && (std::is_nothrow_move_assignable_v<Ts> && ...))
+                requires (MOVE_ASSIGNABLE && !TRIVIALLY_MOVE_ASSIGNABLE)
+            {
+                if(this == &other)
+                {
+                    return *this;
+                }
+                if(other.d_index == NPOS)
+                {
+                    destroy();
+                    return *this;
+                }
+                detail::with_index<sizeof...(Ts)>(other.d_index, [this, &other](auto i) {
+                    constexpr size_t I = decltype(i)::value;
+                    if(d_index == I)
+                    {
+                        ref<I>() = svr::move(other.template ref<I>());
+                    }
+                    else
+                    {
+                        construct<I>(svr::move(other.template ref<I>()));
+                    }
+                });
+                return *this;
+            }
+
+            template<typename U, size_t I = detail::variant_chosen<U, Ts...>::value>
+                requires (IS_CONVERTING_ARGUMENT<U> && std::is_assignable_v<Alt<I>&, U>)
+            variant& operator=(U&& arg)
+            {
+                assignAlternative<I>(svr::forward<U>(arg));
+                return *this;
+            }
+
+            template<size_t I, typename... Args>
+                requires std::is_constructible_v<Alt<I>, Args...>
+            Alt<I>& emplace(Args&&... args)
+            {
+                return construct<I>(svr::forward<Args>(args)...);
+            }
+
+            template<typename T, typename... Args>
+                requires (count_of_v<T, Ts...> == 1 && std::is_constructible_v<T, Args...>)
+            T& emplace(Args&&... args)
+            {
+                return construct<index_of_v<T, Ts...>>(svr::forward<Args>(args)...);
+            }
+
+            // variant_npos while valueless
+            size_t index() const noexcept
+            {
+                return d_index == NPOS ? variant_npos : d_index;
+            }
+
+            bool valueless_by_exception() const noexcept
+            {
+                return d_index == NPOS;
+            }
+
+            void swap(variant& other)
+            {
+                if(d_index == other.d_index)
+                {
+                    if(d_index != NPOS)
+                    {
+                        detail::with_index<sizeof...(Ts)>(d_index, [this, &other](auto i) {
+                            using std::swap;
+                            swap(ref<decltype(i)::value>(), other.template ref<decltype(i)::value>());
+                        });
+                    }
+                    return;
+                }
+                variant tmp(svr::move(other));
+                other = svr::move(*this);
+                *this = svr::move(tmp);
+            }
+    };
+
+    template<typename T, typename... Ts>
+    bool holds_alternative(const variant<Ts...>& v) noexcept
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the alternatives");
+        return v.index() == index_of_v<T, Ts...>;
+    }
+
+    template<size_t I, typename... Ts>
+    type_at_t<I, Ts...>& get(variant<Ts...>& v)
+    {
+        if(v.index() != I)
+        {
+            throw bad_variant_access();
+        }
+        return detail::variant_access::get<I>(v);
+    }
+
+    template<size_t I, typename... Ts>
+    const type_at_t<I, Ts...>& get(const variant<Ts...>& v)
+    {
+        if(v.index() != I)
+        {
+            throw bad_variant_access();
+        }
+        return detail::variant_access::get<I>(v);
+    }
+
+    template<size_t I, typename... Ts>
+    type_at_t<I, Ts...>&& get(variant<Ts...>&& v)
+    {
+        if(v.index() != I)
+        {
+            throw bad_variant_access();
+        }
+        return detail::variant_access::get<I>(svr::move(v));
+    }
+
+    template<size_t I, typename... Ts>
+    const type_at_t<I, Ts...>&& get(const variant<Ts...>&& v)
+    {
+        if(v.index() != I)
+        {
+            throw bad_variant_access();
+        }
+        return detail::variant_access::get<I>(svr::move(v));
+    }
+
+    template<typename T, typename... Ts>
+    T& get(variant<Ts...>& v)
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the alternatives");
+        return svr::get<index_of_v<T, Ts...>>(v);
+    }
+
+    template<typename T, typename... Ts>
+    const T& get(const variant<Ts...>& v)
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the alternatives");
+        return svr::get<index_of_v<T, Ts...>>(v);
+    }
+
+    template<typename T, typename... Ts>
+    T&& get(variant<Ts...>&& v)
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the alternatives");
+        return svr::get<index_of_v<T, Ts...>>(svr::move(v));
+    }
+
+    template<typename T, typename... Ts>
+    const T&& get(const variant<Ts...>&& v)
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the alternatives");
+        return svr::get<index_of_v<T, Ts...>>(svr::move(v));
+    }
+
+    // nullptr unless v holds alternative I
+    template<size_t I, typename... Ts>
+    type_at_t<I, Ts...>* get_if(variant<Ts...>* v) noexcept
+    {
+        return v && v->index() == I ? &detail::variant_access::get<I>(*v) : nullptr;
+    }
+
+    template<size_t I, typename... Ts>
+    const type_at_t<I, Ts...>* get_if(const variant<Ts...>* v) noexcept
+    {
+        return v && v->index() == I ? &detail::variant_access::get<I>(*v) : nullptr;
+    }
+
+    template<typename T, typename... Ts>
+    T* get_if(variant<Ts...>* v) noexcept
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the alternatives");
+        return svr::get_if<index_of_v<T, Ts...>>(v);
+    }
+
+    template<typename T, typename... Ts>
+    const T* get_if(const variant<Ts...>* v) noexcept
+    {
+        static_assert(count_of_v<T, Ts...> == 1, "T must occur exactly once in the alternatives");
+        return svr::get_if<index_of_v<T, Ts...>>(v);
+    }
+
+    // Each variant is forwarded with its value category. Throws bad_variant_access if any is
+    // valueless
+    template<typename Visitor, typename... Variants>
+    decltype(auto) visit(Visitor&& visitor, Variants&&... variants)
+    {
+        constexpr size_t COMBINATIONS = (size_t(1) * ... * variant_size_v<std::remove_reference_t<Variants>>);
+        if((variants.valueless_by_exception() || ...))
+        {
+            throw bad_variant_access();
+        }
+        // Row-major over the alternatives, the last variant varies fastest
+        size_t flat = 0;
+        ((flat = flat * variant_size_v<std::remove_reference_t<Variants>> + variants.index()), ...);
+        return detail::with_index<COMBINATIONS>(flat, [&visitor, &variants...](auto combination) -> decltype(auto) {
+            constexpr size_t SIZES[] = {variant_size_v<std::remove_reference_t<Variants>>..., 1};
+            // Alternative of the K-th variant in this combination
+            constexpr auto alternative = [SIZES](size_t k) {
+                size_t stride = 1;
+                for(size_t j = k + 1; j < sizeof...(Variants); ++j)
+                {
+                    stride *= SIZES[j];
+                }
+                return decltype(combination)::value / stride % SIZES[k];
+            };
+            return [&]<size_t... Ks>(std::index_sequence<Ks...>) -> decltype(auto) {
+                return std::invoke(svr::forward<Visitor>(visitor),
+                                   detail::variant_access::get<alternative(Ks)>(svr::forward<Variants>(variants))...);
+            }(std::index_sequence_for<Variants...>{});
+        });
+    }
+
+    template<typename... Ts>
+    bool operator==(const variant<Ts...>& lhs, const variant<Ts...>& rhs)
+    {
+        if(lhs.index() != rhs.index())
+        {
+            return false;
+        }
+        if(lhs.valueless_by_exception())
+        {
+            return true;
+        }
+        return detail::with_index<sizeof...(Ts)>(lhs.index(), [&lhs, &rhs](auto i) -> bool {
+            return detail::variant_access::get<decltype(i)::value>(lhs) == detail::variant_access::get<decltype(i)::value>(rhs);
+        });
+    }
+
+    template<typename... Ts>
+    bool operator!=(const variant<Ts...>& lhs, const variant<Ts...>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    // By index first (valueless before everything), then by value
+    template<typename... Ts>
+    bool operator<(const variant<Ts...>& lhs, const variant<Ts...>& rhs)
+    {
+        if(rhs.valueless_by_exception())
+        {
+            return false;
+        }
+        if(lhs.valueless_by_exception())
+        {
+            return true;
+        }
+        if(lhs.index() != rhs.index())
+        {
+            return lhs.index() < rhs.index();
+        }
+        return detail::with_index<sizeof...(Ts)>(lhs.index(), [&lhs, &rhs](auto i) -> bool {
+            return detail::variant_access::get<decltype(i)::value>(lhs) < detail::variant_access::get<decltype(i)::value>(rhs);
+        });
+    }
+
+    template<typename... Ts>
+    bool operator>(const variant<Ts...>& lhs, const variant<Ts...>& rhs)
+    {
+        return rhs < lhs;
+    }
+
+    template<typename... Ts>
+    bool operator<=(const variant<Ts...>& lhs, const variant<Ts...>& rhs)
+    {
+        return !(rhs < lhs);
+    }
+
+    template<typename... Ts>
+    bool operator>=(const variant<Ts...>& lhs, const variant<Ts...>& rhs)
+    {
+        return !(lhs < rhs);
+    }
+
+    template<typename... Ts>
+    void swap(variant<Ts...>& lhs, variant<Ts...>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "memory/aligned_buffer.h"
+#include "memory/unique_ptr.h"
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+using namespace svr;
+
+namespace {
+    int constructed = 0;
+    int destroyed = 0;
+
+    struct Counted {
+        int value;
+        Counted() : value(7) { ++constructed; }
+        ~Counted() { ++destroyed; }
+    };
+
+    bool alignedTo(const void* p, size_t alignment) {
+        return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+    }
+}
+
+TEST(AlignedBufferTest, MakeUniqueForOverwrite) {
+    auto single = make_unique_for_overwrite<Counted>();
+    EXPECT_EQ(single->value, 7);
+    auto bytes = make_unique_for_overwrite<unsigned char[]>(1 << 20);
+    std::memset(bytes.get(), 0xab, 1 << 20);
+    EXPECT_EQ(bytes[12345], 0xab);
+}
+
+TEST(AlignedBufferTest, CacheLineAndHugePageAlignment) {
+    auto line = make_unique_aligned_for_overwrite<double[]>(1000);
+    EXPECT_TRUE(alignedTo(line.get(), 64));
+    EXPECT_EQ(line.get_deleter().size(), 1000u);
+    line[999] = 1.5;
+    EXPECT_EQ(line[999], 1.5);
+
+    auto page = make_unique_aligned_for_overwrite<char[]>(3 * HUGE_PAGE_SIZE, HUGE_PAGE_SIZE);
+    EXPECT_TRUE(alignedTo(page.get(), HUGE_PAGE_SIZE));
+    page[3 * HUGE_PAGE_SIZE - 1] = 'x';
+}
+
+TEST(AlignedBufferTest, HugePageBuffer) {
+    auto buffer = make_unique_huge_pages_for_overwrite<uint64_t[]>(300000);
+    EXPECT_TRUE(alignedTo(buffer.get(), HUGE_PAGE_SIZE));
+    EXPECT_EQ(buffer.get_deleter().mapped_bytes(), HUGE_PAGE_SIZE * 2);
+    for (size_t i = 0; i < 300000; ++i) buffer[i] = i;
+    EXPECT_EQ(buffer[299999], 299999u);
+    buffer.reset();
+    EXPECT_FALSE(buffer);
+}
+
+TEST(AlignedBufferTest, ElementsAreConstructedAndDestroyed) {
+    constructed = destroyed = 0;
+    {
+        auto aligned = make_unique_aligned_for_overwrite<Counted[]>(10, 128);
+        auto huge = make_unique_huge_pages_for_overwrite<Counted[]>(5);
+        EXPECT_TRUE(alignedTo(aligned.get(), 128));
+        EXPECT_EQ(aligned[9].value, 7);
+        EXPECT_EQ(huge[4].value, 7);
+        EXPECT_EQ(constructed, 15);
+    }
+    EXPECT_EQ(destroyed, 15);
+}
+
+TEST(AlignedBufferTest, ArrayPointerWithDeleter) {
+    constructed = destroyed = 0;
+    Counted* raw = static_cast<Counted*>(::operator new(3 * sizeof(Counted), std::align_val_t(64)));
+    for (int i = 0; i < 3; ++i) new (raw + i) Counted();
+    {
+        unique_ptr<Counted[], AlignedArrayDeleter<Counted>> p(raw, AlignedArrayDeleter<Counted>(3, 64));
+        EXPECT_EQ(p[2].value, 7);
+    }
+    EXPECT_EQ(destroyed, 3);
+}
+
+TEST(AlignedBufferTest, OverflowingCountThrows) {
+    constructed = 0;
+    const size_t tooMany = SIZE_MAX / sizeof(uint64_t) + 1;
+    EXPECT_THROW(make_unique_aligned_for_overwrite<uint64_t[]>(tooMany), std::bad_array_new_length);
+    EXPECT_THROW(make_unique_aligned_for_overwrite<Counted[]>(SIZE_MAX / 2), std::bad_array_new_length);
+    EXPECT_THROW(make_unique_huge_pages_for_overwrite<uint64_t[]>(tooMany), std::bad_array_new_length);
+    // Fits in size_t, but not once rounded up to whole huge pages
+    EXPECT_THROW(make_unique_huge_pages_for_overwrite<char[]>(SIZE_MAX - HUGE_PAGE_SIZE), std::bad_array_new_length);
+    EXPECT_EQ(constructed, 0);
+}
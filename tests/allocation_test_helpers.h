@@ -0,0 +1,31 @@
+#ifndef SVR_ALLOCATION_TEST_HELPERS
+#define SVR_ALLOCATION_TEST_HELPERS
+
+#include <gtest/gtest.h>
+#include "helpers/allocation_tracker.h"
+
+/**
+ Fixtures for tests that check code paths do not allocate.
+
+ a) FailTestOnAllocation makes an AllocationGuard that sees an allocation fail the running test
+ instead of aborting the binary, for as long as it lives
+ */
+namespace svr::test
+{
+    inline void failTest(const char* what, const AllocationStats& stats)
+    {
+        ADD_FAILURE() << (what ? what : "AllocationGuard") << ": " << stats.allocations << " allocation(s), "
+                      << stats.bytes_allocated << " byte(s)";
+    }
+
+    struct FailTestOnAllocation
+    {
+        AllocationFailureHandler d_previous = set_allocation_failure_handler(&failTest);
+        FailTestOnAllocation() = default;
+        FailTestOnAllocation(const FailTestOnAllocation&) = delete;
+        FailTestOnAllocation& operator=(const FailTestOnAllocation&) = delete;
+        ~FailTestOnAllocation() { set_allocation_failure_handler(d_previous); }
+    };
+}
+
+#endif
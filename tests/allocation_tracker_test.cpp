@@ -0,0 +1,117 @@
+// The one translation unit of svr_tests that installs the counting operator new/delete
+#define SVR_DEFINE_ALLOCATION_HOOKS
+#include "helpers/allocation_tracker.h"
+#include "memory/shared_ptr.h"
+#include "multithreading/spsc/spscbounded.h"
+#include "allocation_test_helpers.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+namespace {
+struct alignas(128) OverAligned {
+    char c = 'x';
+};
+
+int g_failures = 0;
+AllocationStats g_lastFailure;
+
+void recordFailure(const char*, const AllocationStats& stats) {
+    ++g_failures;
+    g_lastFailure = stats;
+}
+
+}
+
+TEST(AllocationTrackerTest, HooksAreInstalled) {
+    EXPECT_TRUE(allocation_tracking_enabled());
+}
+
+TEST(AllocationTrackerTest, CountsNewAndDelete) {
+    AllocationStats before = allocation_stats();
+    int* p = new int(7);
+    AllocationStats afterNew = allocation_stats() - before;
+    EXPECT_EQ(afterNew.allocations, 1u);
+    EXPECT_EQ(afterNew.bytes_allocated, sizeof(int));
+    EXPECT_EQ(afterNew.deallocations, 0u);
+    delete p;
+    EXPECT_EQ((allocation_stats() - before).deallocations, 1u);
+}
+
+TEST(AllocationTrackerTest, CountsArrayAndAlignedForms) {
+    AllocationStats before = allocation_stats();
+    char* buffer = new char[100];
+    OverAligned* aligned = new OverAligned;
+    OverAligned* alignedArray = new OverAligned[3];
+    int* nothrow = new (std::nothrow) int;
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % alignof(OverAligned), 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(alignedArray) % alignof(OverAligned), 0u);
+    delete[] buffer;
+    delete aligned;
+    delete[] alignedArray;
+    delete nothrow;
+    AllocationStats stats = allocation_stats() - before;
+    EXPECT_EQ(stats.allocations, 4u);
+    EXPECT_EQ(stats.deallocations, 4u);
+    EXPECT_GE(stats.bytes_allocated, 100 + 4 * sizeof(OverAligned) + sizeof(int));
+}
+
+TEST(AllocationTrackerTest, CountersArePerThread) {
+    AllocationStats before = allocation_stats();
+    uint64_t otherThread = 0;
+    std::thread t([&otherThread]() {
+        AllocationStats start = allocation_stats();
+        std::vector<int> v(1000);
+        otherThread = (allocation_stats() - start).allocations;
+    });
+    t.join();
+    EXPECT_EQ(otherThread, 1u);
+    // Starting the thread allocates its state here, the vector's buffer is not counted
+    EXPECT_LT((allocation_stats() - before).bytes_allocated, 1000 * sizeof(int));
+}
+
+TEST(AllocationTrackerTest, GuardReportsAllocations) {
+    g_failures = 0;
+    AllocationFailureHandler previous = set_allocation_failure_handler(&recordFailure);
+    {
+        AllocationGuard guard("quiet");
+        int x = 1;
+        x += 1;
+        EXPECT_EQ(x, 2);
+    }
+    EXPECT_EQ(g_failures, 0);
+    {
+        AllocationGuard guard("allocates");
+        std::string s(200, 'a');
+        EXPECT_EQ(guard.allocations().allocations, 1u);
+    }
+    set_allocation_failure_handler(previous);
+    EXPECT_EQ(g_failures, 1);
+    EXPECT_EQ(g_lastFailure.allocations, 1u);
+    EXPECT_GE(g_lastFailure.bytes_allocated, 200u);
+}
+
+TEST(AllocationTrackerTest, SpscPushPopDoesNotAllocate) {
+    test::FailTestOnAllocation fail;
+    SpscBounded<int, 64> q;
+    int val = 0;
+    AllocationGuard guard("SpscBounded::try_push/try_pop");
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(q.try_push(i));
+        ASSERT_TRUE(q.try_pop(val));
+    }
+}
+
+TEST(AllocationTrackerTest, SharedPtrCopyDoesNotAllocate) {
+    test::FailTestOnAllocation fail;
+    shared_ptr<int> p = make_shared<int>(5);
+    AllocationGuard guard("svr::shared_ptr copy");
+    for (int i = 0; i < 1000; ++i) {
+        shared_ptr<int> copy = p;
+        shared_ptr<int> moved = std::move(copy);
+        EXPECT_EQ(*moved, 5);
+    }
+}
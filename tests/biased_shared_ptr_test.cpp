@@ -0,0 +1,97 @@
+#include "memory/biased_shared_ptr.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+using Tracked = test::Tracked<struct BiasedSharedPtrTag>;
+}
+
+TEST(BiasedSharedPtrTest, OwnerCopiesStayBiased) {
+    {
+        auto p = make_biased_shared<Tracked>(1);
+        EXPECT_TRUE(p.biased_to_current_thread());
+        std::vector<biased_shared_ptr<Tracked>> copies(8, p);
+        EXPECT_EQ(copies[3]->value, 1);
+        copies.clear();
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(BiasedSharedPtrTest, OwnerDropsFirstThenOthers) {
+    auto p = make_biased_shared<Tracked>(2);
+    std::vector<biased_shared_ptr<Tracked>> handedOff(4, p);
+    p.reset(); // owner still holds the copies in handedOff, created on this thread
+    std::vector<std::thread> threads;
+    for (auto& copy : handedOff) {
+        threads.emplace_back([copy = std::move(copy)]() mutable {
+            biased_shared_ptr<Tracked> local = copy;
+            EXPECT_EQ(local->value, 2);
+            EXPECT_FALSE(local.biased_to_current_thread());
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(Tracked::alive, 1); // last references went negative on the shared count
+    BiasRecord::merge_queued();
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(BiasedSharedPtrTest, OthersDropLastReferenceWhileOwnerIsAlive) {
+    auto p = make_biased_shared<Tracked>(3);
+    std::thread other([q = std::move(p)]() mutable {
+        q.reset(); // drives the shared count negative, the block waits in the owner's queue
+    });
+    other.join();
+    // The owner merges queued blocks on its next biased release
+    auto unrelated = make_biased_shared<Tracked>(4);
+    unrelated.reset();
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(BiasedSharedPtrTest, OwnerExitsBeforeOthers) {
+    std::vector<biased_shared_ptr<Tracked>> fromDeadOwner;
+    std::thread owner([&]() {
+        auto p = make_biased_shared<Tracked>(5);
+        fromDeadOwner.assign(3, p);
+    });
+    owner.join();
+    EXPECT_EQ(Tracked::alive, 1);
+    std::vector<std::thread> threads;
+    for (auto& copy : fromDeadOwner) {
+        threads.emplace_back([copy = std::move(copy)]() mutable {
+            for (int i = 0; i < 1000; ++i) {
+                biased_shared_ptr<Tracked> local = copy;
+                EXPECT_EQ(local->value, 5);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(BiasedSharedPtrTest, ConcurrentCopiesFromOwnerAndOthers) {
+    for (int round = 0; round < 20; ++round) {
+        auto p = make_biased_shared<Tracked>(round);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 3; ++i) {
+            threads.emplace_back([p, round]() {
+                for (int j = 0; j < 500; ++j) {
+                    biased_shared_ptr<Tracked> local = p;
+                    EXPECT_EQ(local->value, round);
+                }
+            });
+        }
+        for (int j = 0; j < 500; ++j) {
+            biased_shared_ptr<Tracked> local = p;
+        }
+        p.reset();
+        for (auto& t : threads) t.join();
+        auto flush = make_biased_shared<Tracked>(0);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
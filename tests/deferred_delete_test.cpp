@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "memory/deferred_delete.h"
+#include "memory/shared_ptr.h"
+#include "memory/unique_ptr.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+    using Counted = test::Tracked<struct DeferredDeleteTag>;
+    std::atomic<int> destroyedOnCaller{0};
+    thread_local bool isCaller = false;
+
+    struct Graph : Counted {
+        std::vector<int> nodes;
+        Graph() : Counted(0), nodes(100, 1) {}
+        ~Graph() {
+            if (isCaller) ++destroyedOnCaller;
+        }
+    };
+}
+
+TEST(DeferredDeleteTest, UniquePtrDestroysOnReclaimerThread) {
+    isCaller = true;
+    destroyedOnCaller = 0;
+    {
+        unique_ptr<Graph, deferred_delete<Graph>> p(new Graph());
+        EXPECT_EQ(Counted::alive, 1);
+    }
+    DeferredReclaimer::instance().drain();
+    EXPECT_EQ(Counted::alive, 0);
+    EXPECT_EQ(destroyedOnCaller, 0);
+    isCaller = false;
+}
+
+TEST(DeferredDeleteTest, SharedPtrAndArrays) {
+    {
+        shared_ptr<Graph> a(new Graph(), deferred_delete<Graph>());
+        shared_ptr<Graph> b = a;
+        unique_ptr<Graph[], deferred_delete<Graph[]>> arr(new Graph[3]);
+        EXPECT_EQ(Counted::alive, 4);
+    }
+    DeferredReclaimer::instance().drain();
+    EXPECT_EQ(Counted::alive, 0);
+}
+
+TEST(DeferredDeleteTest, ManyThreadsThenDestructorDrains) {
+    {
+        DeferredReclaimer reclaimer;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&reclaimer]() {
+                // 1000 is not a multiple of the batch size, so partial batches are left over
+                for (int i = 0; i < 1000; ++i) reclaimer.retire(new Graph());
+            });
+        }
+        for (auto& t : threads) t.join();
+        reclaimer.drain();
+        EXPECT_LT(Counted::alive, 4000);
+    }
+    EXPECT_EQ(Counted::alive, 0);
+}
+
+TEST(DeferredDeleteTest, BackpressureDestroysInline) {
+    isCaller = true;
+    destroyedOnCaller = 0;
+    {
+        DeferredReclaimer reclaimer(1);
+        for (int i = 0; i < 20000; ++i) reclaimer.retire(new Graph());
+        reclaimer.drain();
+        EXPECT_LE(reclaimer.pending(), 1u);
+    }
+    EXPECT_EQ(Counted::alive, 0);
+    EXPECT_GT(destroyedOnCaller, 0);
+    isCaller = false;
+}
+
+namespace {
+    DeferredReclaimer* g_target = nullptr;
+
+    // Defers its children into g_target when destroyed, depth levels down
+    struct Parent : Counted {
+        std::vector<Parent*> children;
+        Parent(int numChildren, int depth) : Counted(depth) {
+            if (depth > 0) {
+                for (int i = 0; i < numChildren; ++i) children.push_back(new Parent(numChildren, depth - 1));
+            }
+        }
+        ~Parent() {
+            for (Parent* child : children) g_target->retire(child);
+        }
+    };
+}
+
+TEST(DeferredDeleteTest, DrainWaitsForObjectsDeferredByDeleters) {
+    DeferredReclaimer reclaimer;
+    g_target = &reclaimer;
+    // Fewer children than a batch, so they sit in the reclaimer thread's partial batch
+    reclaimer.retire(new Parent(10, 1));
+    reclaimer.drain();
+    EXPECT_EQ(Counted::alive, 0);
+    // Several batches' worth per level, three levels deep
+    for (int i = 0; i < 3; ++i) reclaimer.retire(new Parent(12, 2));
+    reclaimer.drain();
+    EXPECT_EQ(Counted::alive, 0);
+    g_target = nullptr;
+}
+
+TEST(DeferredDeleteTest, DestructorDestroysObjectsDeferredByDeleters) {
+    {
+        // Backpressure from the start, so batches are also destroyed inline
+        DeferredReclaimer reclaimer(1);
+        g_target = &reclaimer;
+        for (int i = 0; i < 20; ++i) reclaimer.retire(new Parent(5, 2));
+    }
+    EXPECT_EQ(Counted::alive, 0);
+    g_target = nullptr;
+}
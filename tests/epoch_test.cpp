@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "memory/epoch.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+    using Node = test::Tracked<struct EpochTag>;
+
+    // Each link's deleter retires the next link into the same domain
+    epoch_domain* g_chainDomain = nullptr;
+
+    struct Link {
+        Node node;
+        Link* next;
+        Link(long v, Link* n) : node(v), next(n) {}
+    };
+
+    struct RetireNext {
+        void operator()(Link* link) const {
+            if (link->next) g_chainDomain->retire<Link, RetireNext>(link->next);
+            delete link;
+        }
+    };
+}
+
+TEST(EpochTest, RetiredNodesFreedAfterTwoEpochs) {
+    {
+        epoch_domain domain;
+        domain.retire(new Node(1));
+        EXPECT_EQ(domain.pending(), 1u);
+        domain.reclaim();
+        domain.reclaim();
+        EXPECT_EQ(Node::alive, 0);
+        EXPECT_EQ(domain.pending(), 0u);
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(EpochTest, PinnedReaderHoldsBackReclamation) {
+    epoch_domain domain;
+    std::atomic<Node*> head{new Node(1)};
+    std::atomic<bool> pinned{false};
+    std::atomic<bool> release{false};
+    std::thread reader([&]() {
+        epoch_guard guard = domain.pin();
+        Node* node = head.load();
+        pinned = true;
+        while (!release) std::this_thread::yield();
+        EXPECT_EQ(node->value, 1);
+    });
+    while (!pinned) std::this_thread::yield();
+    domain.retire(head.exchange(new Node(2)));
+    for (int i = 0; i < 5; ++i) domain.reclaim();
+    EXPECT_EQ(Node::alive, 2);
+    release = true;
+    reader.join();
+    for (int i = 0; i < 3; ++i) domain.reclaim();
+    EXPECT_EQ(Node::alive, 1);
+    delete head.load();
+}
+
+TEST(EpochTest, NestedGuards) {
+    epoch_domain domain;
+    {
+        epoch_guard outer = domain.pin();
+        {
+            epoch_guard inner = domain.pin();
+        }
+        // Still pinned: the epoch can move one step, not two
+        domain.retire(new Node(3));
+        for (int i = 0; i < 5; ++i) domain.reclaim();
+        EXPECT_EQ(Node::alive, 1);
+    }
+    for (int i = 0; i < 3; ++i) domain.reclaim();
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(EpochTest, ConcurrentReadersAndWriters) {
+    {
+        epoch_domain domain;
+        std::atomic<Node*> head{new Node(0)};
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        for (int r = 0; r < 3; ++r) {
+            threads.emplace_back([&]() {
+                long last = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    epoch_guard guard = domain.pin();
+                    Node* node = head.load(std::memory_order_acquire);
+                    EXPECT_GE(node->value, last);
+                    last = node->value;
+                }
+            });
+        }
+        for (int w = 0; w < 2; ++w) {
+            threads.emplace_back([&]() {
+                for (long i = 1; i <= 5000; ++i) {
+                    epoch_guard guard = domain.pin();
+                    Node* fresh = new Node(0);
+                    Node* old = head.load();
+                    do {
+                        fresh->value = old->value + 1;
+                    } while (!head.compare_exchange_weak(old, fresh));
+                    domain.retire(old);
+                }
+            });
+        }
+        for (size_t i = 3; i < threads.size(); ++i) threads[i].join();
+        done = true;
+        for (size_t i = 0; i < 3; ++i) threads[i].join();
+        EXPECT_EQ(head.load()->value, 10000);
+        delete head.load();
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(EpochTest, DeletersMayRetireIntoTheSameDomain) {
+    {
+        epoch_domain domain;
+        g_chainDomain = &domain;
+        for (int i = 0; i < 500; ++i) {
+            Link* chain = nullptr;
+            for (int depth = 0; depth < 4; ++depth) chain = new Link(depth, chain);
+            domain.retire<Link, RetireNext>(chain);
+        }
+        for (int i = 0; i < 8; ++i) {
+            domain.reclaim();
+            domain.reclaim();
+            domain.reclaim();
+        }
+        EXPECT_EQ(Node::alive, 0);
+        // What the last deleters retired is freed by the destructor
+        for (int i = 0; i < 10; ++i) domain.retire<Link, RetireNext>(new Link(0, new Link(1, new Link(2, nullptr))));
+    }
+    g_chainDomain = nullptr;
+    EXPECT_EQ(Node::alive, 0);
+}
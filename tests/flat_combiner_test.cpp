@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include "multithreading/flat_combiner.h"
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+TEST(FlatCombinerTest, ReturnsResultOfOperation) {
+    FlatCombiner<int> combiner(40);
+    EXPECT_EQ(combiner.apply([](int& v) { return v += 2; }), 42);
+    combiner.apply([](int& v) { v = 7; });
+    EXPECT_EQ(combiner.unsafe_state(), 7);
+}
+
+TEST(FlatCombinerTest, ConcurrentOperationsAreSerialized) {
+    FlatCombiner<std::map<int, long long>> combiner;
+    const int numThreads = 4;
+    const int iterations = 5000;
+    std::vector<std::thread> threads;
+    std::vector<long long> lastSeen(numThreads, 0);
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < iterations; ++j) {
+                long long value = combiner.apply([i](std::map<int, long long>& counters) { return ++counters[i % 2]; });
+                if (value <= lastSeen[i]) lastSeen[i] = -1;
+                else if (lastSeen[i] >= 0) lastSeen[i] = value;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    auto& counters = combiner.unsafe_state();
+    EXPECT_EQ(counters[0] + counters[1], numThreads * iterations);
+    for (long long v : lastSeen) EXPECT_GT(v, 0); // values a thread sees only increase
+}
+
+TEST(FlatCombinerTest, ExceptionIsRethrownInRequester) {
+    FlatCombiner<int> combiner(0);
+    EXPECT_THROW(combiner.apply([](int&) -> int { throw std::runtime_error("boom"); }), std::runtime_error);
+    EXPECT_EQ(combiner.apply([](int& v) { return ++v; }), 1);
+}
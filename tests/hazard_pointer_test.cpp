@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "memory/hazard_pointer.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+    using Node = test::Tracked<struct HazardPointerTag>;
+
+    // Each link's deleter retires the next link into the same domain
+    hazard_pointer_domain* g_chainDomain = nullptr;
+
+    struct Link {
+        Node node;
+        Link* next;
+        Link(long v, Link* n) : node(v), next(n) {}
+    };
+
+    struct RetireNext {
+        void operator()(Link* link) const {
+            if (link->next) g_chainDomain->retire<Link, RetireNext>(link->next);
+            delete link;
+        }
+    };
+}
+
+TEST(HazardPointerTest, ProtectedNodeSurvivesScan) {
+    {
+        hazard_pointer_domain domain;
+        std::atomic<Node*> head{new Node(1)};
+        hazard_pointer hp = domain.make_hazard_pointer();
+        Node* seen = hp.protect(head);
+        EXPECT_EQ(seen->value, 1);
+
+        Node* old = head.exchange(new Node(2));
+        domain.retire(old);
+        domain.reclaim();
+        EXPECT_EQ(Node::alive, 2);
+        EXPECT_EQ(seen->value, 1);
+
+        hp.reset_protection();
+        domain.reclaim();
+        EXPECT_EQ(Node::alive, 1);
+        EXPECT_EQ(domain.pending(), 0u);
+        delete head.load();
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(HazardPointerTest, RetireListStaysBounded) {
+    hazard_pointer_domain domain;
+    size_t maxPending = 0;
+    for (int i = 0; i < 10000; ++i) {
+        domain.retire(new Node(i));
+        maxPending = std::max(maxPending, domain.pending());
+    }
+    EXPECT_LE(maxPending, 2 * (ThreadSlot::high_water() * hazard_pointer_domain::HAZARDS_PER_THREAD + hazard_pointer_domain::SHARED_HAZARDS));
+    domain.reclaim();
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(HazardPointerTest, MoreHandlesThanPerThreadSlots) {
+    hazard_pointer_domain domain;
+    std::vector<hazard_pointer> handles;
+    for (size_t i = 0; i < hazard_pointer_domain::HAZARDS_PER_THREAD + 3; ++i) {
+        handles.push_back(domain.make_hazard_pointer());
+        EXPECT_FALSE(handles.back().empty());
+    }
+    std::atomic<Node*> head{new Node(5)};
+    for (hazard_pointer& hp : handles) EXPECT_EQ(hp.protect(head)->value, 5);
+    domain.retire(head.exchange(nullptr));
+    domain.reclaim();
+    EXPECT_EQ(Node::alive, 1);
+    handles.clear();
+    domain.reclaim();
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(HazardPointerTest, ConcurrentReadersAndWriters) {
+    {
+        hazard_pointer_domain domain;
+        std::atomic<Node*> head{new Node(0)};
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        for (int r = 0; r < 3; ++r) {
+            threads.emplace_back([&]() {
+                hazard_pointer hp = domain.make_hazard_pointer();
+                long last = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    Node* node = hp.protect(head);
+                    EXPECT_GE(node->value, last);
+                    last = node->value;
+                    hp.reset_protection();
+                }
+            });
+        }
+        for (int w = 0; w < 2; ++w) {
+            threads.emplace_back([&]() {
+                // The other writer may retire the node this one is reading, so writers protect too
+                hazard_pointer hp = domain.make_hazard_pointer();
+                for (long i = 1; i <= 5000; ++i) {
+                    Node* fresh = new Node(0);
+                    Node* old = hp.protect(head);
+                    fresh->value = old->value + 1;
+                    while (!head.compare_exchange_weak(old, fresh)) {
+                        old = hp.protect(head);
+                        fresh->value = old->value + 1;
+                    }
+                    hp.reset_protection();
+                    domain.retire(old);
+                }
+            });
+        }
+        for (size_t i = 3; i < threads.size(); ++i) threads[i].join();
+        done = true;
+        for (size_t i = 0; i < 3; ++i) threads[i].join();
+        EXPECT_EQ(head.load()->value, 10000);
+        delete head.load();
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(HazardPointerTest, DeletersMayRetireIntoTheSameDomain) {
+    {
+        hazard_pointer_domain domain;
+        g_chainDomain = &domain;
+        for (int i = 0; i < 500; ++i) {
+            Link* chain = nullptr;
+            for (int depth = 0; depth < 4; ++depth) chain = new Link(depth, chain);
+            domain.retire<Link, RetireNext>(chain);
+        }
+        for (int i = 0; i < 8; ++i) {
+            domain.reclaim();
+        }
+        EXPECT_EQ(Node::alive, 0);
+        // What the last deleters retired is freed by the destructor
+        for (int i = 0; i < 10; ++i) domain.retire<Link, RetireNext>(new Link(0, new Link(1, new Link(2, nullptr))));
+    }
+    g_chainDomain = nullptr;
+    EXPECT_EQ(Node::alive, 0);
+}
@@ -0,0 +1,101 @@
+#include "containers/inplace_vector.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+using Tracked = test::Tracked<struct InplaceVectorTag>;
+}
+
+static_assert(std::is_trivially_copyable_v<inplace_vector<int, 4>>);
+static_assert(std::is_trivially_destructible_v<inplace_vector<int, 4>>);
+static_assert(!std::is_trivially_copyable_v<inplace_vector<std::string, 4>>);
+static_assert(sizeof(inplace_vector<char, 7>) == 8);
+
+TEST(InplaceVectorTest, PushAndAccess) {
+    inplace_vector<int, 4> v;
+    EXPECT_TRUE(v.empty());
+    v.push_back(1);
+    v.emplace_back(2);
+    v.push_back(3);
+    EXPECT_EQ(v.size(), 3u);
+    EXPECT_EQ(v.front(), 1);
+    EXPECT_EQ(v.back(), 3);
+    EXPECT_EQ(v[1], 2);
+    EXPECT_EQ(v.at(2), 3);
+    EXPECT_THROW(v.at(3), std::out_of_range);
+    v.pop_back();
+    EXPECT_EQ(v.size(), 2u);
+}
+
+TEST(InplaceVectorTest, FullBehaviour) {
+    inplace_vector<std::string, 2> v{"a", "b"};
+    EXPECT_TRUE(v.full());
+    EXPECT_THROW(v.push_back("c"), std::bad_alloc);
+
+    std::string value = "kept";
+    EXPECT_EQ(v.try_push_back(std::move(value)), nullptr);
+    EXPECT_EQ(value, "kept");
+
+    v.pop_back();
+    std::string* pushed = v.try_push_back(std::move(value));
+    ASSERT_NE(pushed, nullptr);
+    EXPECT_EQ(*pushed, "kept");
+
+    EXPECT_THROW((inplace_vector<int, 2>{1, 2, 3}), std::bad_alloc);
+}
+
+TEST(InplaceVectorTest, InsertAndErase) {
+    inplace_vector<std::string, 8> v{"a", "c", "e"};
+    v.insert(v.begin() + 1, "b");
+    v.insert(v.begin() + 3, "d");
+    v.insert(v.end(), "f");
+    EXPECT_EQ(v, (inplace_vector<std::string, 8>{"a", "b", "c", "d", "e", "f"}));
+
+    v.erase(v.begin());
+    v.erase(v.begin() + 1, v.begin() + 3);
+    EXPECT_EQ(v, (inplace_vector<std::string, 8>{"b", "e", "f"}));
+
+    // Inserting a copy of one of its own elements
+    v.insert(v.begin(), v[2]);
+    EXPECT_EQ(v, (inplace_vector<std::string, 8>{"f", "b", "e", "f"}));
+}
+
+TEST(InplaceVectorTest, ResizeAndLifetimes) {
+    {
+        inplace_vector<Tracked, 4> v(3, Tracked(7));
+        EXPECT_EQ(Tracked::alive, 3);
+        v.resize(1, Tracked(0));
+        EXPECT_EQ(Tracked::alive, 1);
+        v.insert(v.begin(), Tracked(1));
+        v.erase(v.begin() + 1);
+        EXPECT_EQ(Tracked::alive, 1);
+        EXPECT_EQ(v[0].value, 1);
+
+        inplace_vector<Tracked, 4> copy = v;
+        inplace_vector<Tracked, 4> moved = std::move(copy);
+        EXPECT_EQ(moved[0].value, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(InplaceVectorTest, CopyMoveSwap) {
+    inplace_vector<int, 4> a{1, 2};
+    inplace_vector<int, 4> b{3};
+    inplace_vector<int, 4> c = a;
+    EXPECT_EQ(c, a);
+    a.swap(b);
+    EXPECT_EQ(a, (inplace_vector<int, 4>{3}));
+    EXPECT_EQ(b, (inplace_vector<int, 4>{1, 2}));
+
+    inplace_vector<std::unique_ptr<int>, 2> owners;
+    owners.push_back(std::make_unique<int>(5));
+    inplace_vector<std::unique_ptr<int>, 2> taken = std::move(owners);
+    EXPECT_EQ(*taken[0], 5);
+}
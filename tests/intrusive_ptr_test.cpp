@@ -0,0 +1,81 @@
+#include "memory/intrusive_ptr.h"
+#include "multithreading/spsc/spscbounded.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+struct Message : intrusive_ref_counter<Message>, test::Tracked<Message> {
+    explicit Message(int i) : Tracked(i) {}
+    virtual ~Message() = default;
+};
+
+struct Derived : Message {
+    explicit Derived(int i) : Message(i) {}
+};
+
+struct LocalNode : intrusive_ref_counter<LocalNode, ThreadUnsafeRefCount> {
+    intrusive_ptr<LocalNode> next;
+};
+}
+
+TEST(IntrusivePtrTest, CountsLiveInTheObject) {
+    static_assert(sizeof(intrusive_ptr<Message>) == sizeof(Message*));
+    {
+        auto p = make_intrusive<Message>(1);
+        EXPECT_EQ(p->use_count(), 1u);
+        intrusive_ptr<Message> q = p;
+        EXPECT_EQ(p->use_count(), 2u);
+        intrusive_ptr<Message> r = intrusive_ptr<Message>::retain(p.get());
+        EXPECT_EQ(p->use_count(), 3u);
+        intrusive_ptr<Message> base = make_intrusive<Derived>(2);
+        EXPECT_EQ(base->value, 2);
+        Message copy(*p); // copies do not inherit references
+        EXPECT_EQ(copy.use_count(), 0u);
+    }
+    EXPECT_EQ(Message::alive, 0);
+}
+
+TEST(IntrusivePtrTest, DetachAndAdopt) {
+    auto p = make_intrusive<Message>(3);
+    Message* raw = p.detach();
+    EXPECT_FALSE(p);
+    EXPECT_EQ(raw->use_count(), 1u);
+    auto back = intrusive_ptr<Message>::adopt(raw);
+    EXPECT_EQ(back->use_count(), 1u);
+    back.reset();
+    EXPECT_EQ(Message::alive, 0);
+}
+
+TEST(IntrusivePtrTest, ThreadUnsafePolicy) {
+    auto head = make_intrusive<LocalNode>();
+    head->next = make_intrusive<LocalNode>();
+    intrusive_ptr<LocalNode> second = head->next;
+    EXPECT_EQ(second->use_count(), 2u);
+    head.reset();
+    EXPECT_EQ(second->use_count(), 1u);
+}
+
+TEST(IntrusivePtrTest, PassesThroughSpscQueueAsRawPointer) {
+    SpscBounded<Message*, 64> queue;
+    const int count = 1000;
+    std::thread consumer([&]() {
+        for (int i = 0; i < count; ++i) {
+            Message* raw;
+            while (!queue.try_pop(raw)) std::this_thread::yield();
+            auto msg = intrusive_ptr<Message>::adopt(raw);
+            EXPECT_EQ(msg->value, i);
+        }
+    });
+    for (int i = 0; i < count; ++i) {
+        auto msg = make_intrusive<Message>(i);
+        Message* raw = msg.detach();
+        while (!queue.try_push(raw)) std::this_thread::yield();
+    }
+    consumer.join();
+    EXPECT_EQ(Message::alive, 0);
+}
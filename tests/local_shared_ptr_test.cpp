@@ -0,0 +1,50 @@
+#include "memory/local_shared_ptr.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+struct Node : test::Tracked<Node> {
+    local_shared_ptr<Node> next;
+    explicit Node(int v) : Tracked(v) {}
+};
+}
+
+TEST(LocalSharedPtrTest, CopiesShareOwnership) {
+    {
+        auto head = make_local_shared<Node>(1);
+        head->next = make_local_shared<Node>(2);
+        local_shared_ptr<Node> second = head->next;
+        EXPECT_EQ(second.use_count(), 2);
+        std::vector<local_shared_ptr<Node>> copies(10, head);
+        EXPECT_EQ(head.use_count(), 11);
+        copies.clear();
+        head.reset();
+        EXPECT_EQ(Node::alive, 1);
+        EXPECT_EQ(second->value, 2);
+        local_shared_ptr<long> alias(second, &second->value);
+        EXPECT_EQ(*alias, 2);
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(LocalSharedPtrTest, CustomDeleter) {
+    int deleted = 0;
+    {
+        local_shared_ptr<int> p(new int(3), [&deleted](int* q) { ++deleted; delete q; });
+        local_shared_ptr<int> q = p;
+        EXPECT_EQ(*q, 3);
+    }
+    EXPECT_EQ(deleted, 1);
+}
+
+#if SVR_LOCAL_SHARED_PTR_CHECKS
+TEST(LocalSharedPtrDeathTest, CrossThreadCopyAborts) {
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    auto p = make_local_shared<int>(1);
+    EXPECT_DEATH(std::thread([&p]() { local_shared_ptr<int> copy = p; }).join(), "other than the one that created it");
+}
+#endif
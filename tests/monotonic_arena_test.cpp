@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "memory/monotonic_arena.h"
+#include "memory/unique_ptr.h"
+#include "multithreading/spsc/rigtorp.h"
+#include "multithreading/spsc/spscbounded.h"
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+TEST(MonotonicArenaTest, BumpsAndAligns) {
+    MonotonicArena arena(256);
+    EXPECT_EQ(arena.capacity(), 0u);
+    char* a = static_cast<char*>(arena.allocate(3, 1));
+    char* b = static_cast<char*>(arena.allocate(1, 1));
+    EXPECT_EQ(b, a + 3);
+    void* wide = arena.allocate(8, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(wide) % 64, 0u);
+    void* huge = arena.allocate(10000, 256);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(huge) % 256, 0u);
+    EXPECT_GE(arena.capacity(), 10000u);
+}
+
+TEST(MonotonicArenaTest, ResetReusesBlocks) {
+    MonotonicArena arena(1024);
+    void* first = arena.allocate(16);
+    for (int i = 0; i < 1000; ++i) arena.allocate(64);
+    const size_t capacity = arena.capacity();
+    arena.reset();
+    EXPECT_EQ(arena.allocate(16), first);
+    for (int i = 0; i < 1000; ++i) arena.allocate(64);
+    EXPECT_EQ(arena.capacity(), capacity);
+    arena.release();
+    EXPECT_EQ(arena.capacity(), 0u);
+}
+
+TEST(MonotonicArenaTest, LastAllocationIsGivenBack) {
+    MonotonicArena arena;
+    void* a = arena.allocate(32);
+    arena.deallocate(a, 32);
+    EXPECT_EQ(arena.allocate(32), a);
+}
+
+TEST(MonotonicArenaTest, StlContainers) {
+    MonotonicArena arena;
+    {
+        std::vector<int, ArenaAllocator<int>> values{ArenaAllocator<int>(arena)};
+        for (int i = 0; i < 1000; ++i) values.push_back(i);
+        EXPECT_EQ(values[999], 999);
+        using Alloc = ArenaAllocator<std::pair<const int, std::string>>;
+        std::map<int, std::string, std::less<int>, Alloc> names{Alloc(arena)};
+        names[1] = "one";
+        names[2] = std::string(100, 'x');
+        EXPECT_EQ(names[1], "one");
+        EXPECT_TRUE(values.get_allocator() == names.get_allocator());
+    }
+    arena.reset();
+}
+
+TEST(MonotonicArenaTest, QueuesAndUniquePtr) {
+    struct Counted {
+        int* alive;
+        explicit Counted(int* a) : alive(a) { ++*alive; }
+        ~Counted() { --*alive; }
+    };
+    MonotonicArena arena;
+    {
+        SpscBounded<int, 64, ArenaAllocator<int>> queue{ArenaAllocator<int>(arena)};
+        SpscBoundedMutex<int, 8, ArenaAllocator<int>> locked{ArenaAllocator<int>(arena)};
+        rigtorp::SPSCQueue<int, ArenaAllocator<int>> ring(16, ArenaAllocator<int>(arena));
+        std::thread producer([&]() {
+            for (int i = 0; i < 1000; ++i) while (!queue.try_push(i)) {}
+        });
+        int value = -1;
+        for (int i = 0; i < 1000; ++i) {
+            while (!queue.try_pop(value)) {}
+            EXPECT_EQ(value, i);
+        }
+        producer.join();
+        EXPECT_TRUE(locked.try_push(5));
+        EXPECT_TRUE(locked.try_pop(value));
+        EXPECT_EQ(value, 5);
+        ring.push(7);
+        EXPECT_EQ(*ring.front(), 7);
+        ring.pop();
+    }
+    int alive = 0;
+    {
+        svr::unique_ptr<Counted, ArenaDeleter<Counted>> p(arena.create<Counted>(&alive), ArenaDeleter<Counted>());
+        EXPECT_EQ(alive, 1);
+    }
+    EXPECT_EQ(alive, 0);
+    arena.reset();
+}
@@ -0,0 +1,86 @@
+#include "memory/object_pool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+using PoolDummy = test::Tracked<struct ObjectPoolTag>;
+}
+
+TEST(ObjectPoolTest, AcquireConstructsReleaseDestroys) {
+    ObjectPool<PoolDummy> pool(4);
+    PoolDummy* p = pool.acquire(7);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(p->value, 7);
+    EXPECT_EQ(PoolDummy::alive.load(), 1);
+    pool.release(p);
+    EXPECT_EQ(PoolDummy::alive.load(), 0);
+}
+
+TEST(ObjectPoolTest, ObjectsAreCacheLineAligned) {
+    ObjectPool<int> pool(8);
+    int* a = pool.acquire(1);
+    int* b = pool.acquire(2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0u);
+    pool.release(a);
+    pool.release(b);
+}
+
+TEST(ObjectPoolTest, ExhaustionReturnsNull) {
+    ObjectPool<int> pool(3);
+    std::vector<int*> taken;
+    for (int i = 0; i < 3; ++i) {
+        taken.push_back(pool.acquire(i));
+        ASSERT_NE(taken.back(), nullptr);
+    }
+    EXPECT_EQ(pool.acquire(99), nullptr);
+    std::set<int*> unique(taken.begin(), taken.end());
+    EXPECT_EQ(unique.size(), 3u);
+    pool.release(taken.back());
+    EXPECT_NE(pool.acquire(5), nullptr);
+}
+
+TEST(ObjectPoolTest, UniquePtrReturnsToPool) {
+    ObjectPool<PoolDummy> pool(1);
+    {
+        auto p = pool.make_unique(42);
+        ASSERT_TRUE(p);
+        EXPECT_EQ(p->value, 42);
+        EXPECT_FALSE(pool.make_unique(1));
+    }
+    EXPECT_EQ(PoolDummy::alive.load(), 0);
+    EXPECT_TRUE(pool.make_unique(3));
+}
+
+TEST(ObjectPoolTest, MultiThreadedChurn) {
+    constexpr int numThreads = 8;
+    constexpr int iterations = 20000;
+    // Slack for objects parked in per-thread magazines
+    ObjectPool<PoolDummy> pool(numThreads * 64);
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            PoolDummy* held[4];
+            for (int i = 0; i < iterations; ++i) {
+                for (auto& h : held) {
+                    h = pool.acquire(t);
+                    if (!h) { ++failures; return; }
+                }
+                for (auto& h : held) {
+                    if (h->value != t) ++failures;
+                    pool.release(h);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(PoolDummy::alive.load(), 0);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "memory/pool_allocator.h"
+#include <list>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+TEST(PoolAllocatorTest, BlocksAreDistinctAndReused) {
+    using Pool = FixedSizePool<24, 8>;
+    EXPECT_EQ(Pool::BLOCK_SIZE, 24u);
+    std::set<void*> seen;
+    std::vector<void*> blocks;
+    for (int i = 0; i < 300; ++i) {
+        void* p = Pool::allocate();
+        EXPECT_TRUE(seen.insert(p).second);
+        blocks.push_back(p);
+    }
+    for (void* p : blocks) Pool::deallocate(p);
+    // Recently freed blocks come back first
+    void* again = Pool::allocate();
+    EXPECT_TRUE(seen.count(again));
+    Pool::deallocate(again);
+}
+
+TEST(PoolAllocatorTest, RespectsAlignment) {
+    struct alignas(64) Wide { char c[80]; };
+    PoolAllocator<Wide> alloc;
+    Wide* a = alloc.allocate(1);
+    Wide* b = alloc.allocate(1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0u);
+    alloc.deallocate(a, 1);
+    alloc.deallocate(b, 1);
+    Wide* arr = alloc.allocate(3);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(arr) % 64, 0u);
+    alloc.deallocate(arr, 3);
+}
+
+TEST(PoolAllocatorTest, WorksAsStlAllocatorAcrossThreads) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t]() {
+            std::list<int, PoolAllocator<int>> values;
+            for (int i = 0; i < 5000; ++i) values.push_back(i + t);
+            long long sum = 0;
+            for (int v : values) sum += v;
+            EXPECT_EQ(sum, 5000LL * 4999 / 2 + 5000LL * t);
+        });
+    }
+    for (auto& t : threads) t.join();
+}
+
+TEST(PoolAllocatorTest, FreedOnAnotherThread) {
+    using Pool = FixedSizePool<40, 8>;
+    std::vector<void*> blocks;
+    std::thread producer([&]() {
+        for (int i = 0; i < 1000; ++i) blocks.push_back(Pool::allocate());
+    });
+    producer.join();
+    std::thread consumer([&]() {
+        for (void* p : blocks) Pool::deallocate(p);
+    });
+    consumer.join();
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "multithreading/profiled_lock.h"
+#include "multithreading/spinlock/spinlock.h"
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+namespace {
+    const LockSiteStats* findSite(const std::vector<LockSiteStats>& sites, uint32_t line) {
+        for (const auto& s : sites) {
+            if (s.line == line && std::strstr(s.file, "profiled_lock_test.cpp")) return &s;
+        }
+        return nullptr;
+    }
+
+    template<typename L, bool PROBE>
+    concept Profilable = requires { typename ProfiledLock<L, PROBE>; };
+}
+
+// Probing needs try_lock(), which CLHSpinLock does not have
+static_assert(Profilable<CLHSpinLock, false>);
+static_assert(!Profilable<CLHSpinLock, true>);
+
+TEST(ProfiledLockTest, AttributesAcquisitionsToCallSites) {
+    ProfiledLock<SpinLock<PauseBackoff>> lock;
+    const uint32_t firstLine = __LINE__ + 3;
+    std::thread t([&]() {
+        for (int i = 0; i < 100; ++i) {
+            lock.lock();
+            lock.unlock();
+        }
+    });
+    t.join();
+    const uint32_t secondLine = __LINE__ + 2;
+    for (int i = 0; i < 10; ++i) {
+        ProfiledLockGuard guard(lock);
+    }
+    auto sites = LockProfiler::report(1000);
+    const LockSiteStats* first = findSite(sites, firstLine);
+    const LockSiteStats* second = findSite(sites, secondLine);
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(first->acquisitions, 100u);
+    EXPECT_EQ(second->acquisitions, 10u);
+    EXPECT_GE(first->holdNs, 0.0);
+}
+
+TEST(ProfiledLockTest, WrapsStdMutexAndCountsContention) {
+    ProfiledLock<std::mutex> lock;
+    long long counter = 0;
+    const int numThreads = 4;
+    const int iterations = 2000;
+    const uint32_t line = __LINE__ + 5;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < iterations; ++j) {
+                ProfiledLockGuard guard(lock);
+                ++counter;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(counter, numThreads * iterations);
+    auto sites = LockProfiler::report(1000);
+    const LockSiteStats* site = findSite(sites, line);
+    ASSERT_NE(site, nullptr);
+    EXPECT_EQ(site->acquisitions, static_cast<uint64_t>(numThreads * iterations));
+    EXPECT_LE(site->contended, site->acquisitions);
+}
+
+TEST(ProfiledLockTest, SpinsAreReportedOnlyWhenProbing) {
+    ProfiledLock<TicketSpinLock> direct;
+    ProfiledLock<TicketSpinLock, true> probing;
+    const int numThreads = 4;
+    const int iterations = 2000;
+    const uint32_t directLine = __LINE__ + 7;
+    const uint32_t probingLine = __LINE__ + 9;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < iterations; ++j) {
+                {
+                    ProfiledLockGuard guard(direct);
+                }
+                {
+                    ProfiledLockGuard guard(probing);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    auto sites = LockProfiler::report(1000);
+    const LockSiteStats* directSite = findSite(sites, directLine);
+    const LockSiteStats* probingSite = findSite(sites, probingLine);
+    ASSERT_NE(directSite, nullptr);
+    ASSERT_NE(probingSite, nullptr);
+    EXPECT_EQ(directSite->acquisitions, static_cast<uint64_t>(numThreads * iterations));
+    EXPECT_EQ(directSite->spins, 0u);
+    EXPECT_EQ(probingSite->acquisitions, static_cast<uint64_t>(numThreads * iterations));
+    EXPECT_LE(probingSite->contended, probingSite->spins);
+}
+
+TEST(ProfiledLockTest, ReportIsSortedByWaitTime) {
+    auto sites = LockProfiler::report(1000);
+    for (size_t i = 1; i < sites.size(); ++i) {
+        EXPECT_GE(sites[i - 1].waitNs, sites[i].waitNs);
+    }
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include "multithreading/spinlock/rw_spinlock.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+// Writers keep two values equal; a reader must never observe them apart
+template <typename Lock>
+void ReadersSeeConsistentStateTest() {
+    Lock lock;
+    long long a = 0, b = 0;
+    std::atomic<int> torn{0};
+    const int numThreads = 4;
+    const int iterations = 5000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < iterations; ++j) {
+                if ((i + j) % 10 == 0) {
+                    std::unique_lock<Lock> lk(lock);
+                    ++a;
+                    ++b;
+                } else {
+                    std::shared_lock<Lock> lk(lock);
+                    if (a != b) ++torn;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(a, numThreads * iterations / 10);
+}
+
+template <typename Lock>
+void TryLockExclusionTest() {
+    Lock lock;
+    lock.lock_shared();
+    EXPECT_TRUE(lock.try_lock_shared());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock_shared();
+    lock.unlock_shared();
+    EXPECT_TRUE(lock.try_lock());
+    EXPECT_FALSE(lock.try_lock_shared());
+    lock.unlock();
+}
+
+TEST(RWSpinLockTest, ReadersSeeConsistentState) { ReadersSeeConsistentStateTest<RWSpinLock>(); }
+TEST(RWSpinLockTest, TryLockExclusion) { TryLockExclusionTest<RWSpinLock>(); }
+TEST(DistributedRWSpinLockTest, ReadersSeeConsistentState) { ReadersSeeConsistentStateTest<DistributedRWSpinLock<>>(); }
+TEST(DistributedRWSpinLockTest, TryLockExclusion) { TryLockExclusionTest<DistributedRWSpinLock<4>>(); }
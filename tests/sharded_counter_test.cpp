@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+#include "multithreading/sharded_counter.h"
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+TEST(ShardedCounterTest, SingleThreadAddAndLoad) {
+    ShardedCounter<> counter;
+    EXPECT_EQ(counter.load(), 0);
+    counter.increment();
+    counter.add(41);
+    counter.decrement();
+    EXPECT_EQ(counter.load(), 41);
+    EXPECT_EQ(counter.exchange_zero(), 41);
+    EXPECT_EQ(counter.load(), 0);
+    EXPECT_EQ(alignof(ShardedCounter<>), SVR_CACHELINE_SIZE);
+}
+
+TEST(ShardedCounterTest, ConcurrentIncrementsAreAllCounted) {
+    ShardedCounter<long long, 2> counter; // fewer shards than threads, so shards are shared
+    const int numThreads = 4;
+    const int iterations = 10000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < iterations; ++j) counter.increment();
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(counter.load(), numThreads * iterations);
+}
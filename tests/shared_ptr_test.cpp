@@ -0,0 +1,202 @@
+#include "memory/pool_allocator.h"
+#include "memory/shared_ptr.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+using Tracked = test::Tracked<struct SharedPtrTag>;
+
+struct alignas(64) OverAligned {
+    char c = 'x';
+};
+}
+
+TEST(SharedPtrTest, DefaultIsEmpty) {
+    shared_ptr<int> p;
+    EXPECT_EQ(p.get(), nullptr);
+    EXPECT_FALSE(p);
+    EXPECT_EQ(p.use_count(), 0);
+}
+
+TEST(SharedPtrTest, RawPointerOwnership) {
+    {
+        shared_ptr<Tracked> p(new Tracked(3));
+        shared_ptr<Tracked> q = p;
+        EXPECT_EQ(p.use_count(), 2);
+        EXPECT_EQ(q->value, 3);
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(SharedPtrTest, MakeSharedConstructsInPlace) {
+    {
+        auto p = make_shared<Tracked>(42);
+        EXPECT_EQ(p->value, 42);
+        EXPECT_EQ((*p).value, 42);
+        EXPECT_EQ(p.use_count(), 1);
+        shared_ptr<Tracked> q;
+        q = p;
+        shared_ptr<Tracked> r = std::move(q);
+        EXPECT_FALSE(q);
+        EXPECT_EQ(r.get(), p.get());
+        EXPECT_EQ(p.use_count(), 2);
+        r.reset();
+        EXPECT_EQ(p.use_count(), 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+    auto s = make_shared<std::string>(3, 'a');
+    EXPECT_EQ(*s, "aaa");
+    auto a = make_shared<OverAligned>();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a.get()) % alignof(OverAligned), 0u);
+}
+
+TEST(SharedPtrTest, SelfAssignmentThroughLastOwner) {
+    auto p = make_shared<Tracked>(1);
+    shared_ptr<Tracked>& alias = p;
+    p = alias;
+    EXPECT_EQ(p.use_count(), 1);
+    EXPECT_EQ(p->value, 1);
+}
+
+TEST(SharedPtrTest, ConcurrentCopiesReleaseOnce) {
+    {
+        auto p = make_shared<Tracked>(7);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([p]() {
+                for (int j = 0; j < 10000; ++j) {
+                    shared_ptr<Tracked> copy = p;
+                    EXPECT_EQ(copy->value, 7);
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        EXPECT_EQ(p.use_count(), 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+namespace {
+struct Base {
+    virtual ~Base() = default;
+    int base = 1;
+};
+
+struct Derived : Base {
+    static inline int destroyed = 0;
+    int member = 2;
+    ~Derived() override { ++destroyed; }
+};
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+    int* allocations;
+    explicit CountingAllocator(int* a) : allocations(a) {}
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : allocations(other.allocations) {}
+    T* allocate(size_t n) { ++*allocations; return static_cast<T*>(::operator new(n * sizeof(T))); }
+    void deallocate(T* p, size_t) { --*allocations; ::operator delete(p); }
+};
+}
+
+TEST(SharedPtrTest, CustomDeleterAndAllocator) {
+    int deleted = 0;
+    int allocations = 0;
+    {
+        int storage = 5;
+        shared_ptr<int> p(&storage, [&deleted](int*) { ++deleted; }, CountingAllocator<int>(&allocations));
+        EXPECT_EQ(allocations, 1);
+        shared_ptr<int> q = p;
+        EXPECT_EQ(*q, 5);
+    }
+    EXPECT_EQ(deleted, 1);
+    EXPECT_EQ(allocations, 0);
+}
+
+TEST(SharedPtrTest, ConversionAndAliasing) {
+    Derived::destroyed = 0;
+    {
+        shared_ptr<Base> base;
+        shared_ptr<int> member;
+        {
+            auto derived = make_shared<Derived>();
+            base = derived;
+            member = shared_ptr<int>(derived, &derived->member);
+            EXPECT_EQ(derived.use_count(), 3);
+        }
+        EXPECT_EQ(base->base, 1);
+        EXPECT_EQ(*member, 2);
+        EXPECT_TRUE(member.owner_equal(base));
+        base.reset();
+        EXPECT_EQ(Derived::destroyed, 0); // the alias keeps the whole object alive
+    }
+    EXPECT_EQ(Derived::destroyed, 1);
+}
+
+TEST(WeakPtrTest, LockAndExpire) {
+    weak_ptr<Tracked> weak;
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(weak.lock());
+    {
+        auto p = make_shared<Tracked>(9);
+        weak = p;
+        EXPECT_EQ(weak.use_count(), 1);
+        auto locked = weak.lock();
+        ASSERT_TRUE(locked);
+        EXPECT_EQ(locked->value, 9);
+        EXPECT_EQ(p.use_count(), 2);
+    }
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(weak.lock());
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(WeakPtrTest, ConcurrentLockWhileOwnerDrops) {
+    for (int round = 0; round < 50; ++round) {
+        auto p = make_shared<Tracked>(round);
+        weak_ptr<Tracked> weak(p);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 3; ++i) {
+            threads.emplace_back([weak, round]() {
+                for (int j = 0; j < 200; ++j) {
+                    if (auto locked = weak.lock()) {
+                        EXPECT_EQ(locked->value, round);
+                    }
+                }
+            });
+        }
+        p.reset();
+        for (auto& t : threads) t.join();
+        EXPECT_TRUE(weak.expired());
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(SharedPtrTest, AllocateSharedUsesOneAllocationFromAllocator) {
+    int allocations = 0;
+    {
+        auto p = allocate_shared<Tracked>(CountingAllocator<Tracked>(&allocations), 11);
+        EXPECT_EQ(allocations, 1);
+        EXPECT_EQ(p->value, 11);
+        weak_ptr<Tracked> weak = p;
+        p.reset();
+        EXPECT_EQ(Tracked::alive, 0);
+        EXPECT_EQ(allocations, 1); // the weak_ptr keeps the block
+    }
+    EXPECT_EQ(allocations, 0);
+}
+
+TEST(SharedPtrTest, AllocateSharedWithPoolAllocator) {
+    std::vector<shared_ptr<Tracked>> objects;
+    for (int i = 0; i < 200; ++i) objects.push_back(allocate_shared<Tracked>(PoolAllocator<Tracked>(), i));
+    for (int i = 0; i < 200; ++i) EXPECT_EQ(objects[i]->value, i);
+    objects.clear();
+    EXPECT_EQ(Tracked::alive, 0);
+}
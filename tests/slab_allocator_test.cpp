@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "memory/slab_allocator.h"
+#include "multithreading/spsc/spscbounded.h"
+#include <cstring>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+#include "test_helpers.h"
+
+using namespace svr;
+
+TEST(SlabAllocatorTest, SizeClasses) {
+    EXPECT_EQ(SlabHeap::block_size(0), 16u);
+    EXPECT_EQ(SlabHeap::block_size(1), 16u);
+    EXPECT_EQ(SlabHeap::block_size(16), 16u);
+    EXPECT_EQ(SlabHeap::block_size(17), 32u);
+    EXPECT_EQ(SlabHeap::block_size(129), 160u);
+    EXPECT_EQ(SlabHeap::block_size(1000), 1024u);
+    EXPECT_EQ(SlabHeap::block_size(SlabHeap::MAX_SIZE), SlabHeap::MAX_SIZE);
+    EXPECT_EQ(SlabHeap::block_size(SlabHeap::MAX_SIZE + 1), SlabHeap::MAX_SIZE + 1);
+    for (size_t bytes = 1; bytes <= SlabHeap::MAX_SIZE; ++bytes) {
+        ASSERT_GE(SlabHeap::block_size(bytes), bytes);
+    }
+}
+
+TEST(SlabAllocatorTest, BlocksDoNotOverlap) {
+    std::vector<std::pair<char*, size_t>> blocks;
+    for (size_t i = 0; i < 2000; ++i) {
+        size_t bytes = 1 + (i * 37) % 600;
+        char* p = static_cast<char*>(SlabHeap::allocate(bytes));
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % SlabHeap::ALIGNMENT, 0u);
+        std::memset(p, static_cast<int>(i & 0xff), bytes);
+        blocks.emplace_back(p, bytes);
+    }
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        auto [p, bytes] = blocks[i];
+        for (size_t b = 0; b < bytes; ++b) ASSERT_EQ(static_cast<unsigned char>(p[b]), i & 0xff);
+        SlabHeap::deallocate(p, bytes);
+    }
+    void* big = SlabHeap::allocate(100000);
+    SlabHeap::deallocate(big, 100000);
+}
+
+TEST(SlabAllocatorTest, ProducerAllocatesConsumerFrees) {
+    struct Message {
+        long id;
+        char body[40];
+    };
+    SpscBounded<Message*, 256> queue;
+    constexpr long COUNT = 20000;
+    std::thread producer([&]() {
+        for (long i = 0; i < COUNT; ++i) {
+            Message* m = SlabAllocator<Message>().allocate(1);
+            m->id = i;
+            while (!queue.try_push(m)) {}
+        }
+    });
+    std::thread consumer([&]() {
+        Message* m = nullptr;
+        for (long i = 0; i < COUNT; ++i) {
+            while (!queue.try_pop(m)) {}
+            EXPECT_EQ(m->id, i);
+            SlabAllocator<Message>().deallocate(m, 1);
+        }
+    });
+    producer.join();
+    consumer.join();
+}
+
+TEST(SlabAllocatorTest, SaturatedDepotHandsEveryBatchBack) {
+    // Blocks of a class no other test uses, more batches than the depot has entries. The
+    // consumer keeps one full batch, every other one must reach the producer again
+    constexpr size_t BYTES = 3584;
+    constexpr size_t COUNT = (SlabHeap::DEPOT_SLOTS + 8) * SlabHeap::BATCH;
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < COUNT; ++i) blocks.push_back(SlabHeap::allocate(BYTES));
+    std::set<void*> freed(blocks.begin(), blocks.end());
+    ASSERT_EQ(freed.size(), COUNT);
+    std::thread consumer([&]() {
+        for (void* p : blocks) SlabHeap::deallocate(p, BYTES);
+    });
+    consumer.join();
+    blocks.clear();
+    for (size_t i = 0; i < COUNT - SlabHeap::BATCH; ++i) {
+        void* p = SlabHeap::allocate(BYTES);
+        EXPECT_EQ(freed.count(p), 1u) << "block " << i << " is not one the consumer freed";
+        blocks.push_back(p);
+    }
+    for (void* p : blocks) SlabHeap::deallocate(p, BYTES);
+}
+
+TEST(SlabAllocatorTest, ContainersAndUniquePtr) {
+    std::map<int, int, std::less<int>, SlabAllocator<std::pair<const int, int>>> squares;
+    for (int i = 0; i < 1000; ++i) squares[i] = i * i;
+    EXPECT_EQ(squares[31], 961);
+    std::vector<double, SlabAllocator<double>> values(700, 1.5);
+    EXPECT_EQ(values.back(), 1.5);
+
+    using Tracked = test::Tracked<struct SlabAllocatorTag>;
+    {
+        auto p = make_slab_unique<Tracked>(5);
+        EXPECT_EQ(p->value, 5);
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
@@ -0,0 +1,118 @@
+#include "containers/small_vector.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "allocation_test_helpers.h"
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+using Tracked = test::Tracked<struct SmallVectorTag>;
+
+// Owns a pointer and nothing points into it, so it may be moved with memcpy
+struct Relocatable {
+    std::unique_ptr<int> d_value;
+};
+}
+
+template<>
+struct svr::is_trivially_relocatable<Relocatable> : svr::true_type {};
+
+TEST(SmallVectorTest, StaysInlineUpToN) {
+    small_vector<int, 4> v;
+    EXPECT_TRUE(v.is_inline());
+    EXPECT_EQ(v.capacity(), 4u);
+    {
+        test::FailTestOnAllocation fail;
+        AllocationGuard guard("inline small_vector");
+        for (int i = 0; i < 4; ++i) v.push_back(i);
+    }
+    EXPECT_TRUE(v.is_inline());
+
+    v.push_back(4);
+    EXPECT_FALSE(v.is_inline());
+    EXPECT_EQ(v.capacity(), 8u);
+    for (int i = 0; i < 5; ++i) EXPECT_EQ(v[i], i);
+    EXPECT_THROW(v.at(5), std::out_of_range);
+
+    v.clear();
+    EXPECT_FALSE(v.is_inline());
+    v.push_back(9);
+    v.shrink_to_fit();
+    EXPECT_TRUE(v.is_inline());
+    EXPECT_EQ(v.front(), 9);
+}
+
+TEST(SmallVectorTest, EmplaceBackOfOwnElementWhileGrowing) {
+    small_vector<std::string, 2> v{"first", "second"};
+    v.emplace_back(v[0]);
+    ASSERT_EQ(v.size(), 3u);
+    EXPECT_EQ(v[2], "first");
+    EXPECT_EQ(v[0], "first");
+}
+
+TEST(SmallVectorTest, InsertAndErase) {
+    small_vector<std::string, 3> v{"a", "c"};
+    v.insert(v.begin() + 1, "b");
+    v.insert(v.begin(), "0");
+    v.insert(v.end(), "d");
+    EXPECT_EQ(v, (small_vector<std::string, 3>{"0", "a", "b", "c", "d"}));
+    v.erase(v.begin());
+    v.erase(v.begin() + 1, v.begin() + 3);
+    EXPECT_EQ(v, (small_vector<std::string, 3>{"a", "d"}));
+
+    small_vector<Relocatable, 2> owners;
+    for (int i = 0; i < 5; ++i) owners.push_back(Relocatable{std::make_unique<int>(i)});
+    owners.insert(owners.begin(), Relocatable{std::make_unique<int>(-1)});
+    owners.erase(owners.begin() + 1);
+    ASSERT_EQ(owners.size(), 5u);
+    EXPECT_EQ(*owners[0].d_value, -1);
+    for (int i = 1; i < 5; ++i) EXPECT_EQ(*owners[i].d_value, i);
+}
+
+TEST(SmallVectorTest, MoveStealsHeapAndRelocatesInline) {
+    small_vector<int, 2> heap{1, 2, 3};
+    const int* buffer = heap.data();
+    small_vector<int, 2> stolen = std::move(heap);
+    EXPECT_EQ(stolen.data(), buffer);
+    EXPECT_TRUE(heap.empty());
+    EXPECT_TRUE(heap.is_inline());
+
+    small_vector<std::string, 2> inlined{"x"};
+    small_vector<std::string, 2> moved = std::move(inlined);
+    EXPECT_TRUE(moved.is_inline());
+    EXPECT_EQ(moved[0], "x");
+    EXPECT_TRUE(inlined.empty());
+
+    small_vector<std::string, 2> assigned{"a", "b", "c"};
+    assigned = std::move(moved);
+    EXPECT_EQ(assigned, (small_vector<std::string, 2>{"x"}));
+}
+
+TEST(SmallVectorTest, CopyResizeSwapAndLifetimes) {
+    {
+        small_vector<Tracked, 2> v;
+        v.resize(3, Tracked(1));
+        EXPECT_EQ(Tracked::alive, 3);
+        small_vector<Tracked, 2> copy = v;
+        EXPECT_EQ(Tracked::alive, 6);
+        copy.resize(1, Tracked(0));
+        EXPECT_EQ(Tracked::alive, 4);
+        copy.swap(v);
+        EXPECT_EQ(copy.size(), 3u);
+        EXPECT_EQ(v.size(), 1u);
+        v = copy;
+        EXPECT_EQ(Tracked::alive, 6);
+        v.insert(v.begin() + 1, Tracked(2));
+        v.erase(v.begin());
+        EXPECT_EQ(v[0].value, 2);
+        EXPECT_EQ(Tracked::alive, 6);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+
+    small_vector<int, 4> sized(6);
+    EXPECT_EQ(sized.size(), 6u);
+    for (int value : sized) EXPECT_EQ(value, 0);
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "multithreading/spinlock/spinlock.h"
+#include "multithreading/adaptive_mutex.h"
+#include "multithreading/spinlock/cohort_lock.h"
+#include "multithreading/numa.h"
 #include <thread>
 #include <vector>
 
@@ -30,3 +33,93 @@ TEST(SpinLockTest, MultiThreadedIncrement) {
     for (auto& t : threads) t.join();
     EXPECT_EQ(counter, numThreads * incrementsPerThread);
 }
+
+// FIFO locks hand off to one specific waiter, which is slow when threads outnumber
+// cores (and under TSan), so keep the counts modest
+template <typename Lock>
+void MultiThreadedIncrementTest() {
+    Lock lock;
+    int counter = 0;
+    const int numThreads = 4;
+    const int incrementsPerThread = 5000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < incrementsPerThread; ++j) {
+                lock.lock();
+                ++counter;
+                lock.unlock();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(counter, numThreads * incrementsPerThread);
+}
+
+TEST(SpinLockTest, TicketMultiThreadedIncrement) { MultiThreadedIncrementTest<TicketSpinLock>(); }
+TEST(SpinLockTest, MCSMultiThreadedIncrement) { MultiThreadedIncrementTest<MCSSpinLock>(); }
+TEST(SpinLockTest, CLHMultiThreadedIncrement) { MultiThreadedIncrementTest<CLHSpinLock>(); }
+
+TEST(SpinLockTest, TicketTryLock) {
+    TicketSpinLock lock;
+    EXPECT_TRUE(lock.try_lock());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock();
+    EXPECT_TRUE(lock.try_lock());
+    lock.unlock();
+}
+
+TEST(SpinLockTest, MCSNestedAndExplicitNodes) {
+    MCSSpinLock a, b;
+    MCSSpinLock::Node node;
+    a.lock();
+    b.lock(node);
+    EXPECT_FALSE(a.try_lock());
+    // Non-LIFO release order must not corrupt the thread's node cache
+    a.unlock();
+    EXPECT_TRUE(a.try_lock());
+    a.unlock();
+    b.unlock(node);
+}
+
+TEST(SpinLockTest, AdaptiveMutexMultiThreadedIncrement) { MultiThreadedIncrementTest<AdaptiveMutex>(); }
+
+TEST(SpinLockTest, AdaptiveMutexTryLock) {
+    AdaptiveMutex mx;
+    EXPECT_TRUE(mx.try_lock());
+    EXPECT_FALSE(mx.try_lock());
+    mx.unlock();
+    EXPECT_TRUE(mx.try_lock());
+    mx.unlock();
+}
+
+// The named variants are aliases of SpinLock; every one of them must actually exclude
+TEST(SpinLockTest, BasicAtomicBoolMultiThreadedIncrement) { MultiThreadedIncrementTest<BasicSpinLockWithAtomicBool>(); }
+TEST(SpinLockTest, AtomicBoolWithoutFalseSharingMultiThreadedIncrement) { MultiThreadedIncrementTest<SpinLockWithAtomicBoolWithoutFalseSharing>(); }
+TEST(SpinLockTest, OptimizedLoadsMultiThreadedIncrement) { MultiThreadedIncrementTest<SpinLockWithOptimizedLoadsAndThreadYielding>(); }
+TEST(SpinLockTest, OptimizedWritesMultiThreadedIncrement) { MultiThreadedIncrementTest<SpinLockWithOptimizedWritesAndThreadYielding>(); }
+TEST(SpinLockTest, ExponentialBackoffMultiThreadedIncrement) { MultiThreadedIncrementTest<SpinLock<ExponentialBackoff<>>>(); }
+TEST(SpinLockTest, SpinThenYieldFlagMultiThreadedIncrement) { MultiThreadedIncrementTest<SpinLock<SpinThenYieldBackoff<64>, NoPadding, FlagTestAndSet>>(); }
+
+TEST(SpinLockTest, PolicyTryLockAndLayout) {
+    SpinLock<PauseBackoff> lock;
+    EXPECT_TRUE(lock.try_lock());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock();
+    EXPECT_EQ(sizeof(SpinLock<PauseBackoff, NoPadding>), sizeof(std::atomic<bool>));
+    EXPECT_EQ(alignof(SpinLock<PauseBackoff, CacheLinePadding>), SVR_CACHELINE_SIZE);
+}
+
+TEST(SpinLockTest, CohortMultiThreadedIncrement) { MultiThreadedIncrementTest<CohortLock<>>(); }
+TEST(SpinLockTest, CohortWithoutLocalPassing) { MultiThreadedIncrementTest<CohortLock<0>>(); }
+
+TEST(SpinLockTest, NumaTopologyCoversCurrentCpu) {
+    const NumaTopology& topology = NumaTopology::instance();
+    ASSERT_GE(topology.numNodes(), 1u);
+    EXPECT_LT(topology.node(), topology.numNodes());
+    for (size_t node = 0; node < topology.numNodes(); ++node) {
+        for (unsigned cpu : topology.cpusOfNode(node)) {
+            EXPECT_EQ(topology.nodeOfCpu(cpu), node);
+        }
+    }
+}
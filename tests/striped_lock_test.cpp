@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include "multithreading/spinlock/striped_lock.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace svr;
+
+TEST(StripedLockTest, KeysMapToStableStripes) {
+    StripedLock<SpinLock<>, 16> locks;
+    EXPECT_EQ(&locks.lock_for(7), &locks.lock_for(7));
+    EXPECT_EQ(&locks.lock_for(std::string("key")), &locks.stripe(locks.stripe_of(std::string("key"))));
+    // Sequential keys spread over the stripes instead of landing on a few
+    std::vector<int> hits(locks.stripes(), 0);
+    for (size_t key = 0; key < 1600; ++key) ++hits[locks.stripe_of(key)];
+    for (int h : hits) EXPECT_GT(h, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&locks.stripe(1)) - reinterpret_cast<uintptr_t>(&locks.stripe(0)), SVR_CACHELINE_SIZE);
+}
+
+TEST(StripedLockTest, StripesProtectTheirKeys) {
+    StripedLock<MCSSpinLock, 8> locks;
+    const int numThreads = 4;
+    const int iterations = 5000;
+    const size_t numKeys = 32;
+    std::vector<int> values(numKeys, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < iterations; ++j) {
+                size_t key = (i + j) % numKeys;
+                locks.lock(key);
+                ++values[key];
+                locks.unlock(key);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    locks.lock_all();
+    int total = 0;
+    for (int v : values) total += v;
+    locks.unlock_all();
+    EXPECT_EQ(total, numThreads * iterations);
+}
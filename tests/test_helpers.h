@@ -0,0 +1,31 @@
+#ifndef SVR_TEST_HELPERS
+#define SVR_TEST_HELPERS
+
+#include <atomic>
+
+/**
+ Fixtures shared by the tests.
+
+ a) Tracked<Tag> counts its live instances in alive, copies and moves included, so a test can
+ check that a smart pointer or container destroyed exactly what it built. Each Tag has its own
+ count: a test file uses a tag of its own (Tracked<struct ObjectPoolTag>), and a type with more
+ members derives from Tracked<itself>. The count is atomic for the multithreaded tests
+ */
+namespace svr::test
+{
+    template<typename Tag>
+    struct Tracked
+    {
+        static inline std::atomic<int> alive{0};
+        long value;
+
+        explicit Tracked(long v) : value(v) { ++alive; }
+        Tracked(const Tracked& other) : value(other.value) { ++alive; }
+        Tracked(Tracked&& other) noexcept : value(other.value) { ++alive; }
+        Tracked& operator=(const Tracked&) = default;
+        Tracked& operator=(Tracked&&) noexcept = default;
+        ~Tracked() { --alive; }
+    };
+}
+
+#endif
@@ -0,0 +1,139 @@
+#include "templates/tuple.h"
+#include <gtest/gtest.h>
+#include <array>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+using namespace svr;
+
+namespace {
+struct Empty {};
+struct AlsoEmpty {};
+
+struct Counted {
+    static inline int copies = 0;
+    static inline int moves = 0;
+    Counted() = default;
+    Counted(const Counted&) { ++copies; }
+    Counted(Counted&&) noexcept { ++moves; }
+};
+}
+
+static_assert(sizeof(tuple<Empty, int>) == sizeof(int));
+static_assert(sizeof(tuple<int, Empty, AlsoEmpty>) == sizeof(int));
+static_assert(sizeof(tuple<char, int, char>) == sizeof(std::tuple<char, int, char>));
+static_assert(std::is_empty_v<tuple<>>);
+static_assert(std::is_trivially_copyable_v<tuple<int, double, Empty>>);
+static_assert(std::is_same_v<std::tuple_element_t<1, tuple<int, std::string>>, std::string>);
+static_assert(std::tuple_size_v<tuple<int, char, long>> == 3);
+static_assert(!std::is_copy_constructible_v<tuple<std::unique_ptr<int>>>);
+static_assert(!std::is_convertible_v<int*, tuple<std::unique_ptr<int>>>);
+static_assert(get<1>(tuple<int, long>(1, 2L)) == 2L);
+static_assert([]() {
+    tuple<int, int> t(1, 2);
+    get<0>(t) = 5;
+    return get<0>(t) + get<1>(t);
+}() == 7);
+
+TEST(TupleTest, ConstructAndGet) {
+    tuple<int, std::string, double> t(1, "two", 3.0);
+    EXPECT_EQ(get<0>(t), 1);
+    EXPECT_EQ(get<1>(t), "two");
+    EXPECT_EQ(get<double>(t), 3.0);
+    get<int>(t) = 4;
+    EXPECT_EQ(get<0>(t), 4);
+    const auto& c = t;
+    EXPECT_EQ(get<std::string>(c), "two");
+    tuple<int, long> d;
+    EXPECT_EQ(get<0>(d), 0);
+    EXPECT_EQ(get<1>(d), 0);
+}
+
+TEST(TupleTest, ForwardsInsteadOfCopying) {
+    Counted::copies = Counted::moves = 0;
+    tuple<Counted, int> t(Counted{}, 1);
+    EXPECT_EQ(Counted::copies, 0);
+    EXPECT_EQ(Counted::moves, 1);
+    tuple<Counted, int> moved = std::move(t);
+    EXPECT_EQ(Counted::copies, 0);
+    EXPECT_EQ(Counted::moves, 2);
+    EXPECT_EQ(get<1>(moved), 1);
+    Counted lvalue;
+    tuple<Counted> copied(lvalue);
+    EXPECT_EQ(Counted::copies, 1);
+}
+
+TEST(TupleTest, HoldsMoveOnlyTypes) {
+    tuple<std::unique_ptr<int>, std::string> t(std::make_unique<int>(5), "x");
+    tuple<std::unique_ptr<int>, std::string> u = std::move(t);
+    EXPECT_EQ(get<0>(t), nullptr);
+    EXPECT_EQ(*get<0>(u), 5);
+    std::unique_ptr<int> taken = get<0>(std::move(u));
+    EXPECT_EQ(*taken, 5);
+    auto made = svr::make_tuple(std::make_unique<int>(6), 1);
+    static_assert(std::is_same_v<decltype(made), tuple<std::unique_ptr<int>, int>>);
+    EXPECT_EQ(*get<0>(made), 6);
+}
+
+TEST(TupleTest, ConvertingConstructionAndAssignment) {
+    tuple<int, const char*> narrow(1, "abc");
+    tuple<long, std::string> wide = narrow;
+    EXPECT_EQ(get<0>(wide), 1L);
+    EXPECT_EQ(get<1>(wide), "abc");
+    wide = tuple<int, const char*>(2, "de");
+    EXPECT_EQ(get<0>(wide), 2L);
+    EXPECT_EQ(get<1>(wide), "de");
+}
+
+TEST(TupleTest, TieAndForwardAsTuple) {
+    int a = 0;
+    std::string b;
+    svr::tie(a, b) = svr::make_tuple(3, std::string("three"));
+    EXPECT_EQ(a, 3);
+    EXPECT_EQ(b, "three");
+    int c = 7;
+    std::string d = "seven";
+    svr::tie(a, b) = svr::tie(c, d);
+    EXPECT_EQ(a, 7);
+    EXPECT_EQ(b, "seven");
+    svr::tie(a, ignore) = svr::make_tuple(9, 1.5);
+    EXPECT_EQ(a, 9);
+    auto refs = svr::forward_as_tuple(a, std::move(d));
+    static_assert(std::is_same_v<decltype(refs), tuple<int&, std::string&&>>);
+    std::string stolen = get<1>(std::move(refs));
+    EXPECT_EQ(stolen, "seven");
+}
+
+TEST(TupleTest, ApplyAndStructuredBindings) {
+    tuple<int, int, int> t(1, 2, 3);
+    EXPECT_EQ(svr::apply([](int x, int y, int z) { return x * 100 + y * 10 + z; }, t), 123);
+    auto [x, y, z] = t;
+    EXPECT_EQ(x + y + z, 6);
+    auto& [rx, ry, rz] = t;
+    rx = 10;
+    EXPECT_EQ(get<0>(t), 10);
+    std::unique_ptr<int> owned = svr::apply([](std::unique_ptr<int>&& p) { return std::move(p); },
+                                       tuple<std::unique_ptr<int>>(std::make_unique<int>(4)));
+    EXPECT_EQ(*owned, 4);
+    EXPECT_EQ(svr::apply([](int a, char b) { return a + b; }, std::pair<int, char>(1, 'a')), 1 + 'a');
+    EXPECT_EQ(svr::apply([](auto... v) { return (v + ...); }, std::array<int, 3>{1, 2, 3}), 6);
+}
+
+TEST(TupleTest, ComparisonAndSwap) {
+    tuple<int, std::string> a(1, "b");
+    tuple<int, std::string> b(1, "c");
+    tuple<int, std::string> c(2, "a");
+    EXPECT_TRUE(a == a);
+    EXPECT_TRUE(a != b);
+    EXPECT_TRUE(a < b);
+    EXPECT_TRUE(b < c);
+    EXPECT_FALSE(c < a);
+    EXPECT_TRUE(c >= a);
+    EXPECT_TRUE(a <= a);
+    swap(a, c);
+    EXPECT_EQ(get<0>(a), 2);
+    EXPECT_EQ(get<1>(c), "b");
+}
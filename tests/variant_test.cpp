@@ -0,0 +1,189 @@
+#include "templates/variant.h"
+#include "templates/overloads.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "test_helpers.h"
+
+using namespace svr;
+
+namespace {
+using Tracked = test::Tracked<struct VariantTag>;
+
+struct ThrowsOnCopy {
+    ThrowsOnCopy() = default;
+    ThrowsOnCopy(const ThrowsOnCopy&) { throw std::runtime_error("copy"); }
+    ThrowsOnCopy(ThrowsOnCopy&&) noexcept = default;
+    ThrowsOnCopy& operator=(ThrowsOnCopy&&) = default;
+    ThrowsOnCopy& operator=(const ThrowsOnCopy&) = default;
+};
+
+struct Ping { int seq; };
+struct Order { int qty; double price; };
+struct Cancel { int id; };
+}
+
+static_assert(sizeof(variant<char, int>) == 8);
+static_assert(sizeof(variant<char>) == 2);
+static_assert(std::is_trivially_copyable_v<variant<int, double, Ping, Order>>);
+static_assert(std::is_trivially_destructible_v<variant<int, double>>);
+static_assert(!std::is_trivially_copyable_v<variant<int, std::string>>);
+static_assert(!std::is_trivially_destructible_v<variant<int, std::string>>);
+static_assert(!std::is_copy_constructible_v<variant<int, std::unique_ptr<int>>>);
+static_assert(std::is_nothrow_move_constructible_v<variant<int, std::unique_ptr<int>>>);
+static_assert(!std::is_default_constructible_v<variant<Tracked>>);
+static_assert(std::is_same_v<variant_alternative_t<1, variant<int, Ping>>, Ping>);
+static_assert(variant_size_v<const variant<int, Ping, Order>> == 3);
+
+TEST(VariantTest, DefaultConstructsFirstAlternative) {
+    variant<int, std::string> v;
+    EXPECT_EQ(v.index(), 0u);
+    EXPECT_EQ(get<0>(v), 0);
+    variant<monostate, Tracked> m;
+    EXPECT_TRUE(holds_alternative<monostate>(m));
+}
+
+TEST(VariantTest, ConvertingConstructionPicksBestAlternative) {
+    variant<int, std::string> a = 5;
+    variant<int, std::string> b = "text";
+    EXPECT_EQ(a.index(), 0u);
+    EXPECT_EQ(get<std::string>(b), "text");
+    // int -> float narrows, so long is picked
+    variant<float, long> c = 3;
+    EXPECT_EQ(c.index(), 1u);
+    // A pointer does not silently become a bool
+    variant<std::string, bool> d = "yes";
+    EXPECT_EQ(d.index(), 0u);
+}
+
+TEST(VariantTest, InPlaceAndEmplace) {
+    variant<int, std::string, int> v(std::in_place_index<2>, 7);
+    EXPECT_EQ(v.index(), 2u);
+    EXPECT_EQ(get<2>(v), 7);
+    v.emplace<std::string>(3, 'x');
+    EXPECT_EQ(get<1>(v), "xxx");
+    variant<int, std::string> w(std::in_place_type<std::string>, "abc");
+    EXPECT_EQ(get<std::string>(w), "abc");
+}
+
+TEST(VariantTest, GetThrowsAndGetIfReturnsNull) {
+    variant<int, std::string> v = 1;
+    EXPECT_THROW(get<std::string>(v), bad_variant_access);
+    EXPECT_EQ(get_if<std::string>(&v), nullptr);
+    ASSERT_NE(get_if<int>(&v), nullptr);
+    EXPECT_EQ(*get_if<0>(&v), 1);
+    EXPECT_EQ(get_if<0>(static_cast<variant<int, std::string>*>(nullptr)), nullptr);
+}
+
+TEST(VariantTest, CopyMoveAndAssignDestroyCorrectly) {
+    {
+        variant<int, Tracked> a(std::in_place_type<Tracked>, 4);
+        variant<int, Tracked> b = a;
+        EXPECT_EQ(Tracked::alive, 2);
+        EXPECT_EQ(get<Tracked>(b).value, 4);
+        b = 3;
+        EXPECT_EQ(Tracked::alive, 1);
+        b = a;
+        EXPECT_EQ(Tracked::alive, 2);
+        a = 9;
+        variant<int, Tracked> c = std::move(b);
+        EXPECT_EQ(get<Tracked>(c).value, 4);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+
+    variant<int, std::unique_ptr<int>> p = std::make_unique<int>(8);
+    variant<int, std::unique_ptr<int>> q = std::move(p);
+    EXPECT_EQ(*get<1>(q), 8);
+    p = std::move(q);
+    EXPECT_EQ(*get<1>(p), 8);
+}
+
+TEST(VariantTest, ThrowingAlternativeSwitchKeepsValueOrBecomesValueless) {
+    variant<int, ThrowsOnCopy> v = 5;
+    ThrowsOnCopy source;
+    // Copy may throw but the move cannot, so the copy is made before 5 is destroyed
+    EXPECT_THROW(v = source, std::runtime_error);
+    EXPECT_EQ(get<int>(v), 5);
+    EXPECT_THROW(v.emplace<ThrowsOnCopy>(source), std::runtime_error);
+    EXPECT_TRUE(v.valueless_by_exception());
+    EXPECT_EQ(v.index(), variant_npos);
+    EXPECT_THROW(visit([](auto&&) {}, v), bad_variant_access);
+    v = 2;
+    EXPECT_EQ(get<int>(v), 2);
+}
+
+TEST(VariantTest, VisitWithOverloads) {
+    using Message = variant<Ping, Order, Cancel>;
+    auto handler = overloads{
+        [](const Ping& p) { return p.seq; },
+        [](const Order& o) { return static_cast<int>(o.qty * o.price); },
+        [](const Cancel& c) { return -c.id; },
+    };
+    Message messages[] = {Ping{1}, Order{3, 2.0}, Cancel{4}};
+    int results[3];
+    for (int i = 0; i < 3; ++i) {
+        results[i] = visit(handler, messages[i]);
+    }
+    EXPECT_EQ(results[0], 1);
+    EXPECT_EQ(results[1], 6);
+    EXPECT_EQ(results[2], -4);
+}
+
+TEST(VariantTest, VisitForwardsValueCategory) {
+    variant<int, std::string> v = std::string("moved");
+    std::string out = visit(overloads{[](int) { return std::string(); }, [](std::string&& s) { return std::move(s); }}, std::move(v));
+    EXPECT_EQ(out, "moved");
+    variant<int, long> n = 4;
+    visit([](auto& x) { x *= 2; }, n);
+    EXPECT_EQ(get<int>(n), 8);
+}
+
+TEST(VariantTest, VisitSeveralVariants) {
+    variant<int, double, std::string> a = 2.5;
+    variant<char, std::string> b = std::string("xy");
+    auto describe = overloads{
+        [](const std::string& s, const std::string& t) { return s + t; },
+        [](const auto& x, char c) { return std::to_string(sizeof(x)) + c; },
+        [](const auto& x, const std::string& t) { return std::to_string(sizeof(x)) + t; },
+    };
+    EXPECT_EQ(visit(describe, a, b), "8xy");
+    a = std::string("ab");
+    EXPECT_EQ(visit(describe, a, b), "abxy");
+    b = 'c';
+    a = 1;
+    EXPECT_EQ(visit(describe, a, b), "4c");
+    variant<int, long> c = 3L;
+    EXPECT_EQ(visit([](auto x, auto y, auto z) { return sizeof(x) + sizeof(y) + sizeof(z); }, c, c, c), 3 * sizeof(long));
+}
+
+TEST(VariantTest, VisitBeyondSwitchLimitUsesTable) {
+    // 3 x 4 = 12 combinations, more than the switch handles
+    variant<char, short, int> a = short(2);
+    variant<char, short, int, long> b = 5L;
+    auto sum = [](auto x, auto y) { return static_cast<long>(x) * 10 + static_cast<long>(y) + static_cast<long>(sizeof(x)) * 100; };
+    EXPECT_EQ(visit(sum, a, b), 225);
+    a = char(1);
+    b = 'b';
+    EXPECT_EQ(visit(sum, a, b), 100 + 10 + 'b');
+    variant<int, int, int, int, int, int, int, int, int, std::string> wide(std::in_place_index<9>, "nine");
+    EXPECT_EQ(visit([](const auto& x) { return sizeof(x); }, wide), sizeof(std::string));
+}
+
+TEST(VariantTest, ComparisonAndSwap) {
+    variant<int, std::string> a = 1;
+    variant<int, std::string> b = 2;
+    variant<int, std::string> s = std::string("a");
+    EXPECT_TRUE(a == a);
+    EXPECT_TRUE(a != b);
+    EXPECT_TRUE(a < b);
+    EXPECT_TRUE(b < s);
+    EXPECT_TRUE(s >= b);
+    swap(a, s);
+    EXPECT_EQ(get<std::string>(a), "a");
+    EXPECT_EQ(get<int>(s), 1);
+    swap(b, s);
+    EXPECT_EQ(get<int>(b), 1);
+    EXPECT_EQ(get<int>(s), 2);
+}